@@ -42,13 +42,30 @@ struct BinaryIOErrorTracker
 
 class BinaryIO
 {
+  private:
+    //disallow copy and assign
+    BinaryIO(const BinaryIO& other) = delete;
+    BinaryIO& operator=(const BinaryIO& other) = delete;
+
   public:
-    BinaryIO(std::shared_ptr<FileLike> f, Endianness target_endianness) :
+    /**
+     @param buffer_writes collect all writes in memory and hand them to f in a single write
+            on flush(), e.g. to assemble a whole tile. Reads only see flushed data.
+     */
+    BinaryIO(std::shared_ptr<FileLike> f,
+             Endianness target_endianness,
+             bool buffer_writes = false) :
         m_f(f),
-        m_target_endianness(target_endianness)
+        m_target_endianness(target_endianness),
+        m_buffer_writes(buffer_writes)
     {
     }
 
+    /**
+     flushes pending buffered writes, errors are lost, call flush() to check for them
+     */
+    ~BinaryIO();
+
     File::position_type read_pos() const noexcept { return m_read_pos; }
     File::position_type write_pos() const noexcept { return m_write_pos; }
 
@@ -61,6 +78,12 @@ class BinaryIO
     void read_int16(int16_t& o, BinaryIOErrorTracker& e) { read_impl(&o, 2, 1, "int16_t", e); }
     void read_uint32(uint32_t& o, BinaryIOErrorTracker& e) { read_impl(&o, 4, 1, "uint32_t", e); }
     void read_int32(int32_t& o, BinaryIOErrorTracker& e) { read_impl(&o, 4, 1, "int32_t", e); }
+    void read_array_uint8(std::vector<uint8_t>& o, size_t count, BinaryIOErrorTracker& e)
+    {
+        o.resize(count);
+        const auto new_count = read_impl(o.data(), 1, count, "uint8_t[]", e);
+        o.resize(new_count);
+    }
     void read_array_uint16(std::vector<uint16_t>& o, size_t count, BinaryIOErrorTracker& e)
     {
         o.resize(count);
@@ -111,6 +134,10 @@ class BinaryIO
     {
         write_impl(&v, 4, 1, "int32_t", e);
     }
+    void write_array_uint8(const std::vector<uint8_t>& v, BinaryIOErrorTracker& e)
+    {
+        write_impl(v.data(), 1, v.size(), "uint8_t[]", e);
+    }
     void write_array_uint16(const std::vector<uint16_t>& v, BinaryIOErrorTracker& e)
     {
         write_impl(v.data(), 2, v.size(), "uint16_t[]", e);
@@ -139,6 +166,16 @@ class BinaryIO
     template<typename T>
     void write_array(const std::vector<T>& v, BinaryIOErrorTracker& e);
 
+    /**
+     pre-allocates the write buffer for the expected number of bytes
+     */
+    void reserve_write_buffer(size_t bytes) { m_write_buffer.reserve(bytes); }
+
+    /**
+     writes buffered data to the underlying file, a no-op for unbuffered writes
+     */
+    void flush(BinaryIOErrorTracker& e);
+
   private:
     //returns successfully read element count
     size_t read_impl(void* const dest,
@@ -152,10 +189,20 @@ class BinaryIO
                     const char* const elem_type,
                     BinaryIOErrorTracker& e);
 
+    void record_write_error(File::position_type where,
+                            size_t expected_bytes,
+                            const char* const elem_type,
+                            BinaryIOErrorTracker& e);
+
     const std::shared_ptr<FileLike> m_f;
     const Endianness m_target_endianness;
+    const bool m_buffer_writes;
     File::position_type m_read_pos = 0;
     File::position_type m_write_pos = 0;
+
+    //holds the bytes from m_write_buffer_pos up to m_write_pos
+    std::vector<unsigned char> m_write_buffer;
+    File::position_type m_write_buffer_pos = 0;
 };
 
 template<>
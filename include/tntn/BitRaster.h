@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tntn {
+
+/**
+ raster of flags with one bit per pixel, every row starts at a new 64 bit word
+ */
+class BitRaster
+{
+  public:
+    void allocate(const unsigned int w, const unsigned int h)
+    {
+        m_width = w;
+        m_height = h;
+        m_words_per_row = (w + 63) / 64;
+        m_words.assign(static_cast<size_t>(m_words_per_row) * h, 0);
+    }
+
+    void clear()
+    {
+        m_width = 0;
+        m_height = 0;
+        m_words_per_row = 0;
+        std::vector<uint64_t>().swap(m_words);
+    }
+
+    void set_all(const bool value)
+    {
+        std::fill(m_words.begin(), m_words.end(), value ? ~0ull : 0);
+    }
+
+    unsigned int get_width() const { return m_width; }
+    unsigned int get_height() const { return m_height; }
+
+    bool value(const unsigned int r, const unsigned int c) const
+    {
+        return (get_ptr(r)[c / 64] >> (c % 64)) & 1;
+    }
+
+    void set(const unsigned int r, const unsigned int c)
+    {
+        m_words[static_cast<size_t>(r) * m_words_per_row + c / 64] |= uint64_t(1) << (c % 64);
+    }
+
+    void unset(const unsigned int r, const unsigned int c)
+    {
+        m_words[static_cast<size_t>(r) * m_words_per_row + c / 64] &= ~(uint64_t(1) << (c % 64));
+    }
+
+    /**
+     words of row r, bit c % 64 of word c / 64 belongs to column c
+     */
+    const uint64_t* get_ptr(const unsigned int r) const
+    {
+        return m_words.data() + static_cast<size_t>(r) * m_words_per_row;
+    }
+
+  private:
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    unsigned int m_words_per_row = 0;
+    std::vector<uint64_t> m_words;
+};
+
+} // namespace tntn
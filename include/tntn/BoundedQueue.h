@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "tntn/tntn_assert.h"
+
+namespace tntn {
+
+struct BoundedQueueStats
+{
+    size_t capacity = 0;
+    size_t items = 0; //total number of items pushed
+    size_t max_depth = 0;
+    double mean_depth = 0; //queue depth right after a push, averaged over all pushes
+    double push_stall_seconds = 0; //time producers spent waiting for a full queue
+    double pop_stall_seconds = 0; //time consumers spent waiting for an empty queue
+};
+
+/**
+ multi producer / multi consumer FIFO queue holding at most capacity items
+
+ push blocks while the queue is full and pop blocks while it is empty,
+ so a slow consumer throttles its producers instead of letting the queue grow.
+ */
+template<typename T>
+class BoundedQueue
+{
+  private:
+    //disallow copy and assign
+    BoundedQueue(const BoundedQueue& other) = delete;
+    BoundedQueue& operator=(const BoundedQueue& other) = delete;
+
+    typedef std::chrono::steady_clock clock;
+
+  public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(std::max<size_t>(capacity, 1)) {}
+
+    /**
+     @return false if the queue was closed, item is dropped in that case
+     */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(!m_closed && m_items.size() >= m_capacity)
+        {
+            const auto t0 = clock::now();
+            m_not_full.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+            m_push_stall += clock::now() - t0;
+        }
+        if(m_closed)
+        {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        m_num_pushed++;
+        m_depth_sum += m_items.size();
+        m_max_depth = std::max(m_max_depth, m_items.size());
+
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     @return false once the queue is closed and all remaining items have been taken
+     */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(!m_closed && m_items.empty())
+        {
+            const auto t0 = clock::now();
+            m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+            m_pop_stall += clock::now() - t0;
+        }
+        if(m_items.empty())
+        {
+            TNTN_ASSERT(m_closed);
+            return false;
+        }
+
+        item = std::move(m_items.front());
+        m_items.pop_front();
+
+        lock.unlock();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    /**
+     signal that no more items will be pushed, wakes up all waiting threads
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+    BoundedQueueStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        BoundedQueueStats s;
+        s.capacity = m_capacity;
+        s.items = m_num_pushed;
+        s.max_depth = m_max_depth;
+        s.mean_depth = m_num_pushed > 0 ? static_cast<double>(m_depth_sum) / m_num_pushed : 0.0;
+        s.push_stall_seconds = m_push_stall.count();
+        s.pop_stall_seconds = m_pop_stall.count();
+        return s;
+    }
+
+  private:
+    const size_t m_capacity;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+    std::deque<T> m_items;
+    bool m_closed = false;
+
+    size_t m_num_pushed = 0;
+    size_t m_depth_sum = 0;
+    size_t m_max_depth = 0;
+    std::chrono::duration<double> m_push_stall{0};
+    std::chrono::duration<double> m_pop_stall{0};
+};
+
+} //namespace tntn
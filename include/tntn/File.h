@@ -61,6 +61,12 @@ class FileLike
 
     virtual void flush() = 0;
 
+    /**
+     direct access to all size() bytes for implementations keeping them in memory,
+     nullptr otherwise. the pointer is invalidated by writes.
+     */
+    virtual const unsigned char* data() { return nullptr; }
+
     //convenience wrappers:
 
     size_t read(position_type from_offset, char* buffer, size_t size_of_buffer)
@@ -160,11 +166,53 @@ class MemoryFile : public FileLike
 
     void flush() override {}
 
+    const unsigned char* data() override { return m_data.data(); }
+
   private:
     std::vector<unsigned char> m_data;
     bool m_is_good = true;
 };
 
+/**
+ read-only file mapped into memory, data() gives access to its bytes without copying them
+ */
+class MappedFile : public FileLike
+{
+  public:
+    bool open(const char* filename);
+    bool open(const std::string& filename);
+
+    bool close();
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    std::string name() const override { return m_filename; }
+
+    bool is_good() override { return m_is_good; }
+    position_type size() override { return m_size; }
+
+    size_t read(position_type from_offset, unsigned char* buffer, size_t size_of_buffer) override;
+    using FileLike::read; //import convenience overloads
+
+    /**
+     always fails, the mapping is read-only
+     */
+    bool write(position_type to_offset, const unsigned char* data, size_t data_size) override;
+    using FileLike::write; //import convenience overloads
+
+    void flush() override {}
+
+    const unsigned char* data() override { return m_data; }
+
+  private:
+    void* m_mapping = nullptr;
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_is_good = false;
+    std::string m_filename;
+};
+
 FileLike::position_type getline(FileLike::position_type from_offset,
                                 FileLike& f,
                                 std::string& str);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+
+namespace tntn {
+
+/**
+ closed form transformation from web mercator (EPSG:3857, z is the height above the
+ WGS84 ellipsoid) to earth centered, earth fixed coordinates (EPSG:4978)
+
+ gives the same result as an OGRCoordinateTransformation between the two EPSG codes,
+ without any per call setup
+ */
+class MercatorToEcef
+{
+  public:
+    static glm::dvec3 transform(const glm::dvec3& p);
+
+    /**
+     transforms count points in place
+     */
+    static void transform(glm::dvec3* points, size_t count);
+};
+
+} //namespace tntn
@@ -46,8 +46,20 @@ class Mesh
     SimpleRange<const Vertex*> vertices() const;
 
     void grab_triangles(std::vector<Triangle>& into);
+    /**
+     takes vertices and faces out of the mesh, vertex normals are dropped,
+     use grab_normals before to keep them
+     */
     void grab_decomposed(std::vector<Vertex>& vertices, std::vector<Face>& faces);
 
+    /**
+     optional per vertex normals of the decomposed mesh, in the order of vertices()
+     */
+    void set_normals(std::vector<Normal>&& normals);
+    bool has_normals() const { return !m_normals.empty() && m_normals.size() == m_vertices.size(); }
+    SimpleRange<const Normal*> normals() const;
+    void grab_normals(std::vector<Normal>& normals);
+
     bool compose_triangle(const Face& f, Triangle& out) const;
 
     /**
@@ -69,6 +81,7 @@ class Mesh
 
     std::vector<Vertex> m_vertices;
     std::vector<Face> m_faces;
+    std::vector<Normal> m_normals;
     std::vector<Triangle> m_triangles;
 
     void decompose_triangle(const Triangle& t);
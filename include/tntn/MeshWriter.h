@@ -2,6 +2,10 @@
 
 #include "tntn/geometrix.h"
 #include "tntn/Mesh.h"
+#include "tntn/File.h"
+
+#include <memory>
+#include <string>
 
 namespace tntn {
 
@@ -9,7 +13,15 @@ class MeshWriter
 {
   public:
     virtual bool write_mesh_to_file(const char* filename, Mesh& mesh, const BBox3D& bbox) = 0;
+    /**
+     encode mesh into f, e.g. a MemoryFile to write the result out later
+     */
+    virtual bool write_mesh(const std::shared_ptr<FileLike>& f, Mesh& mesh, const BBox3D& bbox) = 0;
     virtual std::string file_extension() = 0;
+    /**
+     whether meshes passed to the writer should carry vertex normals
+     */
+    virtual bool wants_vertex_normals() { return false; }
     virtual ~MeshWriter(){};
 };
 
@@ -18,6 +30,9 @@ class ObjMeshWriter : public MeshWriter
     virtual bool write_mesh_to_file(const char* filename,
                                     Mesh& mesh,
                                     const BBox3D& bbox) override;
+    virtual bool write_mesh(const std::shared_ptr<FileLike>& f,
+                            Mesh& mesh,
+                            const BBox3D& bbox) override;
 
     virtual std::string file_extension() override;
     virtual ~ObjMeshWriter(){};
@@ -25,11 +40,38 @@ class ObjMeshWriter : public MeshWriter
 
 class QuantizedMeshWriter : public MeshWriter
 {
+  public:
+    /**
+     optimize_triangle_order reorders faces and vertices for post-transform vertex cache
+     reuse before encoding, see optimize_mesh_for_vertex_cache.
+     gzip_level > 0 compresses each tile in memory with that level before it is written,
+     for serving with Content-Encoding: gzip.
+     vertex_normals requests meshes with normals, which are written as the
+     octvertexnormals extension.
+     */
+    explicit QuantizedMeshWriter(bool optimize_triangle_order = false,
+                                 int gzip_level = 0,
+                                 bool vertex_normals = false) :
+        m_optimize_triangle_order(optimize_triangle_order),
+        m_gzip_level(gzip_level),
+        m_vertex_normals(vertex_normals)
+    {
+    }
+
     virtual bool write_mesh_to_file(const char* filename,
                                     Mesh& mesh,
                                     const BBox3D& bbox) override;
+    virtual bool write_mesh(const std::shared_ptr<FileLike>& f,
+                            Mesh& mesh,
+                            const BBox3D& bbox) override;
     virtual std::string file_extension() override;
+    virtual bool wants_vertex_normals() override { return m_vertex_normals; }
     virtual ~QuantizedMeshWriter(){};
+
+  private:
+    const bool m_optimize_triangle_order;
+    const int m_gzip_level;
+    const bool m_vertex_normals;
 };
 
 } // namespace tntn
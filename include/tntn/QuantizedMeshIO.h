@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
@@ -14,6 +15,32 @@ namespace detail {
 uint16_t zig_zag_encode(int16_t i);
 int16_t zig_zag_decode(uint16_t i);
 
+/**
+ bounding sphere of points, the smaller of Ritter's sphere and the sphere around the
+ center of their bounding box
+ */
+void compute_bounding_sphere(const glm::dvec3* points,
+                             size_t count,
+                             glm::dvec3& center,
+                             double& radius);
+
+/**
+ horizon occlusion point of ECEF points as defined by Cesium, in coordinates scaled by the
+ WGS84 ellipsoid radii. the point lies on the line from the earth's center through
+ direction and is below the horizon whenever all points are.
+ fails if there is no such point, e.g. if the points span a hemisphere
+ */
+bool compute_horizon_occlusion_point(const glm::dvec3* points,
+                                     size_t count,
+                                     const glm::dvec3& direction,
+                                     glm::dvec3& occlusion_point);
+
+/**
+ oct encoding of a unit normal into two bytes as used by the octvertexnormals extension
+ */
+void oct_encode(const glm::dvec3& normal, uint8_t& x, uint8_t& y);
+glm::dvec3 oct_decode(uint8_t x, uint8_t y);
+
 } //namespace detail
 
 // unsigned int zig_zag_encode(int i);
@@ -49,6 +49,13 @@ class NDVDefault<double>
     static void set(double& value) { value = std::numeric_limits<double>::max(); }
 };
 
+template<>
+class NDVDefault<float>
+{
+  public:
+    static void set(float& value) { value = std::numeric_limits<float>::max(); }
+};
+
 } // namespace detail
 
 // Terrain Raster
@@ -96,6 +103,41 @@ class Raster
         return ret;
     }
 
+    /**
+     deep copy raster with samples converted to another type
+
+     @return copy of current raster holding U samples
+    */
+    template<typename U>
+    Raster<U> convert() const
+    {
+        Raster<U> ret;
+        ret.allocate(m_width, m_height);
+        std::copy(get_ptr(), get_ptr() + m_width * m_height, ret.get_ptr());
+        ret.set_pos_x(m_xpos);
+        ret.set_pos_y(m_ypos);
+        ret.set_cell_size(m_cellsize);
+        ret.set_no_data_value(static_cast<U>(m_noDataValue));
+        return ret;
+    }
+
+    /**
+     shallow copy raster
+     the returned raster shares the pixel data with this raster,
+     so writing to the pixels of either is visible in both
+
+     @return raster referencing the data of current raster
+    */
+    Raster share() const
+    {
+        Raster ret;
+        ret.m_width = m_width;
+        ret.m_height = m_height;
+        ret.copy_parameters(*this);
+        ret.m_data = m_data;
+        return ret;
+    }
+
     /**
      constructor
      
@@ -548,6 +590,7 @@ class Raster
 };
 
 typedef Raster<double> RasterDouble;
+typedef Raster<float> RasterFloat;
 //typedef Raster<unsigned char>   RasterByte; //eg. for grey scale image
 
 } // namespace tntn
@@ -2,6 +2,8 @@
 
 #include "Raster.h"
 #include "tntn/File.h"
+#include "tntn/WindowedRaster.h"
+#include <memory>
 #include <string>
 
 namespace tntn {
@@ -16,4 +18,27 @@ bool write_raster_to_asc(FileLike& f, const RasterDouble& raster);
 bool load_raster_file(const std::string& filename,
                       RasterDouble& raster,
                       bool validate_projection = true);
+
+/**
+ loads band 1 in single precision, halving the memory of the double variant.
+ only lossless for files where is_single_precision_raster_file holds.
+ */
+bool load_raster_file(const std::string& filename,
+                      RasterFloat& raster,
+                      bool validate_projection = true);
+
+/**
+ true if the samples of band 1 are exactly representable as float
+ (8 and 16 bit integers or Float32), false for other types or if the file can't be opened
+ */
+bool is_single_precision_raster_file(const std::string& filename);
+
+/**
+ opens a raster file for windowed reading without loading it into memory
+
+ windows are read block by block following the internal block layout of the file,
+ up to cache_budget_bytes of decoded blocks are kept for reuse.
+ */
+std::unique_ptr<BlockCachedWindowedRaster> open_windowed_raster_file(
+    const std::string& filename, size_t cache_budget_bytes, bool validate_projection = true);
 } // namespace tntn
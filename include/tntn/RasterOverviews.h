@@ -1,41 +1,92 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include "tntn/Raster.h"
+#include "tntn/ThreadPool.h"
 
 namespace tntn {
 
 typedef std::unique_ptr<RasterDouble> UniqueRasterPointer;
 
-struct RasterOverview
+template<typename T>
+struct BasicRasterOverview
 {
     int zoom_level;
     double resolution;
-    UniqueRasterPointer raster;
+    // may share its pixel data with other overviews (see Raster::share), do not modify
+    std::unique_ptr<Raster<T>> raster;
 };
 
-class RasterOverviews
+typedef BasicRasterOverview<double> RasterOverview;
+typedef BasicRasterOverview<float> RasterOverviewFloat;
+
+enum class OverviewMode
+{
+    // every level is downsampled from the base raster
+    direct,
+    // every level is downsampled 2x2 from the previous one
+    cascaded
+};
+
+/**
+ overviews of a raster with T samples, available for double and float
+ */
+template<typename T>
+class BasicRasterOverviews
 {
   private:
-    UniqueRasterPointer m_base_raster;
+    std::unique_ptr<Raster<T>> m_base_raster;
+
+    OverviewMode m_mode;
+    ThreadPool* m_thread_pool;
+
+    // last level computed in cascaded mode, m_cascade_window == 1 means the base raster
+    Raster<T> m_cascade_raster;
+    Raster<uint32_t> m_cascade_weights;
+    int m_cascade_window = 1;
 
     int m_min_zoom;
     int m_max_zoom;
 
-    int m_estimated_min_zoom;
     int m_estimated_max_zoom;
     int m_current_zoom;
 
-    int guess_max_zoom_level(double resolution);
-    int guess_min_zoom_level(int max_zoom_level);
+    static int guess_max_zoom_level(double resolution);
+    static int guess_min_zoom_level(int max_zoom_level,
+                                    unsigned int raster_width,
+                                    unsigned int raster_height);
     void compute_zoom_levels();
+    Raster<T> cascaded_downsample(int window_size);
 
   public:
-    RasterOverviews(UniqueRasterPointer base_raster, int min_zoom, int max_zoom);
-    ~RasterOverviews() = default;
+    /**
+     @param thread_pool optional, used to parallelise cascaded downsampling
+     */
+    BasicRasterOverviews(std::unique_ptr<Raster<T>> base_raster,
+                         int min_zoom,
+                         int max_zoom,
+                         OverviewMode mode = OverviewMode::direct,
+                         ThreadPool* thread_pool = nullptr);
+    ~BasicRasterOverviews() = default;
 
-    bool next(RasterOverview& overview);
+    bool next(BasicRasterOverview<T>& overview);
+
+    /**
+     computes the zoom levels overviews are generated for,
+     min_zoom and max_zoom are the requested range on input (-1 for a guess) and the
+     effective range on output. native_zoom receives the zoom level matching cell_size.
+     */
+    static void compute_zoom_range(unsigned int width,
+                                   unsigned int height,
+                                   double cell_size,
+                                   int& min_zoom,
+                                   int& max_zoom,
+                                   int& native_zoom);
 };
 
+typedef BasicRasterOverviews<double> RasterOverviews;
+typedef BasicRasterOverviews<float> RasterOverviewsFloat;
+
 } // namespace tntn
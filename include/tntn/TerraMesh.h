@@ -5,21 +5,28 @@
 #include "tntn/DelaunayMesh.h"
 #include "tntn/MeshIO.h"
 #include "tntn/TerraUtils.h"
+#include "tntn/BitRaster.h"
 
 #include <memory>
+#include <vector>
 
 namespace tntn {
 namespace terra {
 
-class TerraMesh : public TerraBaseMesh
+template<typename T>
+class TerraMesh : public TerraBaseMesh<T>
 {
   private:
-    Raster<char> m_used;
-    Raster<int> m_token;
+    using TerraBaseMesh<T>::m_raster;
+    using TerraBaseMesh<T>::m_first_face;
+
+    BitRaster m_used;
 
     CandidateList m_candidates;
     double m_max_error;
-    int m_counter;
+
+    void init_greedy_insert(double max_error);
+    void insert_candidates();
 
     void scan_triangle_line(const Plane& plane,
                             int y,
@@ -30,7 +37,21 @@ class TerraMesh : public TerraBaseMesh
 
   public:
     void greedy_insert(double max_error);
+
+    /**
+     greedy insertion for one block of a larger raster. the block starts out with the given
+     points on its border, in raster columns and rows, and no other border point is inserted.
+     blocks given the same points on a shared border thus fit together along it
+     */
+    void greedy_insert(double max_error, const std::vector<glm::ivec2>& border_points);
+
     void scan_triangle(dt_ptr t) override;
+
+    /**
+     vertices and faces as convert_to_mesh has them, with vertex x and y in raster columns and
+     rows instead of coordinates
+     */
+    void decompose(std::vector<Vertex>& vertices, std::vector<Face>& faces);
     std::unique_ptr<Mesh> convert_to_mesh();
 };
 
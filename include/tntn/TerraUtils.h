@@ -6,7 +6,7 @@
 
 #include <array>
 #include <vector>
-#include <queue>
+#include <cstdint>
 #include <algorithm>
 #include <cmath>
 #include <memory>
@@ -21,7 +21,6 @@ struct Candidate
     int y = 0;
     double z = 0.0;
     double importance = -DBL_MAX;
-    int token = 0;
     dt_ptr triangle;
 
     void consider(int sx, int sy, double sz, double imp) noexcept
@@ -39,29 +38,36 @@ struct Candidate
     bool operator<(const Candidate& c) const noexcept { return (importance < c.importance); }
 };
 
+/**
+ max heap of candidates holding at most one candidate per triangle,
+ addressed by the triangle's index in its pool
+ */
 class CandidateList
 {
   public:
-    void push_back(const Candidate& candidate) { m_candidates.push(candidate); }
+    size_t size() const noexcept { return m_heap.size(); }
+    bool empty() const noexcept { return m_heap.empty(); }
 
-    size_t size() const noexcept { return m_candidates.size(); }
-    bool empty() const noexcept { return m_candidates.empty(); }
+    //add the candidate of its triangle or replace the one found by an earlier scan
+    void update(const Candidate& candidate);
 
-    //find greatest element, remove from candidate list and return
-    Candidate grab_greatest()
-    {
-        if(m_candidates.empty())
-        {
-            return Candidate();
-        }
+    //drop the candidate of triangle t if there is one
+    void remove(const dt_ptr& t);
 
-        Candidate candidate = m_candidates.top();
-        m_candidates.pop();
-        return candidate;
-    }
+    //find greatest element, remove from candidate list and return
+    Candidate grab_greatest();
 
   private:
-    std::priority_queue<Candidate> m_candidates;
+    static constexpr uint32_t not_in_heap = std::numeric_limits<uint32_t>::max();
+
+    void place(Candidate&& candidate, size_t pos);
+    void sift_up(Candidate&& candidate, size_t pos);
+    void sift_down(Candidate&& candidate, size_t pos);
+    void erase_at(size_t pos);
+
+    std::vector<Candidate> m_heap;
+    //heap position of each triangle's candidate, indexed by triangle pool index
+    std::vector<uint32_t> m_position;
 };
 
 inline void order_triangle_points(std::array<Point2D, 3>& p) noexcept
@@ -86,7 +92,8 @@ inline bool is_no_data(const double value, const double no_data_value) noexcept
     return std::isnan(value) || value == no_data_value;
 }
 
-inline void compute_plane(Plane& plane, dt_ptr t, const RasterDouble& raster)
+template<typename T>
+inline void compute_plane(Plane& plane, dt_ptr t, const Raster<T>& raster)
 {
     const glm::dvec2& p1 = t->point1();
     const glm::dvec2& p2 = t->point2();
@@ -99,16 +106,22 @@ inline void compute_plane(Plane& plane, dt_ptr t, const RasterDouble& raster)
     plane.init(v1, v2, v3);
 }
 
-//abstract base class for Terra and Zemlya
+//fills the sample at (px, py) with the average of its nearest valid samples if it has no data,
+//with 0 if there are none
+template<typename T>
+void repair_point(Raster<T>& raster, int px, int py);
+
+//abstract base class for Terra and Zemlya, T is the sample type of the raster (double or float)
+template<typename T>
 class TerraBaseMesh : protected DelaunayMesh
 {
   public:
-    TerraBaseMesh() : m_raster(std::make_unique<RasterDouble>()) {}
+    TerraBaseMesh() : m_raster(std::make_unique<Raster<T>>()) {}
 
-    void load_raster(std::unique_ptr<RasterDouble> raster);
+    void load_raster(std::unique_ptr<Raster<T>> raster);
 
   protected:
-    std::unique_ptr<RasterDouble> m_raster;
+    std::unique_ptr<Raster<T>> m_raster;
 
     void repair_point(int px, int py);
 };
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tntn {
+
+/**
+ fixed size pool of worker threads
+
+ a pool created for a single thread does not start any workers,
+ all work then runs on the calling thread in submission order.
+ */
+class ThreadPool
+{
+  private:
+    //disallow copy and assign
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  public:
+    /**
+     @param num_threads total number of threads doing work, including the calling thread.
+                        values < 1 select the number of hardware threads.
+     */
+    explicit ThreadPool(int num_threads = 1);
+    ~ThreadPool();
+
+    int num_threads() const noexcept { return m_num_threads; }
+
+    /**
+     @return number of concurrent threads supported by the hardware, at least 1
+     */
+    static int hardware_concurrency() noexcept;
+
+    /**
+     runs fn(i) for all i in [0, count)
+
+     The calling thread takes part in the work, so parallel_for may be nested,
+     e.g. called from within a task that itself runs on this pool.
+     Once an invocation returns false or throws, no further indices are handed out.
+     If an invocation threw, the first exception is rethrown after all running
+     invocations have finished.
+
+     @return true if all invocations returned true
+     */
+    bool parallel_for(size_t count, const std::function<bool(size_t)>& fn);
+
+  private:
+    void post(std::function<void()> task);
+    void worker_main();
+
+    int m_num_threads = 1;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_task_available;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+};
+
+} //namespace tntn
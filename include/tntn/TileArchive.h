@@ -0,0 +1,121 @@
+#pragma once
+
+#include "tntn/File.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tntn {
+
+/*
+ Packed tile archive, a single file holding all tiles of a tileset.
+
+ layout (all integers little endian):
+   header   8 bytes   magic "TNTNPAK1"
+   data     tile payloads, back to back in the order they were added
+   index    24 bytes per tile, sorted by (zoom, x, y):
+              uint32 zoom, uint32 x, uint32 y, uint32 length, uint64 offset
+   trailer  24 bytes  uint64 index offset, uint64 number of tiles, magic "TNTNIDX1"
+
+ Offsets are relative to the beginning of the file. The index is sorted,
+ so readers can binary search it in place without building any lookup structure.
+ */
+
+/**
+ appends tiles to an archive, add_tile may be called concurrently
+ */
+class TileArchiveWriter
+{
+  private:
+    //disallow copy and assign
+    TileArchiveWriter(const TileArchiveWriter& other) = delete;
+    TileArchiveWriter& operator=(const TileArchiveWriter& other) = delete;
+
+  public:
+    TileArchiveWriter() = default;
+
+    /**
+     starts a new archive, f should be empty
+     */
+    bool open(std::shared_ptr<FileLike> f);
+
+    bool add_tile(int zoom, int x, int y, const unsigned char* data, size_t size);
+    bool add_tile(int zoom, int x, int y, const std::vector<unsigned char>& data)
+    {
+        return add_tile(zoom, x, y, data.data(), data.size());
+    }
+
+    /**
+     writes index and trailer, no tiles can be added afterwards
+     */
+    bool finish();
+
+    size_t num_tiles() const;
+
+  private:
+    struct IndexEntry
+    {
+        uint32_t zoom;
+        uint32_t x;
+        uint32_t y;
+        uint32_t length;
+        uint64_t offset;
+    };
+
+    mutable std::mutex m_mutex;
+    std::shared_ptr<FileLike> m_file;
+    FileLike::position_type m_write_position = 0;
+    std::vector<IndexEntry> m_index;
+    bool m_finished = false;
+};
+
+/**
+ read access to an archive, either memory mapped from a file or over a buffer in memory
+
+ get_tile returns pointers into the mapping, no data is copied.
+ */
+class TileArchiveReader
+{
+  private:
+    //disallow copy and assign
+    TileArchiveReader(const TileArchiveReader& other) = delete;
+    TileArchiveReader& operator=(const TileArchiveReader& other) = delete;
+
+  public:
+    TileArchiveReader() = default;
+    ~TileArchiveReader();
+
+    bool open(const std::string& filename);
+
+    /**
+     use an archive in memory, data must stay valid while the reader is in use
+     */
+    bool open(const unsigned char* data, size_t size);
+
+    void close();
+
+    size_t num_tiles() const { return m_num_tiles; }
+
+    /**
+     @return false if the archive has no such tile
+     */
+    bool get_tile(int zoom, int x, int y, const unsigned char*& data, size_t& size) const;
+
+  private:
+    bool parse();
+
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    const unsigned char* m_index = nullptr;
+    size_t m_num_tiles = 0;
+
+    // mapping owned by this reader, if opened from a file
+    void* m_mapping = nullptr;
+    size_t m_mapping_size = 0;
+};
+
+} //namespace tntn
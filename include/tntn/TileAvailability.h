@@ -0,0 +1,83 @@
+#pragma once
+
+#include "tntn/File.h"
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace tntn {
+
+/**
+ rectangle of tiles, all bounds inclusive
+ */
+struct TileRange
+{
+    int start_x = 0;
+    int start_y = 0;
+    int end_x = 0;
+    int end_y = 0;
+};
+
+/**
+ set of the tiles written per zoom level, kept as runs of consecutive tiles per row.
+ Adjacent runs are merged as tiles are added, so memory grows with the outline of the
+ tiled area instead of the number of tiles.
+
+ Used to write the "available" ranges of a Cesium layer.json, which keeps clients from
+ requesting tiles that do not exist.
+ */
+class TileAvailability
+{
+  public:
+    /**
+     records a tile, not thread safe
+     */
+    void add_tile(int zoom, int tx, int ty);
+    void add_range(int zoom, const TileRange& range);
+
+    /**
+     forgets a tile, e.g. one an update left empty. not thread safe
+     */
+    void remove_tile(int zoom, int tx, int ty);
+
+    bool has_tile(int zoom, int tx, int ty) const;
+    size_t num_tiles() const;
+    bool empty() const { return m_levels.empty(); }
+
+    /**
+     lowest and highest zoom level with tiles, -1 if there are none
+     */
+    int min_zoom() const;
+    int max_zoom() const;
+
+    /**
+     the tiles of a zoom level as disjoint rectangles, rows with the same runs are
+     merged into one rectangle. sorted by start_y, then start_x
+     */
+    std::vector<TileRange> ranges(int zoom) const;
+
+    /**
+     writes a layer.json describing quantized-mesh tiles at {z}/{x}/{y}.<tile_extension>
+     in web mercator with tms tile numbering, listing the given quantized-mesh extensions
+     */
+    bool write_layer_json(FileLike& f,
+                          const std::string& tile_extension,
+                          const std::vector<std::string>& extensions) const;
+
+    /**
+     adds the available ranges of a layer.json as written by write_layer_json
+     */
+    bool read_layer_json(FileLike& f);
+
+  private:
+    // start x -> end x of the runs in a row
+    typedef std::map<int, int> Runs;
+    // zoom -> row -> runs
+    std::map<int, std::map<int, Runs>> m_levels;
+
+    static void insert_run(Runs& runs, int x1, int x2);
+};
+
+} //namespace tntn
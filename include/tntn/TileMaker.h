@@ -2,8 +2,11 @@
 
 #include "tntn/Mesh.h"
 #include "tntn/MeshWriter.h"
+#include "tntn/geometrix.h"
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace tntn {
 
@@ -11,14 +14,65 @@ class TileMaker
 {
     std::unique_ptr<Mesh> m_mesh;
 
+    // uniform grid over the 2D extent of the mesh, each cell lists the
+    // triangles whose bounding box overlaps it (compressed row storage)
+    glm::dvec2 m_grid_origin = {0, 0};
+    glm::dvec2 m_grid_inverse_cell_size = {0, 0};
+    int m_grid_width = 0;
+    int m_grid_height = 0;
+    std::vector<uint32_t> m_grid_cell_start;
+    std::vector<uint32_t> m_grid_triangles;
+
+    // ECEF normals of the decomposed vertices of m_mesh, empty unless requested.
+    // triangle i of m_mesh is face i
+    std::vector<Normal> m_vertex_normals;
+
+    void build_triangle_index();
+    int grid_col(double x) const;
+    int grid_row(double y) const;
+
+    void find_triangle_indices(const BBox2D& bounds, std::vector<uint32_t>& found) const;
+
+    std::unique_ptr<Mesh> clip_tile_with_normals(
+        const std::vector<Triangle>& trianglesInTile,
+        const std::vector<uint32_t>& triangleIndices) const;
+
   public:
     TileMaker() : m_mesh(std::make_unique<Mesh>()) {}
 
     void setMeshWriter(MeshWriter* w);
     bool loadObj(const char* filename);
-    void loadMesh(std::unique_ptr<Mesh> mesh);
+
+    /**
+     @param with_normals compute vertex normals of the whole mesh so that tiles get normals
+                         which are continuous across their borders
+     */
+    void loadMesh(std::unique_ptr<Mesh> mesh, bool with_normals = false);
+
+    /**
+     collects all triangles whose bounding box intersects bounds,
+     in the order they appear in the mesh
+     */
+    void find_triangles(const BBox2D& bounds, std::vector<Triangle>& triangles) const;
+
     // void dumpTile(int tx, int ty, int zoom, const char* filename);
-    bool dumpTile(int tx, int ty, int zoom, const char* filename, MeshWriter& mw);
+
+    /**
+     clips the loaded mesh to a single tile, rescaled to the 0-1 quadrant
+
+     @param bbox receives the bounds of the tile (x/y) and its height range (z)
+     @return the decomposed tile mesh or nullptr when no triangle falls into the tile,
+             with ECEF vertex normals if the mesh was loaded with normals
+     */
+    std::unique_ptr<Mesh> makeTile(int tx, int ty, int zoom, BBox3D& bbox) const;
+
+    /**
+     clips the loaded mesh to a single tile and writes it with mw
+
+     only reads the loaded mesh, so several tiles may be dumped concurrently
+     as long as mw can be used from multiple threads.
+     */
+    bool dumpTile(int tx, int ty, int zoom, const char* filename, MeshWriter& mw) const;
 };
 
 } //namespace tntn
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "tntn/File.h"
+#include "tntn/geometrix.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+
+namespace tntn {
+
+/**
+ record of the partitions a dem2tintiles run has completely written, used to resume runs
+
+ The manifest is a text file starting with a fingerprint line describing the input
+ and all parameters that influence the output, followed by one line per finished partition:
+
+   tntn-manifest 1 <fingerprint>
+   done <zoom> <tmin.x> <tmin.y> <tmax.x> <tmax.y>
+
+ Lines are appended and flushed as partitions finish, so the file stays valid
+ when a run is killed.
+ */
+class TileManifest
+{
+  private:
+    //disallow copy and assign
+    TileManifest(const TileManifest& other) = delete;
+    TileManifest& operator=(const TileManifest& other) = delete;
+
+  public:
+    TileManifest() = default;
+
+    /**
+     reads the finished partitions of an earlier run,
+     fails if the manifest was written with a different fingerprint
+     */
+    bool load(FileLike& f, const std::string& fingerprint);
+
+    /**
+     writes the fingerprint and all partitions loaded so far to f,
+     partitions marked done later are appended
+     */
+    bool start(std::shared_ptr<FileLike> f, const std::string& fingerprint);
+
+    bool is_done(int zoom, const glm::ivec2& tmin, const glm::ivec2& tmax) const;
+
+    /**
+     records a partition, may be called concurrently
+     */
+    bool mark_done(int zoom, const glm::ivec2& tmin, const glm::ivec2& tmax);
+
+    size_t num_done() const;
+
+    /**
+     describes an input file by its size, modification time and a hash
+     of its first and last bytes, cheap even for huge rasters
+     */
+    static bool fingerprint_file(const std::string& filename, std::string& fingerprint);
+
+  private:
+    typedef std::tuple<int, int, int, int, int> Key;
+    static Key make_key(int zoom, const glm::ivec2& tmin, const glm::ivec2& tmax)
+    {
+        return Key(zoom, tmin.x, tmin.y, tmax.x, tmax.y);
+    }
+
+    bool append_line(const std::string& line);
+
+    mutable std::mutex m_mutex;
+    std::shared_ptr<FileLike> m_file;
+    FileLike::position_type m_write_position = 0;
+    std::set<Key> m_done;
+};
+
+} //namespace tntn
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "tntn/Raster.h"
+#include "tntn/geometrix.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tntn {
+
+/**
+ read access to rectangular windows of a raster that does not need to be held in memory
+
+ geometry follows the conventions of Raster (row/column origin at the top left,
+ position of the lower left corner in world coordinates).
+ implementations must allow concurrent calls to crop.
+ */
+class WindowedRaster
+{
+  private:
+    //disallow copy and assign
+    WindowedRaster(const WindowedRaster& other) = delete;
+    WindowedRaster& operator=(const WindowedRaster& other) = delete;
+
+  public:
+    WindowedRaster() = default;
+    virtual ~WindowedRaster() = default;
+
+    unsigned int get_width() const { return m_width; }
+    unsigned int get_height() const { return m_height; }
+    double get_pos_x() const { return m_xpos; }
+    double get_pos_y() const { return m_ypos; }
+    double get_cell_size() const { return m_cellsize; }
+    double get_no_data_value() const { return m_no_data_value; }
+
+    BBox2D get_bounding_box() const;
+    int x2col(double x) const;
+    int y2row(double y) const;
+
+    /**
+     true if the samples are single precision values,
+     crops into a RasterFloat are then as exact as those into a RasterDouble
+     */
+    bool is_single_precision() const { return m_single_precision; }
+
+    /**
+     reads a sub raster, same result as Raster::crop on the complete raster
+     */
+    bool crop(const int cx, const int cy, const int cw, const int ch, RasterDouble& dst_raster);
+    bool crop(const int cx, const int cy, const int cw, const int ch, RasterFloat& dst_raster);
+
+  protected:
+    void set_geometry(unsigned int width,
+                      unsigned int height,
+                      double xpos,
+                      double ypos,
+                      double cellsize,
+                      double no_data_value);
+    void set_single_precision(bool single_precision) { m_single_precision = single_precision; }
+
+    /**
+     read the pixels of rows [y, y + h) and columns [x, x + w) into dst, row by row
+     the window is always inside the raster
+     */
+    virtual bool read(int x, int y, int w, int h, double* dst) = 0;
+
+    /**
+     same as read into floats, by default the pixels are read as double and narrowed
+     */
+    virtual bool read_float(int x, int y, int w, int h, float* dst);
+
+    friend class DownsampledWindowedRaster;
+
+  private:
+    bool read_pixels(int x, int y, int w, int h, double* dst) { return read(x, y, w, h, dst); }
+    bool read_pixels(int x, int y, int w, int h, float* dst)
+    {
+        return read_float(x, y, w, h, dst);
+    }
+
+    template<typename T>
+    bool crop_into(const int cx, const int cy, const int cw, const int ch, Raster<T>& dst_raster);
+
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    double m_xpos = 0;
+    double m_ypos = 0;
+    double m_cellsize = 1;
+    double m_no_data_value = 0;
+    bool m_single_precision = false;
+};
+
+/**
+ windowed access to a raster in memory, available for RasterDouble and RasterFloat
+ */
+template<typename T>
+class BasicMemoryWindowedRaster : public WindowedRaster
+{
+  public:
+    explicit BasicMemoryWindowedRaster(std::shared_ptr<const Raster<T>> raster);
+    // raster must outlive this object
+    explicit BasicMemoryWindowedRaster(const Raster<T>& raster);
+
+  protected:
+    bool read(int x, int y, int w, int h, double* dst) override;
+    bool read_float(int x, int y, int w, int h, float* dst) override;
+
+  private:
+    template<typename U>
+    void copy_window(int x, int y, int w, int h, U* dst) const;
+
+    std::shared_ptr<const Raster<T>> m_owned_raster;
+    const Raster<T>& m_raster;
+};
+
+typedef BasicMemoryWindowedRaster<double> MemoryWindowedRaster;
+typedef BasicMemoryWindowedRaster<float> MemoryWindowedRasterFloat;
+
+/**
+ integer_downsample_mean of another windowed raster, computed on demand for each window.
+ single precision if the source is, like the overviews of a RasterFloat
+ */
+class DownsampledWindowedRaster : public WindowedRaster
+{
+  public:
+    DownsampledWindowedRaster(std::shared_ptr<WindowedRaster> source, int window_size);
+
+  protected:
+    bool read(int x, int y, int w, int h, double* dst) override;
+
+  private:
+    std::shared_ptr<WindowedRaster> m_source;
+    int m_window_size;
+};
+
+/**
+ windowed raster backed by a source that is read in fixed size blocks,
+ e.g. the internal tiles or strips of a GeoTIFF
+
+ recently used blocks are kept in an LRU cache whose size is bounded by a byte budget.
+ blocks of single precision sources are kept as floats.
+ block coordinates refer to the source layout, which may be mirrored horizontally and/or
+ vertically against the raster (flip_x / flip_y).
+ */
+class BlockCachedWindowedRaster : public WindowedRaster
+{
+  public:
+    size_t cache_budget() const { return m_cache_budget; }
+    size_t cache_hits() const { return m_cache_hits; }
+    size_t cache_misses() const { return m_cache_misses; }
+
+  protected:
+    void set_block_layout(int block_width, int block_height, bool flip_x, bool flip_y);
+    void set_cache_budget(size_t bytes) { m_cache_budget = bytes; }
+
+    /**
+     read the block area [x, x + w) x [y, y + h) in source coordinates into dst, row by row
+
+     called without holding the cache lock, so different blocks may be read concurrently
+     */
+    virtual bool read_block(int x, int y, int w, int h, double* dst) = 0;
+
+    /**
+     same as read_block into floats, used instead of it for single precision sources.
+     by default the block is read as double and narrowed
+     */
+    virtual bool read_block_float(int x, int y, int w, int h, float* dst);
+
+    bool read(int x, int y, int w, int h, double* dst) override;
+    bool read_float(int x, int y, int w, int h, float* dst) override;
+
+  private:
+    // only one of the sample vectors is filled, depending on the source precision
+    struct Block
+    {
+        std::vector<double> samples;
+        std::vector<float> float_samples;
+
+        size_t bytes() const
+        {
+            return samples.size() * sizeof(double) + float_samples.size() * sizeof(float);
+        }
+    };
+    typedef std::shared_ptr<const Block> BlockPtr;
+    BlockPtr get_block(int bx, int by);
+
+    template<typename T>
+    bool copy_window(int x, int y, int w, int h, T* dst);
+
+    int m_block_width = 1;
+    int m_block_height = 1;
+    bool m_flip_x = false;
+    bool m_flip_y = false;
+
+    // guards the cache and m_loading, block reads happen outside of it
+    std::mutex m_mutex;
+    // blocks being read, threads that need one of them wait for its reader
+    std::unordered_map<uint64_t, std::shared_future<BlockPtr>> m_loading;
+    size_t m_cache_budget = 0;
+    size_t m_cache_bytes = 0;
+    size_t m_cache_hits = 0;
+    size_t m_cache_misses = 0;
+    // front is the most recently used block
+    std::list<uint64_t> m_lru;
+    struct CacheEntry
+    {
+        BlockPtr block;
+        std::list<uint64_t>::iterator lru_position;
+    };
+    std::unordered_map<uint64_t, CacheEntry> m_cache;
+};
+
+/**
+ compares two rasters of identical geometry band by band
+
+ @param region receives the world extent of all cells that differ,
+               an empty box (see BBox2D::reset) if the rasters are equal
+ @return false if the rasters can not be compared
+ */
+bool find_changed_region(WindowedRaster& a, WindowedRaster& b, BBox2D& region);
+
+} //namespace tntn
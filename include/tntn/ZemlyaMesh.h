@@ -5,8 +5,11 @@
 #include "tntn/DelaunayMesh.h"
 #include "tntn/MeshIO.h"
 #include "tntn/TerraUtils.h"
+#include "tntn/BitRaster.h"
 
+#include <cmath>
 #include <memory>
+#include <vector>
 
 namespace tntn {
 namespace zemlya {
@@ -18,18 +21,143 @@ using Point2D = terra::Point2D;
 using CandidateList = terra::CandidateList;
 using Candidate = terra::Candidate;
 
-class ZemlyaMesh : public terra::TerraBaseMesh
+/**
+ values of Zemlya's level points, packed per step instead of at full raster resolution.
+ the points of step s >= 1 lie at rows and columns 2^(s-1) + k * 2^s, so a point (r, c)
+ belongs to step s if both r and c have s - 1 trailing zero bits.
+ each step is kept in its own raster with one cell per point and has to be allocated
+ before use, all other pixels read as NaN.
+ */
+class PyramidRaster
+{
+  public:
+    void reset(const unsigned int w, const unsigned int h)
+    {
+        m_width = w;
+        m_height = h;
+        m_steps.clear();
+    }
+
+    /**
+     step of the points in row or column r, 0 if there are none
+     */
+    static int step_of(unsigned int r)
+    {
+        if(r == 0)
+        {
+            return 0;
+        }
+        int step = 1;
+        for(; (r & 1) == 0; r >>= 1)
+        {
+            step++;
+        }
+        return step;
+    }
+
+    /**
+     allocate step with all its points set to NaN
+     */
+    void allocate_step(const int step)
+    {
+        if(m_steps.size() <= static_cast<size_t>(step))
+        {
+            m_steps.resize(step + 1);
+        }
+        Raster<double>& points = m_steps[step];
+        points.allocate(count(m_width, step), count(m_height, step));
+        points.set_all(NAN);
+    }
+
+    void release_step(const int step)
+    {
+        if(has_step(step))
+        {
+            m_steps[step].clear();
+        }
+    }
+
+    bool has_step(const int step) const
+    {
+        return step >= 1 && static_cast<size_t>(step) < m_steps.size() &&
+            m_steps[step].get_ptr() != nullptr;
+    }
+
+    unsigned int get_width() const { return m_width; }
+    unsigned int get_height() const { return m_height; }
+
+    /**
+     value of the point at pixel (r, c), NaN outside the raster, for pixels that are no
+     points and for points of steps not allocated
+     */
+    double value(const unsigned int r, const unsigned int c) const
+    {
+        if(r >= m_height || c >= m_width)
+        {
+            return NAN;
+        }
+        const int step = step_of(r);
+        if(step != step_of(c) || !has_step(step))
+        {
+            return NAN;
+        }
+        return m_steps[step].value(r >> step, c >> step);
+    }
+
+    /**
+     value of the point at pixel (r, c), which has to be a point of the allocated step
+     */
+    double& at(const int step, const unsigned int r, const unsigned int c)
+    {
+        return m_steps[step].value(r >> step, c >> step);
+    }
+
+    /**
+     calls f(r, c, z) for every point of an allocated step with its pixel position and
+     a reference to its value
+     */
+    template<typename F>
+    void for_each_point(const int step, F&& f)
+    {
+        Raster<double>& points = m_steps[step];
+        const unsigned int co = 1u << (step - 1);
+        for(unsigned int i = 0; i < points.get_height(); i++)
+        {
+            double* row = points.get_ptr(i);
+            for(unsigned int j = 0; j < points.get_width(); j++)
+            {
+                f(co + (i << step), co + (j << step), row[j]);
+            }
+        }
+    }
+
+  private:
+    // number of points of step along an axis of length n
+    static unsigned int count(const unsigned int n, const int step)
+    {
+        const unsigned int co = 1u << (step - 1);
+        return n > co ? (n - co + (1u << step) - 1) >> step : 0;
+    }
+
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    std::vector<Raster<double>> m_steps;
+};
+
+template<typename T>
+class ZemlyaMesh : public terra::TerraBaseMesh<T>
 {
   private:
-    Raster<double> m_sample;
-    Raster<double> m_insert;
-    Raster<double> m_result;
-    Raster<char> m_used;
-    Raster<int> m_token;
+    using terra::TerraBaseMesh<T>::m_raster;
+    using terra::TerraBaseMesh<T>::m_first_face;
+
+    PyramidRaster m_sample;
+    PyramidRaster m_insert;
+    Raster<T> m_result;
+    BitRaster m_used;
 
     CandidateList m_candidates;
     double m_max_error = 0;
-    int m_counter = 0;
     int m_current_level = 0;
     int m_max_level = 0;
 
@@ -3,7 +3,14 @@
 #include "tntn/MercatorProjection.h"
 #include "tntn/SurfacePoints.h"
 #include "tntn/MeshWriter.h"
+#include "tntn/RasterOverviews.h"
+#include "tntn/ThreadPool.h"
+#include "tntn/TileArchive.h"
+#include "tntn/TileAvailability.h"
+#include "tntn/TileManifest.h"
+#include "tntn/WindowedRaster.h"
 
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -17,13 +24,97 @@ struct Partition
 };
 
 std::vector<Partition> create_partitions_for_zoom_level(const RasterDouble& dem, int zoom);
+std::vector<Partition> create_partitions_for_zoom_level(const WindowedRaster& dem, int zoom);
 
-bool create_tiles_for_zoom_level(const RasterDouble& dem,
-                                 const std::vector<Partition>& partitions,
-                                 int zoom,
-                                 const std::string& output_basedir,
-                                 const double method_parameter,
-                                 const std::string& meshing_method,
-                                 MeshWriter& mesh_writer);
+/**
+ decides whether a partition of a zoom level is processed, cell_size is the
+ resolution of the level's raster
+ */
+typedef std::function<bool(const Partition& part, int zoom, double cell_size)> PartitionFilter;
+
+/**
+ selects the partitions whose tiles can change when the input raster changes inside region,
+ i.e. those whose raster window overlaps region on any zoom level
+ */
+PartitionFilter dirty_region_filter(const BBox2D& region);
+
+/**
+ creates the tiles of all zoom levels of overviews as a pipeline of concurrent stages:
+ overview generation -> partition meshing -> tile clipping/encoding -> file writing
+
+ The stages are connected by bounded queues, so overview computation and disk writes
+ overlap with meshing. Queue depths and stall times are logged when done.
+
+ @param method_parameter parameter for the meshing method,
+                         a negative value selects the resolution of each zoom level
+ @param num_threads number of threads for meshing and for encoding each
+ @param queue_capacity maximum number of items waiting between two stages
+ @param archive optional, if given tiles are packed into this archive instead of being
+                written to output_basedir/z/x/y files. finish() is left to the caller.
+ @param manifest optional, partitions listed as done are skipped and
+                 partitions are recorded once all of their tiles are written
+ @param filter optional, only partitions it accepts are processed. as they replace the
+               tiles of a previous run, tiles left empty are removed from output_basedir
+               and availability
+ @param availability optional, receives every tile written. for partitions skipped as done
+                     in the manifest the existing tile files are added instead
+ @param terra_block_size if positive, terra meshes partitions larger than this many pixels
+                         in blocks of this size in parallel. 0 meshes them in one piece
+ @param thread_pool optional, its workers help the meshing threads with the blocks.
+                    without it each meshing thread meshes the blocks of its partition alone
+ */
+bool create_tiles_pipelined(RasterOverviews& overviews,
+                            const std::string& output_basedir,
+                            const double method_parameter,
+                            const std::string& meshing_method,
+                            MeshWriter& mesh_writer,
+                            const int num_threads,
+                            const size_t queue_capacity,
+                            TileArchiveWriter* archive = nullptr,
+                            TileManifest* manifest = nullptr,
+                            const PartitionFilter& filter = PartitionFilter(),
+                            TileAvailability* availability = nullptr,
+                            const int terra_block_size = 0,
+                            ThreadPool* thread_pool = nullptr);
+
+/**
+ same as above for single precision overviews, terra and zemlya then mesh in single precision
+ */
+bool create_tiles_pipelined(RasterOverviewsFloat& overviews,
+                            const std::string& output_basedir,
+                            const double method_parameter,
+                            const std::string& meshing_method,
+                            MeshWriter& mesh_writer,
+                            const int num_threads,
+                            const size_t queue_capacity,
+                            TileArchiveWriter* archive = nullptr,
+                            TileManifest* manifest = nullptr,
+                            const PartitionFilter& filter = PartitionFilter(),
+                            TileAvailability* availability = nullptr,
+                            const int terra_block_size = 0,
+                            ThreadPool* thread_pool = nullptr);
+
+/**
+ same as above, but reads the zoom levels window by window from dem instead of
+ keeping overviews in memory. Lower zoom levels are downsampled on the fly
+ like RasterOverviews does in direct mode.
+
+ @param min_zoom, max_zoom requested zoom range, -1 to guess from the raster
+ */
+bool create_tiles_pipelined(std::shared_ptr<WindowedRaster> dem,
+                            int min_zoom,
+                            int max_zoom,
+                            const std::string& output_basedir,
+                            const double method_parameter,
+                            const std::string& meshing_method,
+                            MeshWriter& mesh_writer,
+                            const int num_threads,
+                            const size_t queue_capacity,
+                            TileArchiveWriter* archive = nullptr,
+                            TileManifest* manifest = nullptr,
+                            const PartitionFilter& filter = PartitionFilter(),
+                            TileAvailability* availability = nullptr,
+                            const int terra_block_size = 0,
+                            ThreadPool* thread_pool = nullptr);
 
 } //namespace tntn
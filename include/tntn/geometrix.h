@@ -14,6 +14,7 @@ namespace tntn {
 
 typedef glm::dvec3 Vertex;
 typedef std::array<Vertex, 3> Triangle;
+typedef glm::dvec3 Normal;
 
 typedef size_t VertexIndex; //0-based index into an array/vector of vertices
 typedef std::array<VertexIndex, 3> Face;
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace tntn {
+
+/**
+ compresses data into a gzip stream as expected by clients of tiles
+ served with Content-Encoding: gzip
+
+ @param level zlib compression level from 1 (fastest) to 9 (smallest)
+ */
+bool gzip_compress(const unsigned char* data,
+                   size_t size,
+                   std::vector<unsigned char>& out,
+                   int level = 6);
+
+/**
+ decompresses a complete gzip stream
+ */
+bool gzip_decompress(const unsigned char* data, size_t size, std::vector<unsigned char>& out);
+
+/**
+ checks for the gzip magic bytes
+ */
+bool is_gzip(const unsigned char* data, size_t size);
+
+} //namespace tntn
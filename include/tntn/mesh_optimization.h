@@ -0,0 +1,42 @@
+#pragma once
+
+#include "tntn/Mesh.h"
+#include "tntn/geometrix.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace tntn {
+
+/**
+ average number of vertex transforms per triangle (ACMR) when drawing faces
+ in order through a FIFO post-transform cache with cache_size entries.
+ ranges from about 0.5 for an ideal ordering of a large grid to 3.
+ */
+double average_cache_miss_ratio(const std::vector<Face>& faces,
+                                size_t num_vertices,
+                                size_t cache_size = 16);
+
+/**
+ reorders faces for post-transform vertex cache reuse following Tom Forsyth's
+ "Linear-Speed Vertex Cache Optimisation", runs in O(number of faces).
+ the faces themselves (and their winding) are not changed.
+ */
+void optimize_vertex_cache(std::vector<Face>& faces, size_t num_vertices);
+
+/**
+ renumbers vertices in the order faces first use them, unused vertices are dropped.
+ per vertex normals, if given, are reordered along with the vertices
+ */
+void reorder_vertices_by_first_use(std::vector<Vertex>& vertices,
+                                   std::vector<Face>& faces,
+                                   std::vector<Normal>* normals = nullptr);
+
+/**
+ applies optimize_vertex_cache and reorder_vertices_by_first_use to the faces of mesh,
+ the mesh is decomposed first if needed and its triangles are dropped, vertex normals are kept.
+ logs the ACMR before and after at debug level.
+ */
+void optimize_mesh_for_vertex_cache(Mesh& mesh);
+
+} // namespace tntn
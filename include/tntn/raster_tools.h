@@ -1,15 +1,24 @@
 #pragma once
 
 #include "tntn/Raster.h"
+#include <cstdint>
 #include <vector>
 #include <string>
 #include "tntn/geometrix.h"
+#include "tntn/ThreadPool.h"
 
 namespace tntn {
 
+// the templates are available for RasterDouble and RasterFloat
 struct raster_tools //just a namespace
 {
-    static RasterDouble integer_downsample_mean(const RasterDouble& src, int window_size);
+    template<typename T>
+    static Raster<T> integer_downsample_mean(const Raster<T>& src, int window_size);
+
+    template<typename T>
+    static Raster<T> downsample_mean_2x2(const Raster<T>& src,
+                                         Raster<uint32_t>& weights,
+                                         ThreadPool* thread_pool = nullptr);
 
     static RasterDouble convolution_filter(const RasterDouble& src,
                                            std::vector<double> kernel,
@@ -17,15 +26,20 @@ struct raster_tools //just a namespace
 
     static RasterDouble max_filter(const RasterDouble& src, int size, double pos, double factor);
 
-    static void flip_data_x(RasterDouble& r);
+    template<typename T>
+    static void flip_data_x(Raster<T>& r);
 
-    static void flip_data_y(RasterDouble& r);
+    template<typename T>
+    static void flip_data_y(Raster<T>& r);
 
-    static void find_minmax(const RasterDouble& raster, double& min, double& max);
+    template<typename T>
+    static void find_minmax(const Raster<T>& raster, double& min, double& max);
 
-    static BBox3D get_bounding_box3d(const RasterDouble& raster);
+    template<typename T>
+    static BBox3D get_bounding_box3d(const Raster<T>& raster);
 
-    static double sample_nearest_valid_avg(const RasterDouble& src,
+    template<typename T>
+    static double sample_nearest_valid_avg(const Raster<T>& src,
                                            const unsigned int row,
                                            const unsigned int column,
                                            int min_averaging_samples = 1);
@@ -3,6 +3,7 @@
 #include "tntn/SurfacePoints.h"
 #include "tntn/Mesh.h"
 #include "tntn/Raster.h"
+#include "tntn/ThreadPool.h"
 
 #include <memory>
 
@@ -10,6 +11,26 @@ namespace tntn {
 
 std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterDouble> raster, double max_error);
 
+/**
+ same as above for single precision samples, e.g. of a Float32 or Int16 source
+ */
+std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterFloat> raster, double max_error);
+
+/**
+ terra on blocks of at most block_size pixels a side, meshed concurrently on thread_pool.
+ the points on the block borders are picked first along each border and shared by the blocks
+ on both sides, so the merged mesh is a proper TIN within max_error of every sample.
+ rasters that fit into a single block are meshed as above.
+ */
+std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterDouble> raster,
+                                         double max_error,
+                                         ThreadPool& thread_pool,
+                                         int block_size = 512);
+std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterFloat> raster,
+                                         double max_error,
+                                         ThreadPool& thread_pool,
+                                         int block_size = 512);
+
 std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<SurfacePoints> surface_points,
                                          double max_error);
 std::unique_ptr<Mesh> generate_tin_terra(const SurfacePoints& surface_points, double max_error);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tntn {
+namespace terra {
+
+/**
+ largest error |z - plane| over the points startx..endx of one raster row that are neither
+ used nor no data, with the plane at column x given as a * x + row_offset.
+ used holds one bit per column as in a BitRaster row.
+ the first of equal maxima wins, as in scanning the row point by point.
+ uses AVX2 or SSE2 when compiled for it, all variants pick the same point.
+
+ @return column of the point with the largest error, -1 if no point qualifies
+ */
+int scan_row_max_error(const double* row,
+                       const uint64_t* used,
+                       int startx,
+                       int endx,
+                       double a,
+                       double row_offset,
+                       double no_data_value,
+                       double& max_error);
+
+/**
+ same as above for a row of single precision samples, errors are computed in double
+ */
+int scan_row_max_error(const float* row,
+                       const uint64_t* used,
+                       int startx,
+                       int endx,
+                       double a,
+                       double row_offset,
+                       double no_data_value,
+                       double& max_error);
+
+} //namespace terra
+} //namespace tntn
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "tntn/Mesh.h"
+#include "tntn/geometrix.h"
+#include "tntn/util.h"
+
+#include <vector>
+
+namespace tntn {
+
+/**
+ area weighted vertex normals in a single pass over the faces,
+ vertices not used by any face get a zero normal
+ */
+void compute_vertex_normals(SimpleRange<const Vertex*> vertices,
+                            SimpleRange<const Face*> faces,
+                            std::vector<Normal>& normals);
+
+/**
+ unit vertex normals in earth centered, earth fixed coordinates for a decomposed
+ mesh in web mercator, vertices without faces point away from the earth's center
+ */
+void compute_ecef_vertex_normals(const Mesh& mesh, std::vector<Normal>& normals);
+
+} //namespace tntn
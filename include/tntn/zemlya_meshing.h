@@ -8,6 +8,11 @@
 namespace tntn {
 
 std::unique_ptr<Mesh> generate_tin_zemlya(std::unique_ptr<RasterDouble> raster, double max_error);
+
+/**
+ same as above for single precision samples, e.g. of a Float32 or Int16 source
+ */
+std::unique_ptr<Mesh> generate_tin_zemlya(std::unique_ptr<RasterFloat> raster, double max_error);
 std::unique_ptr<Mesh> generate_tin_zemlya(std::unique_ptr<SurfacePoints> surface_points,
                                           double max_error);
 std::unique_ptr<Mesh> generate_tin_zemlya(const SurfacePoints& surface_points, double max_error);
@@ -115,6 +115,28 @@ size_t BinaryIO::read_impl(void* const dest,
     return bytes_read / dest_elem_size;
 }
 
+BinaryIO::~BinaryIO()
+{
+    BinaryIOErrorTracker e;
+    flush(e);
+}
+
+void BinaryIO::record_write_error(const File::position_type where,
+                                  const size_t expected_bytes,
+                                  const char* const elem_type,
+                                  BinaryIOErrorTracker& e)
+{
+    e.last_error.type = elem_type;
+    e.last_error.where = where;
+    e.last_error.what = BinaryIOError::WRITE;
+    e.last_error.actual_bytes = 0;
+    e.last_error.expected_bytes = expected_bytes;
+    if(!e.first_error.type)
+    {
+        e.first_error = e.last_error;
+    }
+}
+
 void BinaryIO::write_impl(const void* const src,
                           size_t src_elem_size,
                           size_t src_count,
@@ -122,63 +144,67 @@ void BinaryIO::write_impl(const void* const src,
                           BinaryIOErrorTracker& e)
 {
     TNTN_ASSERT(src_elem_size > 0);
-    TNTN_ASSERT(src_elem_size <= 32);
-    if(src_elem_size > 32)
+
+    const size_t bytes_to_write = src_elem_size * src_count;
+    if(bytes_to_write == 0)
     {
         return;
     }
 
-    const size_t bytes_to_write = src_elem_size * src_count;
     const unsigned char* src_c = reinterpret_cast<const unsigned char*>(src);
-    if(PLATFORM_NATIVE_ENDIANNESS == m_target_endianness)
+    const bool swap_bytes = PLATFORM_NATIVE_ENDIANNESS != m_target_endianness;
+
+    if(!m_buffer_writes && !swap_bytes)
     {
         //simple write
-        const bool write_ok = m_f->write(m_write_pos, src_c, bytes_to_write);
-        if(!write_ok)
+        if(!m_f->write(m_write_pos, src_c, bytes_to_write))
         {
-            e.last_error.type = elem_type;
-            e.last_error.where = m_write_pos;
-            e.last_error.what = BinaryIOError::WRITE;
-            e.last_error.actual_bytes = 0;
-            e.last_error.expected_bytes = bytes_to_write;
-            if(!e.first_error.type)
-            {
-                e.first_error = e.last_error;
-            }
-        }
-        if(write_ok)
-        {
-            m_write_pos += bytes_to_write;
+            record_write_error(m_write_pos, bytes_to_write, elem_type, e);
+            return;
         }
+        m_write_pos += bytes_to_write;
+        return;
     }
-    else
+
+    if(m_write_buffer.empty())
+    {
+        m_write_buffer_pos = m_write_pos;
+    }
+
+    //append to the buffer and convert the whole array in place
+    const size_t start = m_write_buffer.size();
+    m_write_buffer.insert(m_write_buffer.end(), src_c, src_c + bytes_to_write);
+    if(swap_bytes && src_elem_size > 1)
     {
-        //copy to temporary storage, reverse, write
-        unsigned char tmp[34];
-        for(const unsigned char* p = src_c; p < src_c + bytes_to_write; p += src_elem_size)
+        unsigned char* const begin = m_write_buffer.data() + start;
+        unsigned char* const end = begin + bytes_to_write;
+        for(unsigned char* p = begin; p < end; p += src_elem_size)
         {
-            memcpy(tmp, p, src_elem_size);
-            std::reverse(tmp, tmp + src_elem_size);
-            const bool write_ok = m_f->write(m_write_pos, tmp, src_elem_size);
-            if(!write_ok)
-            {
-                e.last_error.type = elem_type;
-                e.last_error.where = m_write_pos;
-                e.last_error.what = BinaryIOError::WRITE;
-                e.last_error.actual_bytes = 0;
-                e.last_error.expected_bytes = bytes_to_write;
-                if(!e.first_error.type)
-                {
-                    e.first_error = e.last_error;
-                }
-                break;
-            }
-            if(write_ok)
-            {
-                m_write_pos += bytes_to_write;
-            }
+            std::reverse(p, p + src_elem_size);
         }
     }
+    m_write_pos += bytes_to_write;
+
+    if(!m_buffer_writes)
+    {
+        flush(e);
+    }
+}
+
+void BinaryIO::flush(BinaryIOErrorTracker& e)
+{
+    if(m_write_buffer.empty())
+    {
+        return;
+    }
+
+    if(!m_f->write(m_write_buffer_pos, m_write_buffer))
+    {
+        record_write_error(m_write_buffer_pos, m_write_buffer.size(), "buffer", e);
+        //the position must match what actually made it into the file
+        m_write_pos = m_write_buffer_pos;
+    }
+    m_write_buffer.clear();
 }
 
 } // namespace tntn
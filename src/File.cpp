@@ -1,10 +1,17 @@
 #include "tntn/File.h"
 #include "tntn/logging.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <errno.h>
 #include <limits>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace tntn {
 
 static constexpr size_t max_read_write_chunk_size = std::numeric_limits<int>::max();
@@ -344,6 +351,101 @@ bool MemoryFile::write(position_type to_offset_ui64, const unsigned char* data,
     return data_size;
 }
 
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const char* filename)
+{
+    close();
+
+    const int fd = ::open(filename, O_RDONLY);
+    if(fd < 0)
+    {
+        const auto err = errno;
+        TNTN_LOG_DEBUG("unable to open {}, errno = {}", filename, err);
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        const auto err = errno;
+        TNTN_LOG_ERROR("unable to get size of {}, errno = {}", filename, err);
+        ::close(fd);
+        return false;
+    }
+
+    // empty files can not be mapped
+    const size_t size = static_cast<size_t>(st.st_size);
+    if(size > 0)
+    {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED)
+        {
+            const auto err = errno;
+            TNTN_LOG_ERROR("unable to map {}, errno = {}", filename, err);
+            ::close(fd);
+            return false;
+        }
+        m_mapping = mapping;
+        m_data = static_cast<const unsigned char*>(mapping);
+    }
+    ::close(fd);
+
+    m_size = size;
+    m_is_good = true;
+    m_filename = filename;
+    return true;
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    return open(filename.c_str());
+}
+
+bool MappedFile::close()
+{
+    int rc = 0;
+    if(m_mapping != nullptr)
+    {
+        rc = munmap(m_mapping, m_size);
+        const auto err = errno;
+        if(rc != 0)
+        {
+            TNTN_LOG_DEBUG("munmap on {} failed with errno {}", m_filename, err);
+        }
+    }
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_is_good = false;
+    m_filename.clear();
+    return rc == 0;
+}
+
+size_t MappedFile::read(position_type from_offset, unsigned char* buffer, size_t size_of_buffer)
+{
+    if(!m_is_good || from_offset > m_size)
+    {
+        return 0;
+    }
+    const size_t bytes_to_read =
+        std::min(size_of_buffer, m_size - static_cast<size_t>(from_offset));
+    if(bytes_to_read > 0)
+    {
+        memcpy(buffer, m_data + from_offset, bytes_to_read);
+    }
+    return bytes_to_read;
+}
+
+bool MappedFile::write(position_type to_offset, const unsigned char* data, size_t data_size)
+{
+    TNTN_LOG_ERROR("unable to write into read-only mapped file {}", m_filename);
+    return false;
+}
+
 FileLike::position_type getline(FileLike::position_type from_offset,
                                 FileLike& f,
                                 std::string& str)
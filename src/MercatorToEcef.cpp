@@ -0,0 +1,42 @@
+#include "tntn/MercatorToEcef.h"
+
+#include <cmath>
+
+namespace tntn {
+
+// WGS84 ellipsoid, the web mercator sphere uses the semi major axis as radius
+static constexpr double semi_major_axis = 6378137.0;
+static constexpr double flattening = 1.0 / 298.257223563;
+static constexpr double eccentricity_squared = flattening * (2.0 - flattening);
+static constexpr double inverse_radius = 1.0 / semi_major_axis;
+
+glm::dvec3 MercatorToEcef::transform(const glm::dvec3& p)
+{
+    const double lon = p.x * inverse_radius;
+
+    // the latitude is the Gudermannian of y / R, its sine and cosine are tanh and sech,
+    // which need a single exp instead of atan(sinh(y / R)) followed by sin and cos
+    const double e = std::exp(p.y * inverse_radius);
+    const double inverse_e = 1.0 / e;
+    const double inverse_cosh = 2.0 / (e + inverse_e);
+    const double sin_lat = (e - inverse_e) * inverse_cosh * 0.5;
+    const double cos_lat = inverse_cosh;
+
+    // prime vertical radius of curvature
+    const double n =
+        semi_major_axis / std::sqrt(1.0 - eccentricity_squared * sin_lat * sin_lat);
+
+    return glm::dvec3((n + p.z) * cos_lat * std::cos(lon),
+                      (n + p.z) * cos_lat * std::sin(lon),
+                      (n * (1.0 - eccentricity_squared) + p.z) * sin_lat);
+}
+
+void MercatorToEcef::transform(glm::dvec3* points, const size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        points[i] = transform(points[i]);
+    }
+}
+
+} //namespace tntn
@@ -17,6 +17,7 @@ void Mesh::clear()
     m_triangles.clear();
     m_vertices.clear();
     m_faces.clear();
+    m_normals.clear();
 }
 
 void Mesh::clear_triangles()
@@ -28,6 +29,7 @@ void Mesh::clear_decomposed()
 {
     m_vertices.clear();
     m_faces.clear();
+    m_normals.clear();
 }
 
 Mesh Mesh::clone() const
@@ -35,6 +37,7 @@ Mesh Mesh::clone() const
     Mesh out;
     out.m_faces = m_faces;
     out.m_vertices = m_vertices;
+    out.m_normals = m_normals;
     out.m_triangles = m_triangles;
     return out;
 }
@@ -230,6 +233,28 @@ void Mesh::grab_decomposed(std::vector<Vertex>& vertices, std::vector<Face>& fac
 
     vertices.swap(m_vertices);
     faces.swap(m_faces);
+    m_normals.clear();
+}
+
+void Mesh::set_normals(std::vector<Normal>&& normals)
+{
+    TNTN_ASSERT(normals.size() == m_vertices.size());
+    m_normals = std::move(normals);
+}
+
+SimpleRange<const Normal*> Mesh::normals() const
+{
+    if(m_normals.empty())
+    {
+        return {nullptr, nullptr};
+    }
+    return {m_normals.data(), m_normals.data() + m_normals.size()};
+}
+
+void Mesh::grab_normals(std::vector<Normal>& normals)
+{
+    normals.clear();
+    normals.swap(m_normals);
 }
 
 bool Mesh::semantic_equal(const Mesh& other) const
@@ -1,6 +1,9 @@
 #include "tntn/MeshWriter.h"
 #include "tntn/QuantizedMeshIO.h"
 #include "tntn/MeshIO.h"
+#include "tntn/mesh_optimization.h"
+#include "tntn/gzip.h"
+#include "tntn/logging.h"
 
 namespace tntn {
 
@@ -9,6 +12,11 @@ bool ObjMeshWriter::write_mesh_to_file(const char* filename, Mesh& mesh, const B
     return write_mesh_as_obj(filename, mesh);
 }
 
+bool ObjMeshWriter::write_mesh(const std::shared_ptr<FileLike>& f, Mesh& mesh, const BBox3D& bbox)
+{
+    return write_mesh_as_obj(*f, mesh);
+}
+
 std::string ObjMeshWriter::file_extension()
 {
     return "obj";
@@ -16,7 +24,44 @@ std::string ObjMeshWriter::file_extension()
 
 bool QuantizedMeshWriter::write_mesh_to_file(const char* filename, Mesh& mesh, const BBox3D& bbox)
 {
-    return write_mesh_as_qm(filename, mesh, bbox, true);
+    auto f = std::make_shared<File>();
+    if(!f->open(filename, File::OM_RWCF))
+    {
+        TNTN_LOG_ERROR("unable to open quantized mesh file {}", filename);
+        return false;
+    }
+    return write_mesh(f, mesh, bbox);
+}
+
+bool QuantizedMeshWriter::write_mesh(const std::shared_ptr<FileLike>& f,
+                                     Mesh& mesh,
+                                     const BBox3D& bbox)
+{
+    if(m_optimize_triangle_order)
+    {
+        optimize_mesh_for_vertex_cache(mesh);
+    }
+    if(m_gzip_level <= 0)
+    {
+        return write_mesh_as_qm(f, mesh, bbox, true);
+    }
+
+    auto raw = std::make_shared<MemoryFile>();
+    if(!write_mesh_as_qm(raw, mesh, bbox, true))
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> buffer;
+    raw->read(0, buffer, raw->size());
+    raw.reset();
+
+    std::vector<unsigned char> compressed;
+    if(!gzip_compress(buffer.data(), buffer.size(), compressed, m_gzip_level))
+    {
+        return false;
+    }
+    return f->write(0, compressed);
 }
 
 std::string QuantizedMeshWriter::file_extension()
@@ -4,19 +4,19 @@
 #include "tntn/logging.h"
 #include "tntn/tntn_assert.h"
 #include "tntn/BinaryIO.h"
+#include "tntn/MercatorToEcef.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <fstream>
 #include <set>
 
 #include <unordered_map>
 #include "glm/glm.hpp"
 
-#include <ogr_spatialref.h>
-#include <gdal_priv.h>
-
-//FIXME: remove collappsed vertices/triangles after quantization of mesh
-
 namespace tntn {
 
 typedef glm::dvec3 QMVertex;
@@ -103,15 +103,208 @@ int16_t zig_zag_decode(uint16_t i)
     return static_cast<int16_t>(i >> 1) ^ -static_cast<int16_t>(i & 1);
 }
 
+static double distance2(const glm::dvec3& a, const glm::dvec3& b)
+{
+    const glm::dvec3 d = a - b;
+    return glm::dot(d, d);
+}
+
+void compute_bounding_sphere(const glm::dvec3* points,
+                             const size_t count,
+                             glm::dvec3& center,
+                             double& radius)
+{
+    center = glm::dvec3(0.0);
+    radius = 0.0;
+    if(count == 0)
+    {
+        return;
+    }
+
+    // points with the smallest and largest coordinate along each axis
+    glm::dvec3 bbox_min = points[0];
+    glm::dvec3 bbox_max = points[0];
+    size_t min_index[3] = {0, 0, 0};
+    size_t max_index[3] = {0, 0, 0};
+    for(size_t i = 1; i < count; i++)
+    {
+        const glm::dvec3& p = points[i];
+        for(int axis = 0; axis < 3; axis++)
+        {
+            if(p[axis] < bbox_min[axis])
+            {
+                bbox_min[axis] = p[axis];
+                min_index[axis] = i;
+            }
+            if(p[axis] > bbox_max[axis])
+            {
+                bbox_max[axis] = p[axis];
+                max_index[axis] = i;
+            }
+        }
+    }
+
+    // Ritter: start with the most distant pair of extreme points...
+    int widest_axis = 0;
+    double widest_span = -1.0;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const double span = distance2(points[min_index[axis]], points[max_index[axis]]);
+        if(span > widest_span)
+        {
+            widest_span = span;
+            widest_axis = axis;
+        }
+    }
+    glm::dvec3 ritter_center =
+        (points[min_index[widest_axis]] + points[max_index[widest_axis]]) / 2.0;
+    double ritter_radius = std::sqrt(widest_span) / 2.0;
+
+    // ...and grow the sphere just enough to include each point outside of it
+    double ritter_radius2 = ritter_radius * ritter_radius;
+    for(size_t i = 0; i < count; i++)
+    {
+        const double d2 = distance2(points[i], ritter_center);
+        if(d2 > ritter_radius2)
+        {
+            const double d = std::sqrt(d2);
+            const double new_radius = (ritter_radius + d) / 2.0;
+            ritter_center += (points[i] - ritter_center) * ((d - new_radius) / d);
+            ritter_radius = new_radius;
+            ritter_radius2 = new_radius * new_radius;
+        }
+    }
+
+    // the box center sphere is tighter for some distributions, e.g. regular grids
+    const glm::dvec3 box_center = (bbox_min + bbox_max) / 2.0;
+    double box_radius2 = 0.0;
+    for(size_t i = 0; i < count; i++)
+    {
+        box_radius2 = std::max(box_radius2, distance2(points[i], box_center));
+    }
+    const double box_radius = std::sqrt(box_radius2);
+
+    if(box_radius < ritter_radius)
+    {
+        center = box_center;
+        radius = box_radius;
+    }
+    else
+    {
+        center = ritter_center;
+        radius = ritter_radius;
+    }
+}
+
+// WGS84 semi axes
+static constexpr double ellipsoid_radius_xy = 6378137.0;
+static constexpr double ellipsoid_radius_z = 6356752.3142451793;
+
+bool compute_horizon_occlusion_point(const glm::dvec3* points,
+                                     const size_t count,
+                                     const glm::dvec3& direction,
+                                     glm::dvec3& occlusion_point)
+{
+    const glm::dvec3 inverse_radii(
+        1.0 / ellipsoid_radius_xy, 1.0 / ellipsoid_radius_xy, 1.0 / ellipsoid_radius_z);
+
+    // in scaled space the ellipsoid is the unit sphere
+    const glm::dvec3 scaled_direction = direction * inverse_radii;
+    if(count == 0 || glm::length(scaled_direction) == 0.0)
+    {
+        return false;
+    }
+    const glm::dvec3 d = glm::normalize(scaled_direction);
+
+    // the occlusion point is at the largest distance along d needed to hide any of the points,
+    // for each point that distance is 1 / cos(alpha + beta), alpha being the angle between the
+    // point and d and beta the angle between the point and its horizon
+    double max_magnitude = 0.0;
+    double min_denominator = std::numeric_limits<double>::infinity();
+    for(size_t i = 0; i < count; i++)
+    {
+        const glm::dvec3 p = points[i] * inverse_radii;
+        const double magnitude2 = glm::dot(p, p);
+        const double magnitude = std::sqrt(magnitude2);
+        const double inverse_magnitude = 1.0 / magnitude;
+
+        const double cos_alpha = glm::dot(p, d) * inverse_magnitude;
+        const double sin_alpha = glm::length(glm::cross(p, d)) * inverse_magnitude;
+        const double cos_beta = std::min(1.0, inverse_magnitude);
+        const double sin_beta = std::sqrt(std::max(1.0, magnitude2) - 1.0) * cos_beta;
+
+        const double denominator = cos_alpha * cos_beta - sin_alpha * sin_beta;
+        min_denominator = std::min(min_denominator, denominator);
+        max_magnitude = std::max(max_magnitude, 1.0 / denominator);
+    }
+
+    // a point at or beyond 90 degrees from d can not be hidden by a point along d
+    if(!(min_denominator > 0.0) || !std::isfinite(max_magnitude))
+    {
+        return false;
+    }
+
+    occlusion_point = d * max_magnitude;
+    return true;
+}
+
+static double sign_not_zero(const double v)
+{
+    return v < 0.0 ? -1.0 : 1.0;
+}
+
+static uint8_t to_snorm(const double v)
+{
+    const double clamped = std::max(-1.0, std::min(v, 1.0));
+    return static_cast<uint8_t>(std::round((clamped * 0.5 + 0.5) * 255.0));
+}
+
+static double from_snorm(const uint8_t v)
+{
+    return v / 255.0 * 2.0 - 1.0;
+}
+
+void oct_encode(const glm::dvec3& normal, uint8_t& x, uint8_t& y)
+{
+    // project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the upper
+    const glm::dvec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+    double ox = n.x;
+    double oy = n.y;
+    if(n.z < 0.0)
+    {
+        ox = (1.0 - std::abs(n.y)) * sign_not_zero(n.x);
+        oy = (1.0 - std::abs(n.x)) * sign_not_zero(n.y);
+    }
+    x = to_snorm(ox);
+    y = to_snorm(oy);
+}
+
+glm::dvec3 oct_decode(const uint8_t x, const uint8_t y)
+{
+    glm::dvec3 n(from_snorm(x), from_snorm(y), 0.0);
+    n.z = 1.0 - (std::abs(n.x) + std::abs(n.y));
+    if(n.z < 0.0)
+    {
+        const double old_x = n.x;
+        n.x = (1.0 - std::abs(n.y)) * sign_not_zero(old_x);
+        n.y = (1.0 - std::abs(old_x)) * sign_not_zero(n.y);
+    }
+    return glm::normalize(n);
+}
+
 } //namespace detail
 
 using namespace detail;
 
 constexpr int QUANTIZED_COORDINATE_SIZE = 32767;
 
+// extension ids of the quantized-mesh format
+constexpr uint8_t OCT_VERTEX_NORMALS_EXTENSION_ID = 1;
+
+// snaps to the nearest grid point
 static unsigned int scale_coordinate(const double v)
 {
-    const int scaled_v = static_cast<int>(v * QUANTIZED_COORDINATE_SIZE);
+    const int scaled_v = static_cast<int>(std::lround(v * QUANTIZED_COORDINATE_SIZE));
     return scaled_v;
 }
 
@@ -183,39 +376,32 @@ template<typename IndexType>
 static void write_faces(BinaryIO& bio,
                         BinaryIOErrorTracker& e,
                         QuantizedMeshLog& log,
-                        const SimpleRange<const Triangle*>& tris,
-                        const VertexOrdering& order)
+                        const std::vector<uint32_t>& ordered_indices)
 {
     typedef IndexType index_t;
 
     log.IndexData_bits = sizeof(index_t) * 8;
 
-    const uint32_t ntriangles = tris.distance();
+    const uint32_t ntriangles = ordered_indices.size() / 3;
 
     std::vector<index_t> indices;
 
-    indices.reserve(static_cast<size_t>(ntriangles) * 3);
+    indices.reserve(ordered_indices.size());
 
     // High-water mark encode triangle indices
     index_t watermark = 0;
-    for(auto it = tris.begin; it != tris.end; ++it)
+    for(const uint32_t i : ordered_indices)
     {
-        for(int n = 0; n < 3; ++n)
-        {
-            const Vertex& v = (*it)[n];
-            const auto order_v_it = order.find(v);
-            TNTN_ASSERT(order_v_it != order.end());
-            TNTN_ASSERT(order_v_it->second <= std::numeric_limits<index_t>::max());
+        TNTN_ASSERT(i <= std::numeric_limits<index_t>::max());
 
-            const index_t index = order_v_it->second;
-            TNTN_ASSERT((int64_t)watermark - (int64_t)index >= 0);
-            const index_t delta = watermark - index;
+        const index_t index = i;
+        TNTN_ASSERT((int64_t)watermark - (int64_t)index >= 0);
+        const index_t delta = watermark - index;
 
-            indices.push_back(delta);
-            if(index == watermark)
-            {
-                watermark++;
-            }
+        indices.push_back(delta);
+        if(index == watermark)
+        {
+            watermark++;
         }
     }
 
@@ -241,12 +427,8 @@ static void write_indices(BinaryIO& bio,
 
     bio.write_uint32(nindices, e);
 
-    //TODO specialize write for 16/32bit so 32bit write is fast
-    for(uint32_t i = 0; i < nindices; i++)
-    {
-        const IndexType index = indices[i];
-        bio.write(index, e);
-    }
+    const std::vector<IndexType> narrowed(indices.begin(), indices.end());
+    bio.write_array(narrowed, e);
 }
 
 bool write_mesh_as_qm(const char* filename, const Mesh& m)
@@ -298,23 +480,182 @@ static void write_qmheader(BinaryIO& bio,
     bio.write_double(qmheader.horizon_occlusion.z, e);
 }
 
-bool point_to_ecef(Vertex& p)
+/**
+ vertices in order of first use by the triangles and the triangle corners as indices
+ into that order, as required by the high-water mark encoding
+ */
+struct QMVertexOrder
 {
-    OGRSpatialReference mercator;
-    OGRSpatialReference ecef;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    // normals of vertices, empty if the mesh has none
+    std::vector<Normal> normals;
+};
 
-    mercator.importFromEPSG(3857);
-    ecef.importFromEPSG(4978);
+// identifies vertices by hashing their coordinates, for meshes without faces
+static void order_vertices_by_hash(const Mesh& m, QMVertexOrder& order)
+{
+    auto triangles = m.triangles();
 
-    std::unique_ptr<OGRCoordinateTransformation> tr(
-        OGRCreateCoordinateTransformation(&mercator, &ecef));
+    VertexOrdering vertices_order;
+    vertices_order.reserve(triangles.distance() / 2);
+    order.indices.reserve(triangles.distance() * 3);
 
-    if(tr == nullptr)
+    for(auto it = triangles.begin; it != triangles.end; ++it)
     {
-        return false;
+        for(int n = 0; n < 3; ++n)
+        {
+            const Vertex& node = (*it)[n];
+
+            const auto vertices_order_it = vertices_order.find(node);
+            if(vertices_order_it != vertices_order.end())
+            {
+                order.indices.push_back(vertices_order_it->second);
+                continue;
+            }
+
+            const unsigned int vertex_index = order.vertices.size();
+            vertices_order.emplace_hint(vertices_order_it, std::make_pair(node, vertex_index));
+            order.vertices.push_back(node);
+            order.indices.push_back(vertex_index);
+        }
     }
+}
+
+// renumbers the vertices of a decomposed mesh in order of first use, no hashing needed
+static void order_vertices_by_faces(const Mesh& m, QMVertexOrder& order)
+{
+    static constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+    auto vertices = m.vertices();
+    auto faces = m.faces();
+    const Normal* normals = m.has_normals() ? m.normals().begin : nullptr;
 
-    return (bool)tr->Transform(1, &p.x, &p.y, &p.z);
+    std::vector<uint32_t> remap(vertices.distance(), unused);
+    order.vertices.reserve(vertices.distance());
+    order.indices.reserve(faces.distance() * 3);
+    if(normals)
+    {
+        order.normals.reserve(vertices.distance());
+    }
+
+    for(auto it = faces.begin; it != faces.end; ++it)
+    {
+        for(int n = 0; n < 3; ++n)
+        {
+            const size_t v = (*it)[n];
+            TNTN_ASSERT(v < remap.size());
+
+            if(remap[v] == unused)
+            {
+                remap[v] = order.vertices.size();
+                order.vertices.push_back(vertices.begin[v]);
+                if(normals)
+                {
+                    order.normals.push_back(normals[v]);
+                }
+            }
+            order.indices.push_back(remap[v]);
+        }
+    }
+}
+
+// merges vertices that quantize to the same grid point and drops the triangles
+// with zero area on the grid, vertices stay numbered in order of first use
+static void remove_collapsed_after_quantization(QMVertexOrder& order,
+                                                std::vector<glm::ivec3>& quantized)
+{
+    const size_t nvertices = quantized.size();
+
+    // coordinates have 15 bits, sorting the packed grid points brings equal ones together
+    std::vector<std::pair<uint64_t, uint32_t>> keyed(nvertices);
+    for(size_t i = 0; i < nvertices; i++)
+    {
+        const glm::ivec3& q = quantized[i];
+        keyed[i].first = (static_cast<uint64_t>(q.x) << 30) | (static_cast<uint64_t>(q.y) << 15) |
+            static_cast<uint64_t>(q.z);
+        keyed[i].second = i;
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    // each vertex maps to the first used vertex on its grid point
+    std::vector<uint32_t> merged(nvertices);
+    size_t num_merged = 0;
+    for(size_t i = 0; i < nvertices;)
+    {
+        size_t j = i;
+        for(; j < nvertices && keyed[j].first == keyed[i].first; j++)
+        {
+            merged[keyed[j].second] = keyed[i].second;
+        }
+        num_merged += j - i - 1;
+        i = j;
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(order.indices.size());
+    size_t num_collapsed = 0;
+    for(size_t t = 0; t + 2 < order.indices.size(); t += 3)
+    {
+        const uint32_t a = merged[order.indices[t]];
+        const uint32_t b = merged[order.indices[t + 1]];
+        const uint32_t c = merged[order.indices[t + 2]];
+
+        // exact cross product of the edges on the grid
+        const glm::ivec3 e1 = quantized[b] - quantized[a];
+        const glm::ivec3 e2 = quantized[c] - quantized[a];
+        const int64_t cx = int64_t(e1.y) * e2.z - int64_t(e1.z) * e2.y;
+        const int64_t cy = int64_t(e1.z) * e2.x - int64_t(e1.x) * e2.z;
+        const int64_t cz = int64_t(e1.x) * e2.y - int64_t(e1.y) * e2.x;
+        if(cx == 0 && cy == 0 && cz == 0)
+        {
+            num_collapsed++;
+            continue;
+        }
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+
+    if(num_merged == 0 && num_collapsed == 0)
+    {
+        return;
+    }
+
+    // renumber in order of first use, which also drops vertices no triangle uses anymore
+    static constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(nvertices, unused);
+    QMVertexOrder cleaned;
+    std::vector<glm::ivec3> cleaned_quantized;
+    cleaned.vertices.reserve(nvertices);
+    cleaned_quantized.reserve(nvertices);
+    for(uint32_t& i : indices)
+    {
+        if(remap[i] == unused)
+        {
+            remap[i] = cleaned.vertices.size();
+            cleaned.vertices.push_back(order.vertices[i]);
+            cleaned_quantized.push_back(quantized[i]);
+            if(!order.normals.empty())
+            {
+                cleaned.normals.push_back(order.normals[i]);
+            }
+        }
+        i = remap[i];
+    }
+    cleaned.indices.swap(indices);
+
+    TNTN_LOG_INFO(
+        "quantization merged {} vertices and removed {} collapsed triangles, {} of {} "
+        "vertices and {} triangles left",
+        num_merged,
+        num_collapsed,
+        cleaned.vertices.size(),
+        nvertices,
+        cleaned.indices.size() / 3);
+
+    order = std::move(cleaned);
+    quantized.swap(cleaned_quantized);
 }
 
 bool write_mesh_as_qm(const std::shared_ptr<FileLike>& f,
@@ -322,137 +663,178 @@ bool write_mesh_as_qm(const std::shared_ptr<FileLike>& f,
                       const BBox3D& bbox,
                       bool mesh_is_rescaled)
 {
-    if(!m.empty() && !m.has_triangles())
+    if(!m.empty() && !m.has_triangles() && !m.has_decomposed())
     {
         TNTN_LOG_ERROR("Mesh has to be triangulated in order to be written as QM");
         return false;
     }
 
-    BinaryIO bio(f, Endianness::LITTLE);
+    // the tile is assembled in memory and handed to f in one write
+    BinaryIO bio(f, Endianness::LITTLE, true);
     BinaryIOErrorTracker e;
     QuantizedMeshLog log;
 
-    // Write QM Header
-    Vertex c = (bbox.max + bbox.min) / 2.0;
+    // tile center in ECEF
+    const Vertex c = MercatorToEcef::transform((bbox.max + bbox.min) / 2.0);
 
-    if(!point_to_ecef(c))
+    // e.g. the empty bbox of an empty mesh
+    if(!std::isfinite(c.x) || !std::isfinite(c.y) || !std::isfinite(c.z))
     {
         TNTN_LOG_ERROR("Conversion of tile center to ECEF coordinate system failed");
         return false;
     }
 
-    QuantizedMeshHeader header;
-    header.center = c;
-    header.bounding_sphere_center = c;
-    header.BoundingSphereRadius = glm::distance(bbox.min.xy(), bbox.max.xy());
-
-    header.MinimumHeight = bbox.min.z;
-    header.MaximumHeight = bbox.max.z;
-
-    // FIXME: is there a better choice for a horizon occlusion point?
-    // Currently it's the center of tile elevated to bbox's max Z
-    header.horizon_occlusion = c;
-    header.horizon_occlusion.z = bbox.max.z;
+    QMVertexOrder order;
+    if(m.has_decomposed())
+    {
+        order_vertices_by_faces(m, order);
+    }
+    else
+    {
+        order_vertices_by_hash(m, order);
+    }
 
-    log.QuantizedMeshHeader_start = bio.write_pos();
-    write_qmheader(bio, e, header);
-    if(e.has_error())
+    std::vector<glm::ivec3> quantized;
+    quantized.reserve(order.vertices.size());
+    for(const Vertex& node : order.vertices)
     {
-        TNTN_LOG_ERROR("{} in file {}", e.to_string(), f->name());
-        return false;
+        // Rescale coordinates
+        glm::ivec3 q;
+        if(mesh_is_rescaled)
+        {
+            q.x = scale_coordinate(node.x);
+            q.y = scale_coordinate(node.y);
+            q.z = scale_coordinate(node.z);
+        }
+        else
+        {
+            q.x = quantize_coordinate(node.x, bbox.min.x, bbox.max.x);
+            q.y = quantize_coordinate(node.y, bbox.min.y, bbox.max.y);
+            q.z = quantize_coordinate(node.z, bbox.min.z, bbox.max.z);
+        }
+        TNTN_ASSERT(q.x >= 0 && q.x <= QUANTIZED_COORDINATE_SIZE);
+        TNTN_ASSERT(q.y >= 0 && q.y <= QUANTIZED_COORDINATE_SIZE);
+        TNTN_ASSERT(q.z >= 0 && q.z <= QUANTIZED_COORDINATE_SIZE);
+        quantized.push_back(q);
     }
-    TNTN_ASSERT(
-        bio.write_pos() ==
-        sizeof(QuantizedMeshHeader)); //might not be true for some platforms, mostly for debugging
 
-    // Write QM vertex data
+    remove_collapsed_after_quantization(order, quantized);
+
     std::vector<uint32_t> northlings;
     std::vector<uint32_t> eastlings;
     std::vector<uint32_t> southlings;
     std::vector<uint32_t> westlings;
-    VertexOrdering vertices_order;
     std::vector<uint16_t> us;
     std::vector<uint16_t> vs;
     std::vector<uint16_t> hs;
 
-    const uint32_t nvertices = m.vertices().distance();
+    const uint32_t nvertices = order.vertices.size();
 
     us.reserve(nvertices);
     vs.reserve(nvertices);
     hs.reserve(nvertices);
 
-    int u = 0;
-    int v = 0;
-    int h = 0;
+    // vertices as clients decode them, for the bounding volumes
+    std::vector<glm::dvec3> positions;
+    positions.reserve(nvertices);
+    const glm::dvec3 quantization_step =
+        (bbox.max - bbox.min) / static_cast<double>(QUANTIZED_COORDINATE_SIZE);
+
     int prev_u = 0;
     int prev_v = 0;
     int prev_h = 0;
-    int vertex_index = 0;
-
-    auto triangles = m.triangles();
 
-    vertices_order.reserve(triangles.distance() / 2);
-    for(auto it = triangles.begin; it != triangles.end; ++it)
+    for(uint32_t vertex_index = 0; vertex_index < nvertices; vertex_index++)
     {
-        for(int n = 0; n < 3; ++n)
+        const int u = quantized[vertex_index].x;
+        const int v = quantized[vertex_index].y;
+        const int h = quantized[vertex_index].z;
+
+        if(u == 0)
         {
-            const Vertex node = (*it)[n];
+            westlings.push_back(vertex_index);
+        }
+        else if(u == QUANTIZED_COORDINATE_SIZE)
+        {
+            eastlings.push_back(vertex_index);
+        }
 
-            const auto vertices_order_it = vertices_order.find(node);
-            if(vertices_order_it != vertices_order.end()) continue;
+        if(v == 0)
+        {
+            northlings.push_back(vertex_index);
+        }
+        else if(v == QUANTIZED_COORDINATE_SIZE)
+        {
+            southlings.push_back(vertex_index);
+        }
 
-            vertices_order.emplace_hint(vertices_order_it, std::make_pair(node, vertex_index));
+        TNTN_ASSERT(u - prev_u >= -32768 && u - prev_u <= 32767);
+        TNTN_ASSERT(v - prev_v >= -32768 && v - prev_v <= 32767);
+        TNTN_ASSERT(h - prev_h >= -32768 && h - prev_h <= 32767);
 
-            // Rescale coordinates
-            if(mesh_is_rescaled)
-            {
-                u = scale_coordinate(node.x);
-                v = scale_coordinate(node.y);
-                h = scale_coordinate(node.z);
-            }
-            else
-            {
-                u = quantize_coordinate(node.x, bbox.min.x, bbox.max.x);
-                v = quantize_coordinate(node.y, bbox.min.y, bbox.max.y);
-                h = quantize_coordinate(node.z, bbox.min.z, bbox.max.z);
-            }
-            TNTN_ASSERT(u >= 0 && u <= QUANTIZED_COORDINATE_SIZE);
-            TNTN_ASSERT(v >= 0 && v <= QUANTIZED_COORDINATE_SIZE);
-            TNTN_ASSERT(h >= 0 && h <= QUANTIZED_COORDINATE_SIZE);
+        positions.push_back(bbox.min + glm::dvec3(u, v, h) * quantization_step);
 
-            if(u == 0)
-            {
-                westlings.push_back(vertex_index);
-            }
-            else if(u == QUANTIZED_COORDINATE_SIZE)
-            {
-                eastlings.push_back(vertex_index);
-            }
+        us.push_back(zig_zag_encode(u - prev_u));
+        vs.push_back(zig_zag_encode(v - prev_v));
+        hs.push_back(zig_zag_encode(h - prev_h));
 
-            if(v == 0)
-            {
-                northlings.push_back(vertex_index);
-            }
-            else if(v == QUANTIZED_COORDINATE_SIZE)
-            {
-                southlings.push_back(vertex_index);
-            }
+        prev_u = u;
+        prev_v = v;
+        prev_h = h;
+    }
 
-            TNTN_ASSERT(u - prev_u >= -32768 && u - prev_u <= 32767);
-            TNTN_ASSERT(v - prev_v >= -32768 && v - prev_v <= 32767);
-            TNTN_ASSERT(h - prev_h >= -32768 && h - prev_h <= 32767);
+    std::vector<uint8_t> oct_normals;
+    oct_normals.resize(order.normals.size() * 2);
+    for(size_t i = 0; i < order.normals.size(); i++)
+    {
+        oct_encode(order.normals[i], oct_normals[2 * i], oct_normals[2 * i + 1]);
+    }
 
-            us.push_back(zig_zag_encode(u - prev_u));
-            vs.push_back(zig_zag_encode(v - prev_v));
-            hs.push_back(zig_zag_encode(h - prev_h));
+    const size_t index_size = nvertices <= 65536 ? 2 : 4;
+    const size_t nedge_indices =
+        westlings.size() + southlings.size() + eastlings.size() + northlings.size();
+    const size_t extensions_size = oct_normals.empty() ? 0 : 1 + 4 + oct_normals.size();
+    bio.reserve_write_buffer(sizeof(QuantizedMeshHeader) + 4 + 3 * 2 * nvertices + 4 + 4 * 4 +
+                             (order.indices.size() + nedge_indices + 2) * index_size +
+                             extensions_size);
 
-            prev_u = u;
-            prev_v = v;
-            prev_h = h;
+    // Write QM Header
+    MercatorToEcef::transform(positions.data(), positions.size());
 
-            vertex_index++;
-        }
+    QuantizedMeshHeader header;
+    header.center = c;
+    header.MinimumHeight = bbox.min.z;
+    header.MaximumHeight = bbox.max.z;
+
+    compute_bounding_sphere(positions.data(),
+                            positions.size(),
+                            header.bounding_sphere_center,
+                            header.BoundingSphereRadius);
+
+    if(!compute_horizon_occlusion_point(positions.data(),
+                                        positions.size(),
+                                        header.bounding_sphere_center,
+                                        header.horizon_occlusion))
+    {
+        // tiles spanning a hemisphere can not be culled against the horizon anyway,
+        // fall back to the tile center on the ellipsoid
+        TNTN_LOG_DEBUG("no horizon occlusion point for tile {}", bbox.to_string());
+        header.horizon_occlusion =
+            c / glm::dvec3(ellipsoid_radius_xy, ellipsoid_radius_xy, ellipsoid_radius_z);
+    }
+
+    log.QuantizedMeshHeader_start = bio.write_pos();
+    write_qmheader(bio, e, header);
+    if(e.has_error())
+    {
+        TNTN_LOG_ERROR("{} in file {}", e.to_string(), f->name());
+        return false;
     }
+    TNTN_ASSERT(
+        bio.write_pos() ==
+        sizeof(QuantizedMeshHeader)); //might not be true for some platforms, mostly for debugging
+
+    // Write QM vertex data
 
     log.VertexData_vertexCount_start = bio.write_pos();
     log.VertexData_vertexCount = nvertices;
@@ -481,7 +863,7 @@ bool write_mesh_as_qm(const std::shared_ptr<FileLike>& f,
     // Write triangle indices data
     if(nvertices <= 65536)
     {
-        write_faces<uint16_t>(bio, e, log, m.triangles(), vertices_order);
+        write_faces<uint16_t>(bio, e, log, order.indices);
         write_indices<uint16_t>(bio, e, westlings);
         write_indices<uint16_t>(bio, e, southlings);
         write_indices<uint16_t>(bio, e, eastlings);
@@ -489,13 +871,22 @@ bool write_mesh_as_qm(const std::shared_ptr<FileLike>& f,
     }
     else
     {
-        write_faces<uint32_t>(bio, e, log, m.triangles(), vertices_order);
+        write_faces<uint32_t>(bio, e, log, order.indices);
         write_indices<uint32_t>(bio, e, westlings);
         write_indices<uint32_t>(bio, e, southlings);
         write_indices<uint32_t>(bio, e, eastlings);
         write_indices<uint32_t>(bio, e, northlings);
     }
 
+    // Write extensions
+    if(!oct_normals.empty())
+    {
+        bio.write_byte(OCT_VERTEX_NORMALS_EXTENSION_ID, e);
+        bio.write_uint32(oct_normals.size(), e);
+        bio.write_array_uint8(oct_normals, e);
+    }
+
+    bio.flush(e);
     if(e.has_error())
     {
         TNTN_LOG_ERROR("{} in file {}", e.to_string(), f->name());
@@ -518,220 +909,283 @@ static BBox3D bbox_from_header(const QuantizedMeshHeader& qmheader)
     return out;
 }
 
-static std::vector<Vertex> decode_qm_vertices(const BBox3D& bbox,
-                                              const std::vector<uint16_t>& u_buffer,
-                                              const std::vector<uint16_t>& v_buffer,
-                                              const std::vector<uint16_t>& height_buffer)
+// little endian loads from possibly unaligned memory, compilers turn them into plain loads
+static inline uint16_t load_uint16(const unsigned char* p)
 {
-    if(!(u_buffer.size() == v_buffer.size() && v_buffer.size() == height_buffer.size()))
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t load_uint32(const unsigned char* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline float load_float(const unsigned char* p)
+{
+    const uint32_t bits = load_uint32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static inline double load_double(const unsigned char* p)
+{
+    const uint64_t bits =
+        static_cast<uint64_t>(load_uint32(p)) | (static_cast<uint64_t>(load_uint32(p + 4)) << 32);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/**
+ bounds checked cursor over the bytes of a tile, hands out pointers into them
+ */
+class QMByteView
+{
+  public:
+    QMByteView(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+
+    size_t pos() const { return m_pos; }
+    size_t remaining() const { return m_size - m_pos; }
+
+    const unsigned char* take(const uint64_t bytes)
     {
-        TNTN_ASSERT(false); //should never happen
-        TNTN_LOG_ERROR("u,v,height must have the same size");
-        return std::vector<Vertex>();
+        if(bytes > remaining())
+        {
+            return nullptr;
+        }
+        const unsigned char* p = m_data + m_pos;
+        m_pos += static_cast<size_t>(bytes);
+        return p;
     }
-    std::vector<Vertex> vx_buffer;
-    vx_buffer.reserve(u_buffer.size());
 
-    int u = 0;
-    int v = 0;
-    int height = 0;
-    for(size_t i = 0; i < u_buffer.size(); i++)
-    {
-        u += zig_zag_decode(u_buffer[i]);
-        v += zig_zag_decode(v_buffer[i]);
-        height += zig_zag_decode(height_buffer[i]);
+  private:
+    const unsigned char* m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+};
+
+static void parse_qmheader(const unsigned char* p, QuantizedMeshHeader& qmheader)
+{
+    qmheader.center = QMVertex(load_double(p), load_double(p + 8), load_double(p + 16));
+
+    qmheader.MinimumHeight = load_float(p + 24);
+    qmheader.MaximumHeight = load_float(p + 28);
+
+    qmheader.bounding_sphere_center =
+        QMVertex(load_double(p + 32), load_double(p + 40), load_double(p + 48));
+    qmheader.BoundingSphereRadius = load_double(p + 56);
+
+    qmheader.horizon_occlusion =
+        QMVertex(load_double(p + 64), load_double(p + 72), load_double(p + 80));
+}
 
-        const double x = dequantize_coordinate(u, bbox.min.x, bbox.max.x);
-        const double y = dequantize_coordinate(v, bbox.min.y, bbox.max.y);
-        const double z = dequantize_coordinate(height, bbox.min.z, bbox.max.z);
+// zig-zag decoding has no dependency between elements and vectorizes,
+// only the running sum over the deltas is sequential
+static void decode_qm_coordinates(const unsigned char* p,
+                                  const size_t count,
+                                  std::vector<int>& coordinates)
+{
+    coordinates.resize(count);
+    int* out = coordinates.data();
+    for(size_t i = 0; i < count; i++)
+    {
+        out[i] = zig_zag_decode(load_uint16(p + 2 * i));
+    }
+    for(size_t i = 1; i < count; i++)
+    {
+        out[i] += out[i - 1];
+    }
+}
 
-        vx_buffer.emplace_back(x, y, z);
+static std::vector<Vertex> decode_qm_vertices(const BBox3D& bbox,
+                                              const unsigned char* vertex_data,
+                                              const size_t vertex_count)
+{
+    std::vector<int> u;
+    std::vector<int> v;
+    std::vector<int> height;
+    decode_qm_coordinates(vertex_data, vertex_count, u);
+    decode_qm_coordinates(vertex_data + 2 * vertex_count, vertex_count, v);
+    decode_qm_coordinates(vertex_data + 4 * vertex_count, vertex_count, height);
+
+    std::vector<Vertex> vx_buffer(vertex_count);
+    for(size_t i = 0; i < vertex_count; i++)
+    {
+        vx_buffer[i].x = dequantize_coordinate(u[i], bbox.min.x, bbox.max.x);
+        vx_buffer[i].y = dequantize_coordinate(v[i], bbox.min.y, bbox.max.y);
+        vx_buffer[i].z = dequantize_coordinate(height[i], bbox.min.z, bbox.max.z);
     }
 
     return vx_buffer;
 }
 
-template<typename ElemT>
-static void decode_qm_faces_impl(const std::vector<ElemT>& indices,
-                                 std::vector<Face>& face_buffer)
+// high-water mark decoding, fails on indices beyond vertex_count
+template<typename IndexType>
+static bool decode_qm_faces(const unsigned char* index_data,
+                            const size_t triangle_count,
+                            const size_t vertex_count,
+                            std::vector<Face>& faces)
 {
-    int highest = 0;
-    for(size_t i = 0; i < indices.size(); i += 3)
+    faces.resize(triangle_count);
+
+    size_t highest = 0;
+    for(size_t i = 0; i < triangle_count; i++)
     {
-        Face f;
+        Face& f = faces[i];
         for(size_t k = 0; k < 3; k++)
         {
-            const int code = indices[i + k];
+            const unsigned char* p = index_data + (3 * i + k) * sizeof(IndexType);
+            const size_t code = sizeof(IndexType) == 2 ? load_uint16(p) : load_uint32(p);
+            if(code > highest)
+            {
+                return false;
+            }
             f[k] = highest - code;
             if(code == 0)
             {
                 highest++;
             }
         }
-        face_buffer.push_back(f);
     }
+    return highest <= vertex_count;
 }
 
-static std::vector<Face> decode_qm_faces(const std::vector<uint16_t>& indices16,
-                                         const std::vector<uint32_t>& indices32)
+static std::unique_ptr<Mesh> decode_qm(const unsigned char* data,
+                                       const size_t size,
+                                       const std::string& name)
 {
-    std::vector<Face> face_buffer;
-    face_buffer.reserve(indices16.size() / 3 + indices32.size() / 3);
-    decode_qm_faces_impl(indices16, face_buffer);
-    decode_qm_faces_impl(indices32, face_buffer);
-    return face_buffer;
-}
+    QMByteView view(data, size);
 
-static void read_qmheader(BinaryIO& bio, BinaryIOErrorTracker& e, QuantizedMeshHeader& qmheader)
-{
-    bio.read_double(qmheader.center.x, e);
-    bio.read_double(qmheader.center.y, e);
-    bio.read_double(qmheader.center.z, e);
-
-    bio.read_float(qmheader.MinimumHeight, e);
-    bio.read_float(qmheader.MaximumHeight, e);
-
-    bio.read_double(qmheader.bounding_sphere_center.x, e);
-    bio.read_double(qmheader.bounding_sphere_center.y, e);
-    bio.read_double(qmheader.bounding_sphere_center.z, e);
-    bio.read_double(qmheader.BoundingSphereRadius, e);
+    const unsigned char* header_data = view.take(sizeof(QuantizedMeshHeader));
+    if(header_data == nullptr)
+    {
+        TNTN_LOG_ERROR("file {} is too short for QuantizedMeshHeader", name);
+        return std::unique_ptr<Mesh>();
+    }
+    QuantizedMeshHeader qmheader;
+    parse_qmheader(header_data, qmheader);
 
-    bio.read_double(qmheader.horizon_occlusion.x, e);
-    bio.read_double(qmheader.horizon_occlusion.y, e);
-    bio.read_double(qmheader.horizon_occlusion.z, e);
-}
+    //VertexData
+    const unsigned char* p = view.take(4);
+    if(p == nullptr)
+    {
+        TNTN_LOG_ERROR("file {} ends during VertexData::vertexCount", name);
+        return std::unique_ptr<Mesh>();
+    }
+    const uint32_t vertex_count = load_uint32(p);
+    TNTN_LOG_DEBUG("vertex_count: {}", vertex_count);
 
-static bool read_qm_data(const std::shared_ptr<FileLike>& f,
-                         QuantizedMeshHeader& qmheader,
-                         std::vector<uint16_t>& vertex_data_u,
-                         std::vector<uint16_t>& vertex_data_v,
-                         std::vector<uint16_t>& vertex_data_height,
-                         std::vector<uint16_t>& indices16,
-                         std::vector<uint32_t>& indices32)
-{
-    if(!f->is_good())
+    const unsigned char* vertex_data = view.take(uint64_t(6) * vertex_count);
+    if(vertex_data == nullptr)
     {
-        TNTN_LOG_ERROR("input file {} is not open/good", f->name());
-        return false;
+        TNTN_LOG_ERROR("file {} ends during VertexData::u/v/height", name);
+        return std::unique_ptr<Mesh>();
     }
 
-    BinaryIO bio(f, Endianness::LITTLE);
-    BinaryIOErrorTracker e;
-    QuantizedMeshLog log;
+    // padding
+    const size_t index_size = vertex_count <= 65536 ? 2 : 4;
+    if(view.pos() % index_size != 0 && view.take(index_size - view.pos() % index_size) == nullptr)
+    {
+        TNTN_LOG_ERROR("file {} ends during IndexData padding", name);
+        return std::unique_ptr<Mesh>();
+    }
 
-    log.QuantizedMeshHeader_start = bio.read_pos();
-    read_qmheader(bio, e, qmheader);
-    if(e.has_error())
+    //Index Data
+    p = view.take(4);
+    if(p == nullptr)
     {
-        TNTN_LOG_ERROR("{} on file {} during QuantizedMeshHeader", e.to_string(), f->name());
-        return false;
+        TNTN_LOG_ERROR("file {} ends during IndexData::triangleCount", name);
+        return std::unique_ptr<Mesh>();
     }
+    const uint32_t triangle_count = load_uint32(p);
 
-    //VertexData
-    uint32_t vertex_count = 0;
-    log.VertexData_vertexCount_start = bio.read_pos();
-    bio.read_uint32(vertex_count, e);
-    if(e.has_error())
+    const unsigned char* index_data = view.take(uint64_t(3) * triangle_count * index_size);
+    if(index_data == nullptr)
     {
-        TNTN_LOG_ERROR("{} on file {} during VertexData::vertexCount", e.to_string(), f->name());
-        return false;
+        TNTN_LOG_ERROR("file {} ends during IndexData::indices", name);
+        return std::unique_ptr<Mesh>();
     }
-    TNTN_LOG_DEBUG("vertex_count: {}", vertex_count);
-    log.VertexData_vertexCount = vertex_count;
 
-    if(vertex_count > 0)
+    // edge indices are not needed to rebuild the mesh
+    for(int edge = 0; edge < 4; edge++)
     {
-        log.VertexData_u_start = bio.read_pos();
-        bio.read_array_uint16(vertex_data_u, vertex_count, e);
-        if(e.has_error())
+        p = view.take(4);
+        if(p == nullptr || view.take(uint64_t(load_uint32(p)) * index_size) == nullptr)
         {
-            TNTN_LOG_ERROR("{} on file {} during VertexData::u", e.to_string(), f->name());
-            return false;
+            TNTN_LOG_ERROR("file {} ends during EdgeIndices", name);
+            return std::unique_ptr<Mesh>();
         }
+    }
 
-        log.VertexData_v_start = bio.read_pos();
-        bio.read_array_uint16(vertex_data_v, vertex_count, e);
-        if(e.has_error())
+    // extensions follow until the end of the file
+    const unsigned char* oct_normals = nullptr;
+    while(view.remaining() > 0)
+    {
+        p = view.take(5);
+        const unsigned char* extension_data = p ? view.take(load_uint32(p + 1)) : nullptr;
+        if(extension_data == nullptr)
         {
-            TNTN_LOG_ERROR("{} on file {} during VertexData::v", e.to_string(), f->name());
-            return false;
+            TNTN_LOG_ERROR("file {} ends during extension", name);
+            return std::unique_ptr<Mesh>();
         }
 
-        log.VertexData_height_start = bio.read_pos();
-        bio.read_array_uint16(vertex_data_height, vertex_count, e);
-        if(e.has_error())
+        const uint8_t extension_id = p[0];
+        const uint32_t extension_length = load_uint32(p + 1);
+        if(extension_id == OCT_VERTEX_NORMALS_EXTENSION_ID &&
+           extension_length == uint64_t(2) * vertex_count)
         {
-            TNTN_LOG_ERROR("{} on file {} during VertexData::height", e.to_string(), f->name());
-            return false;
+            oct_normals = extension_data;
+        }
+        else
+        {
+            TNTN_LOG_DEBUG("skipping extension {} of {} bytes", extension_id, extension_length);
         }
     }
 
-    // padding
-    const size_t alignment = vertex_count <= 65536 ? 2 : 4;
-    const auto read_pos = bio.read_pos();
-    if(read_pos % alignment != 0)
-    {
-        int pad_size = alignment - (read_pos % alignment);
-        bio.read_skip(pad_size, e);
-    }
+    const BBox3D header_bbox = bbox_from_header(qmheader);
+    TNTN_LOG_DEBUG("bbox derived from header: {}", header_bbox.to_string());
 
-    //Index Data
-    uint32_t triangle_count = 0;
-    log.IndexData_triangleCount_start = bio.read_pos();
-    bio.read_uint32(triangle_count, e);
-    if(e.has_error())
+    std::vector<Vertex> vertices = decode_qm_vertices(header_bbox, vertex_data, vertex_count);
+
+    std::vector<Face> faces;
+    const bool faces_valid = index_size == 2
+        ? decode_qm_faces<uint16_t>(index_data, triangle_count, vertex_count, faces)
+        : decode_qm_faces<uint32_t>(index_data, triangle_count, vertex_count, faces);
+    if(!faces_valid)
     {
-        TNTN_LOG_ERROR(
-            "{} on file {} during IndexData(16/32)::triangleCount", e.to_string(), f->name());
-        return false;
+        TNTN_LOG_ERROR("file {} has triangle indices out of range", name);
+        return std::unique_ptr<Mesh>();
     }
-    log.IndexData_triangleCount = triangle_count;
 
-    if(triangle_count > 0)
+    TNTN_LOG_DEBUG("{} vertices, {} faces after decoding", vertices.size(), faces.size());
+
+    auto mesh = std::make_unique<Mesh>();
+    mesh->from_decomposed(std::move(vertices), std::move(faces));
+
+    if(oct_normals)
     {
-        if(vertex_count <= 65536)
+        std::vector<Normal> normals(vertex_count);
+        for(size_t i = 0; i < vertex_count; i++)
         {
-            log.IndexData_bits = 16;
-            log.IndexData_indices_start = bio.read_pos();
-            bio.read_array_uint16(indices16, static_cast<size_t>(triangle_count) * 3, e);
-            if(e.has_error())
-            {
-                TNTN_LOG_ERROR(
-                    "{} on file {} during IndexData16::indices", e.to_string(), f->name());
-                return false;
-            }
-        }
-        else
-        {
-            log.IndexData_bits = 32;
-            log.IndexData_indices_start = bio.read_pos();
-            bio.read_array_uint32(indices32, static_cast<size_t>(triangle_count) * 3, e);
-            if(e.has_error())
-            {
-                TNTN_LOG_ERROR(
-                    "{} on file {} during IndexData32::indices", e.to_string(), f->name());
-                return false;
-            }
+            normals[i] = oct_decode(oct_normals[2 * i], oct_normals[2 * i + 1]);
         }
+        mesh->set_normals(std::move(normals));
     }
-    //TODO edge indices
 
-    //TODO extensions
-
-    if(e.has_error())
     {
-        TNTN_LOG_ERROR("{} on file {}", e.to_string(), f->name());
-        return false;
+        BBox3D mesh_bbox;
+        mesh->get_bbox(mesh_bbox);
+        TNTN_LOG_DEBUG("bbox derived from resulting mesh: {}", mesh_bbox.to_string());
     }
-
-    TNTN_LOG_INFO("reader log: {}", log.to_string());
-    return true;
+    return mesh;
 }
 
 std::unique_ptr<Mesh> load_mesh_from_qm(const char* filename)
 {
-    auto f = std::make_shared<File>();
-    if(!f->open(filename, File::OM_R))
+    auto f = std::make_shared<MappedFile>();
+    if(!f->open(filename))
     {
         TNTN_LOG_ERROR("unable to open quantized mesh in file {}", filename);
         return std::unique_ptr<Mesh>();
@@ -741,45 +1195,33 @@ std::unique_ptr<Mesh> load_mesh_from_qm(const char* filename)
 
 std::unique_ptr<Mesh> load_mesh_from_qm(const std::shared_ptr<FileLike>& f)
 {
-    QuantizedMeshHeader qmheader;
-    std::vector<uint16_t> vertex_data_u;
-    std::vector<uint16_t> vertex_data_v;
-    std::vector<uint16_t> vertex_data_height;
-    std::vector<uint16_t> indices16;
-    std::vector<uint32_t> indices32;
-
-    TNTN_LOG_DEBUG("reading QuantizedMesh data...");
-    if(!read_qm_data(
-           f, qmheader, vertex_data_u, vertex_data_v, vertex_data_height, indices16, indices32))
+    if(!f->is_good())
     {
-        TNTN_LOG_ERROR("error reading quantized mesh data from file {}", f->name());
+        TNTN_LOG_ERROR("input file {} is not open/good", f->name());
         return std::unique_ptr<Mesh>();
     }
-    TNTN_LOG_DEBUG(
-        "before decoding: VertexData::u.size={} VertexData::v.size={} VertexData::height.size={} IndicesData16::indices.size={} IndicesData32::indices.size={}",
-        vertex_data_u.size(),
-        vertex_data_v.size(),
-        vertex_data_height.size(),
-        indices16.size(),
-        indices32.size());
 
-    const BBox3D header_bbox = bbox_from_header(qmheader);
-    TNTN_LOG_DEBUG("bbox derived from header: {}", header_bbox.to_string());
-
-    std::vector<Vertex> vertices =
-        decode_qm_vertices(header_bbox, vertex_data_u, vertex_data_v, vertex_data_height);
-
-    std::vector<Face> faces = decode_qm_faces(indices16, indices32);
-
-    TNTN_LOG_DEBUG("{} vertices, {} faces after decoding", vertices.size(), faces.size());
+    TNTN_LOG_DEBUG("reading QuantizedMesh data...");
 
-    auto mesh = std::make_unique<Mesh>();
-    mesh->from_decomposed(std::move(vertices), std::move(faces));
+    // decode in place if the bytes are in memory already, e.g. for a MappedFile
+    const size_t size = f->size();
+    const unsigned char* data = f->data();
+    std::vector<unsigned char> buffer;
+    if(data == nullptr && size > 0)
+    {
+        f->read(0, buffer, size);
+        if(buffer.size() != size)
+        {
+            TNTN_LOG_ERROR("unable to read quantized mesh data from file {}", f->name());
+            return std::unique_ptr<Mesh>();
+        }
+        data = buffer.data();
+    }
 
+    auto mesh = decode_qm(data, size, f->name());
+    if(!mesh)
     {
-        BBox3D mesh_bbox;
-        mesh->get_bbox(mesh_bbox);
-        TNTN_LOG_DEBUG("bbox derived from resulting mesh: {}", mesh_bbox.to_string());
+        TNTN_LOG_ERROR("error reading quantized mesh data from file {}", f->name());
     }
     return mesh;
 }
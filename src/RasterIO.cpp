@@ -10,6 +10,8 @@
 #include <fstream>
 #include <stdio.h>
 #include <iomanip>
+#include <mutex>
+#include <vector>
 
 #include <ogr_spatialref.h>
 #include <gdal_priv.h>
@@ -344,9 +346,11 @@ static bool is_valid_projection(GDALDataset* dataset)
     return matched;
 }
 
-bool load_raster_file(const std::string& file_name,
-                      RasterDouble& target_raster,
-                      bool validate_projection)
+// opens file_name and checks that it can be processed, i.e. has a geotransformation with
+// square pixels, is in EPSG:3857 (if validate_projection) and has at least one raster band
+static GDALDataset_ptr open_raster_dataset(const std::string& file_name,
+                                           bool validate_projection,
+                                           TransformationMatrix& gt)
 {
     initialize_gdal_once();
 
@@ -354,18 +358,17 @@ bool load_raster_file(const std::string& file_name,
 
     GDALDataset_ptr dataset(static_cast<GDALDataset*>(GDALOpen(file_name.c_str(), GA_ReadOnly)),
                             &GDALClose_wrapper);
+    GDALDataset_ptr invalid(nullptr, &GDALClose_wrapper);
 
     if(dataset == nullptr)
     {
         TNTN_LOG_ERROR("Can't open input raster {}: ", file_name);
-        return false;
+        return invalid;
     }
 
-    TransformationMatrix gt;
-
     if(!get_transformation_matrix(dataset.get(), gt))
     {
-        return false;
+        return invalid;
     }
 
     if(validate_projection && !is_valid_projection(dataset.get()))
@@ -374,7 +377,7 @@ bool load_raster_file(const std::string& file_name,
         println("you can reproject raster terrain using GDAL");
         println("as follows: 'gdalwarp -t_srs EPSG:3857 input.tif output.tif'");
 
-        return false;
+        return invalid;
     }
 
     int bands_count = dataset->GetRasterCount();
@@ -382,7 +385,7 @@ bool load_raster_file(const std::string& file_name,
     if(bands_count == 0)
     {
         TNTN_LOG_ERROR("Can't process a raster file witout raster bands");
-        return false;
+        return invalid;
     }
     else if(bands_count > 1)
     {
@@ -391,6 +394,51 @@ bool load_raster_file(const std::string& file_name,
                       bands_count);
     }
 
+    return dataset;
+}
+
+// types whose values are all exactly representable as float
+static bool is_single_precision_type(const GDALDataType data_type)
+{
+    switch(data_type)
+    {
+        case GDT_Byte:
+        case GDT_UInt16:
+        case GDT_Int16:
+        case GDT_Float32: return true;
+        default: return false;
+    }
+}
+
+bool is_single_precision_raster_file(const std::string& file_name)
+{
+    initialize_gdal_once();
+
+    GDALDataset_ptr dataset(static_cast<GDALDataset*>(GDALOpen(file_name.c_str(), GA_ReadOnly)),
+                            &GDALClose_wrapper);
+    if(dataset == nullptr || dataset->GetRasterCount() == 0)
+    {
+        return false;
+    }
+
+    return is_single_precision_type(dataset->GetRasterBand(1)->GetRasterDataType());
+}
+
+// reads band 1 converted to data_type, which has to match T
+template<typename T>
+static bool load_raster_band(const std::string& file_name,
+                             Raster<T>& target_raster,
+                             bool validate_projection,
+                             GDALDataType data_type)
+{
+    TransformationMatrix gt;
+    GDALDataset_ptr dataset = open_raster_dataset(file_name, validate_projection, gt);
+
+    if(dataset == nullptr)
+    {
+        return false;
+    }
+
     // TODO: Perhaps make raster band number a parameter
     GDALRasterBand* raster_band = dataset->GetRasterBand(1);
 
@@ -410,7 +458,7 @@ bool load_raster_file(const std::string& file_name,
                              target_raster.get_ptr(),
                              raster_width,
                              raster_height,
-                             GDT_Float64,
+                             data_type,
                              0,
                              0) != CE_None)
     {
@@ -440,4 +488,148 @@ bool load_raster_file(const std::string& file_name,
     return true;
 }
 
+bool load_raster_file(const std::string& file_name,
+                      RasterDouble& target_raster,
+                      bool validate_projection)
+{
+    return load_raster_band(file_name, target_raster, validate_projection, GDT_Float64);
+}
+
+bool load_raster_file(const std::string& file_name,
+                      RasterFloat& target_raster,
+                      bool validate_projection)
+{
+    return load_raster_band(file_name, target_raster, validate_projection, GDT_Float32);
+}
+
+namespace {
+
+class GDALWindowedRaster : public BlockCachedWindowedRaster
+{
+  public:
+    GDALWindowedRaster(const std::string& file_name,
+                       GDALDataset_ptr dataset,
+                       const TransformationMatrix& gt) :
+        m_file_name(file_name)
+    {
+        GDALRasterBand* band = dataset->GetRasterBand(1);
+        const int width = band->GetXSize();
+        const int height = band->GetYSize();
+
+        double x1 = gt.origin_x;
+        double y1 = gt.origin_y;
+        double x2 = gt.origin_x + width * gt.scale_x;
+        double y2 = gt.origin_y + height * gt.scale_y;
+
+        // same geometry as load_raster_file produces
+        set_geometry(width,
+                     height,
+                     std::min(x1, x2),
+                     std::min(y1, y2),
+                     fabs(gt.scale_x),
+                     band->GetNoDataValue());
+
+        int block_width = 0;
+        int block_height = 0;
+        band->GetBlockSize(&block_width, &block_height);
+        set_block_layout(block_width, block_height, gt.scale_x < 0, gt.scale_y > 0);
+        set_single_precision(is_single_precision_type(band->GetRasterDataType()));
+
+        TNTN_LOG_DEBUG("windowed raster {}x{} with blocks of {}x{}",
+                       width,
+                       height,
+                       block_width,
+                       block_height);
+
+        m_datasets.push_back(std::move(dataset));
+    }
+
+    using BlockCachedWindowedRaster::set_cache_budget;
+
+  protected:
+    bool read_block(int x, int y, int w, int h, double* dst) override
+    {
+        return read_band(x, y, w, h, dst, GDT_Float64);
+    }
+
+    bool read_block_float(int x, int y, int w, int h, float* dst) override
+    {
+        return read_band(x, y, w, h, dst, GDT_Float32);
+    }
+
+  private:
+    bool read_band(int x, int y, int w, int h, void* dst, GDALDataType data_type)
+    {
+        GDALDataset_ptr dataset = acquire_dataset();
+        if(!dataset)
+        {
+            return false;
+        }
+
+        GDALRasterBand* band = dataset->GetRasterBand(1);
+        const bool ok =
+            band->RasterIO(GF_Read, x, y, w, h, dst, w, h, data_type, 0, 0) == CE_None;
+        release_dataset(std::move(dataset));
+
+        if(!ok)
+        {
+            TNTN_LOG_ERROR("Can not read raster data at ({},{}) size {}x{}", x, y, w, h);
+        }
+        return ok;
+    }
+
+    // a GDAL dataset must not be used by several threads at once,
+    // so concurrent block reads each take a dataset of their own
+    GDALDataset_ptr acquire_dataset()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_datasets_mutex);
+            if(!m_datasets.empty())
+            {
+                GDALDataset_ptr dataset = std::move(m_datasets.back());
+                m_datasets.pop_back();
+                return dataset;
+            }
+        }
+
+        GDALDataset_ptr dataset(
+            static_cast<GDALDataset*>(GDALOpen(m_file_name.c_str(), GA_ReadOnly)),
+            &GDALClose_wrapper);
+        if(dataset == nullptr)
+        {
+            TNTN_LOG_ERROR("Can't open input raster {}: ", m_file_name);
+        }
+        return dataset;
+    }
+
+    void release_dataset(GDALDataset_ptr dataset)
+    {
+        std::lock_guard<std::mutex> lock(m_datasets_mutex);
+        m_datasets.push_back(std::move(dataset));
+    }
+
+    std::string m_file_name;
+    std::mutex m_datasets_mutex;
+    // datasets not in use by a read, one per thread that has read concurrently
+    std::vector<GDALDataset_ptr> m_datasets;
+};
+
+} // namespace
+
+std::unique_ptr<BlockCachedWindowedRaster> open_windowed_raster_file(
+    const std::string& file_name, size_t cache_budget_bytes, bool validate_projection)
+{
+    TransformationMatrix gt;
+    GDALDataset_ptr dataset = open_raster_dataset(file_name, validate_projection, gt);
+
+    if(dataset == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto raster = std::make_unique<GDALWindowedRaster>(file_name, std::move(dataset), gt);
+    raster->set_cache_budget(cache_budget_bytes);
+    return std::move(raster);
+}
+
 } // namespace tntn
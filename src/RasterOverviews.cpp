@@ -8,11 +8,17 @@
 
 namespace tntn {
 
-RasterOverviews::RasterOverviews(UniqueRasterPointer input_raster, int min_zoom, int max_zoom) :
+template<typename T>
+BasicRasterOverviews<T>::BasicRasterOverviews(std::unique_ptr<Raster<T>> input_raster,
+                                              int min_zoom,
+                                              int max_zoom,
+                                              OverviewMode mode,
+                                              ThreadPool* thread_pool) :
     m_base_raster(std::move(input_raster)),
+    m_mode(mode),
+    m_thread_pool(thread_pool),
     m_min_zoom(min_zoom),
     m_max_zoom(max_zoom),
-    m_estimated_min_zoom(0),
     m_estimated_max_zoom(0)
 {
     compute_zoom_levels();
@@ -20,7 +26,8 @@ RasterOverviews::RasterOverviews(UniqueRasterPointer input_raster, int min_zoom,
 }
 
 // Guesses (numerically) maximal zoom level from a raster resolution
-int RasterOverviews::guess_max_zoom_level(double resolution)
+template<typename T>
+int BasicRasterOverviews<T>::guess_max_zoom_level(double resolution)
 {
 	// pixel_size_z0 is a magic number that is number of meters per pixel on zoom level 0, given tile size is 256 pixels.
 	// This number is approximate and does not account for latitude, i.e. uses pixel size on equator.
@@ -31,7 +38,10 @@ int RasterOverviews::guess_max_zoom_level(double resolution)
 }
 
 // Guesses (numerically) minimal zoom level from a raster resolution and it's size
-int RasterOverviews::guess_min_zoom_level(int max_zoom_level)
+template<typename T>
+int BasicRasterOverviews<T>::guess_min_zoom_level(int max_zoom_level,
+                                                  unsigned int raster_width,
+                                                  unsigned int raster_height)
 {
 	// This constant is an arbitrary number representing some minimal size to which the raster can be downsized when 'zooming out' a map.
 	// Math is simple:
@@ -40,9 +50,6 @@ int RasterOverviews::guess_min_zoom_level(int max_zoom_level)
 	const int MINIMAL_RASTER_SIZE = 128;
     const double quotient = MINIMAL_RASTER_SIZE * (1 << max_zoom_level);
 
-    int raster_width = m_base_raster->get_width();
-    int raster_height = m_base_raster->get_height();
-
     TNTN_LOG_DEBUG("guess_min_zoom_level: raster_width: {}, raster_height: {}",
                        raster_width,
                        raster_height);
@@ -54,36 +61,87 @@ int RasterOverviews::guess_min_zoom_level(int max_zoom_level)
     return std::max(0, std::min(zoom_x, zoom_y));
 }
 
-void RasterOverviews::compute_zoom_levels()
+template<typename T>
+void BasicRasterOverviews<T>::compute_zoom_range(unsigned int width,
+                                                 unsigned int height,
+                                                 double cell_size,
+                                                 int& min_zoom,
+                                                 int& max_zoom,
+                                                 int& native_zoom)
 {
-    m_estimated_max_zoom = guess_max_zoom_level(fabs(m_base_raster->get_cell_size()));
-    m_estimated_min_zoom = guess_min_zoom_level(m_estimated_max_zoom);
+    native_zoom = guess_max_zoom_level(fabs(cell_size));
+    const int estimated_min_zoom = guess_min_zoom_level(native_zoom, width, height);
+
+    min_zoom = std::max(min_zoom, estimated_min_zoom);
+    max_zoom = std::min(std::max(0, max_zoom), native_zoom);
 
-    m_min_zoom = std::max(m_min_zoom, m_estimated_min_zoom);
-    m_max_zoom = std::min(std::max(0, m_max_zoom), m_estimated_max_zoom);
+    if(max_zoom < min_zoom)
+    {
+        std::swap(min_zoom, max_zoom);
+    }
+}
 
-    if(m_max_zoom < m_min_zoom)
+template<typename T>
+void BasicRasterOverviews<T>::compute_zoom_levels()
+{
+    compute_zoom_range(m_base_raster->get_width(),
+                       m_base_raster->get_height(),
+                       m_base_raster->get_cell_size(),
+                       m_min_zoom,
+                       m_max_zoom,
+                       m_estimated_max_zoom);
+}
+
+// Walks down the pyramid from the last computed level until window_size is reached,
+// levels are visited from fine to coarse so each one is reduced only once
+template<typename T>
+Raster<T> BasicRasterOverviews<T>::cascaded_downsample(int window_size)
+{
+    while(m_cascade_window < window_size)
     {
-        std::swap(m_min_zoom, m_max_zoom);
+        const Raster<T>& src = m_cascade_window == 1 ? *m_base_raster : m_cascade_raster;
+        Raster<T> dst = raster_tools::downsample_mean_2x2(src, m_cascade_weights, m_thread_pool);
+        m_cascade_raster = std::move(dst);
+        m_cascade_window *= 2;
     }
+    return m_cascade_raster.share();
 }
 
-bool RasterOverviews::next(RasterOverview& overview)
+template<typename T>
+bool BasicRasterOverviews<T>::next(BasicRasterOverview<T>& overview)
 {
     if(m_current_zoom < m_min_zoom) return false;
 
     int window_size = (1 << (m_estimated_max_zoom - m_current_zoom));
-    auto output_raster = std::make_unique<RasterDouble>();
+    auto output_raster = std::make_unique<Raster<T>>();
 
     if(window_size == 1)
     {
-        *output_raster = m_base_raster->clone();
+        // overviews are never modified, so the base level can be handed out without a copy
+        *output_raster = m_base_raster->share();
+    }
+    else if(m_mode == OverviewMode::cascaded)
+    {
+        *output_raster = cascaded_downsample(window_size);
     }
     else
     {
         *output_raster = raster_tools::integer_downsample_mean(*m_base_raster, window_size);
     }
 
+    // drop our references as soon as no further level needs them,
+    // the data then lives only as long as the caller keeps the overview
+    const bool is_last_level = m_current_zoom == m_min_zoom;
+    if(is_last_level || (m_mode == OverviewMode::cascaded && m_cascade_window > 1))
+    {
+        m_base_raster.reset();
+    }
+    if(is_last_level)
+    {
+        m_cascade_raster.clear();
+        m_cascade_weights.clear();
+    }
+
     overview.zoom_level = m_current_zoom--;
     overview.resolution = output_raster->get_cell_size();
     overview.raster = std::move(output_raster);
@@ -97,4 +155,7 @@ bool RasterOverviews::next(RasterOverview& overview)
     return true;
 }
 
+template class BasicRasterOverviews<double>;
+template class BasicRasterOverviews<float>;
+
 } // namespace tntn
@@ -1,5 +1,6 @@
 #include "tntn/TerraMesh.h"
 #include "tntn/TerraUtils.h"
+#include "tntn/terra_scanline.h"
 #include "tntn/logging.h"
 #include "tntn/SurfacePoints.h"
 #include "tntn/DelaunayTriangle.h"
@@ -13,10 +14,10 @@
 namespace tntn {
 namespace terra {
 
-void TerraMesh::greedy_insert(double max_error)
+template<typename T>
+void TerraMesh<T>::init_greedy_insert(double max_error)
 {
     m_max_error = max_error;
-    m_counter = 0;
     int w = m_raster->get_width();
     int h = m_raster->get_height();
     TNTN_ASSERT(w > 0);
@@ -26,7 +27,7 @@ void TerraMesh::greedy_insert(double max_error)
 
     // Initialize m_used
     m_used.allocate(w, h);
-    m_used.set_all(0);
+    m_used.set_all(false);
 
     // Ensure the four corners are not NAN, otherwise the algorithm can't proceed.
     this->repair_point(0, 0);
@@ -39,16 +40,16 @@ void TerraMesh::greedy_insert(double max_error)
     this->init_mesh(
         glm::dvec2(0, 0), glm::dvec2(0, h - 1), glm::dvec2(w - 1, h - 1), glm::dvec2(w - 1, 0));
 
-    m_used.value(0, 0) = 1;
-    m_used.value(h - 1, 0) = 1;
-    m_used.value(h - 1, w - 1) = 1;
-    m_used.value(0, w - 1) = 1;
-
-    // Initialize m_token
-    m_token.allocate(w, h);
-    m_token.set_all(0);
+    m_used.set(0, 0);
+    m_used.set(h - 1, 0);
+    m_used.set(h - 1, w - 1);
+    m_used.set(0, w - 1);
+}
 
-    // Scan all the triangles and push all candidates into a stack
+template<typename T>
+void TerraMesh<T>::insert_candidates()
+{
+    // Scan all the triangles and collect their candidates
     dt_ptr t = m_first_face;
     while(t)
     {
@@ -61,12 +62,14 @@ void TerraMesh::greedy_insert(double max_error)
     {
         Candidate candidate = m_candidates.grab_greatest();
 
-        if(candidate.importance < m_max_error) continue;
-
-        // Skip if the candidate is not the latest
-        if(m_token.value(candidate.y, candidate.x) != candidate.token) continue;
+        // The point may have been taken through a neighbouring triangle, look again
+        if(m_used.value(candidate.y, candidate.x))
+        {
+            scan_triangle(candidate.triangle);
+            continue;
+        }
 
-        m_used.value(candidate.y, candidate.x) = 1;
+        m_used.set(candidate.y, candidate.x);
 
         //TNTN_LOG_DEBUG("inserting point: ({}, {}, {})", candidate.x, candidate.y, candidate.z);
         this->insert(glm::dvec2(candidate.x, candidate.y), candidate.triangle);
@@ -75,38 +78,87 @@ void TerraMesh::greedy_insert(double max_error)
     TNTN_LOG_INFO("finished greedy insertion");
 }
 
-void TerraMesh::scan_triangle_line(const Plane& plane,
-                                   int y,
-                                   double x1,
-                                   double x2,
-                                   Candidate& candidate,
-                                   const double no_data_value)
+template<typename T>
+void TerraMesh<T>::greedy_insert(double max_error)
+{
+    init_greedy_insert(max_error);
+    insert_candidates();
+}
+
+template<typename T>
+void TerraMesh<T>::greedy_insert(double max_error, const std::vector<glm::ivec2>& border_points)
+{
+    init_greedy_insert(max_error);
+    const int w = m_raster->get_width();
+    const int h = m_raster->get_height();
+
+    // Marking the whole border as used keeps it out of the scans
+    for(int x = 0; x < w; x++)
+    {
+        m_used.set(0, x);
+        m_used.set(h - 1, x);
+    }
+    for(int y = 0; y < h; y++)
+    {
+        m_used.set(y, 0);
+        m_used.set(y, w - 1);
+    }
+
+    for(const glm::ivec2& p : border_points)
+    {
+        TNTN_ASSERT(p.x == 0 || p.y == 0 || p.x == w - 1 || p.y == h - 1);
+        this->insert(glm::dvec2(p.x, p.y), dt_ptr());
+    }
+
+    insert_candidates();
+
+    // Only the corners and the given points are vertices on the border
+    for(int x = 1; x < w - 1; x++)
+    {
+        m_used.unset(0, x);
+        m_used.unset(h - 1, x);
+    }
+    for(int y = 1; y < h - 1; y++)
+    {
+        m_used.unset(y, 0);
+        m_used.unset(y, w - 1);
+    }
+    for(const glm::ivec2& p : border_points)
+    {
+        m_used.set(p.y, p.x);
+    }
+}
+
+template<typename T>
+void TerraMesh<T>::scan_triangle_line(const Plane& plane,
+                                      int y,
+                                      double x1,
+                                      double x2,
+                                      Candidate& candidate,
+                                      const double no_data_value)
 {
     const int startx = static_cast<int>(ceil(fmin(x1, x2)));
     const int endx = static_cast<int>(floor(fmax(x1, x2)));
 
     if(startx > endx) return;
 
-    double z0 = plane.eval(startx, y);
-    double dz = plane.a;
-
-    for(int x = startx; x <= endx; x++)
+    double error = 0;
+    const int x = scan_row_max_error(m_raster->get_ptr(y),
+                                     m_used.get_ptr(y),
+                                     startx,
+                                     endx,
+                                     plane.a,
+                                     plane.b * y + plane.c,
+                                     no_data_value,
+                                     error);
+    if(x >= 0)
     {
-        if(!m_used.value(y, x))
-        {
-            const double z = m_raster->value(y, x);
-            if(!is_no_data(z, no_data_value))
-            {
-                const double diff = fabs(z - z0);
-                //TNTN_LOG_DEBUG("candidate consider: ({}, {}, {}), diff: {}", x, y, z, diff);
-                candidate.consider(x, y, z, diff);
-            }
-        }
-        z0 += dz;
+        candidate.consider(x, y, m_raster->value(y, x), error);
     }
 }
 
-void TerraMesh::scan_triangle(dt_ptr t)
+template<typename T>
+void TerraMesh<T>::scan_triangle(dt_ptr t)
 {
     Plane z_plane;
     compute_plane(z_plane, t, *m_raster);
@@ -124,7 +176,7 @@ void TerraMesh::scan_triangle(dt_ptr t)
     const double v2_x = by_y[2].x;
     const double v2_y = by_y[2].y;
 
-    Candidate candidate = {0, 0, 0.0, -DBL_MAX, m_counter++, t};
+    Candidate candidate = {0, 0, 0.0, -DBL_MAX, t};
 
     const double dx2 = (v2_x - v0_x) / (v2_y - v0_y);
     const double no_data_value = m_raster->get_no_data_value();
@@ -136,8 +188,9 @@ void TerraMesh::scan_triangle(dt_ptr t)
         double x1 = v0_x;
         double x2 = v0_x;
 
+        // the row of v1 is scanned with the lower half, or here if there is none
         const int starty = v0_y;
-        const int endy = v1_y;
+        const int endy = v2_y != v1_y ? v1_y : v1_y + 1;
 
         for(int y = starty; y < endy; y++)
         {
@@ -152,7 +205,7 @@ void TerraMesh::scan_triangle(dt_ptr t)
         const double dx1 = (v2_x - v1_x) / (v2_y - v1_y);
 
         double x1 = v1_x;
-        double x2 = v0_x;
+        double x2 = v0_x + dx2 * (v1_y - v0_y);
 
         const int starty = v1_y;
         const int endy = v2_y;
@@ -165,20 +218,27 @@ void TerraMesh::scan_triangle(dt_ptr t)
         }
     }
 
-    // We have now found the appropriate candidate point
-    m_token.value(candidate.y, candidate.x) = candidate.token;
-
-    // Push the candidate into the stack
-    m_candidates.push_back(candidate);
+    // We have now found the appropriate candidate point, it replaces the triangle's
+    // previous one and is only kept while it exceeds the error threshold
+    if(candidate.importance >= m_max_error)
+    {
+        m_candidates.update(candidate);
+    }
+    else
+    {
+        m_candidates.remove(t);
+    }
 }
 
-std::unique_ptr<Mesh> TerraMesh::convert_to_mesh()
+template<typename T>
+void TerraMesh<T>::decompose(std::vector<Vertex>& vertices, std::vector<Face>& faces)
 {
     // Find all the vertices
     int w = m_raster->get_width();
     int h = m_raster->get_height();
 
-    std::vector<Vertex> mvertices;
+    vertices.clear();
+    faces.clear();
 
     Raster<int> vertex_id;
     vertex_id.allocate(w, h);
@@ -190,7 +250,7 @@ std::unique_ptr<Mesh> TerraMesh::convert_to_mesh()
     {
         for(int x = 0; x < w; x++)
         {
-            if(m_used.value(y, x) == 1)
+            if(m_used.value(y, x))
             {
                 const double z = m_raster->value(y, x);
                 if(is_no_data(z, no_data_value))
@@ -198,8 +258,7 @@ std::unique_ptr<Mesh> TerraMesh::convert_to_mesh()
                     continue;
                 }
 
-                Vertex v = Vertex({m_raster->col2x(x), m_raster->row2y(y), z});
-                mvertices.push_back(v);
+                vertices.push_back(Vertex(x, y, z));
                 vertex_id.value(y, x) = index;
                 index++;
             }
@@ -207,7 +266,6 @@ std::unique_ptr<Mesh> TerraMesh::convert_to_mesh()
     }
 
     // Find all the faces
-    std::vector<Face> mfaces;
     dt_ptr t = m_first_face;
     while(t)
     {
@@ -230,10 +288,24 @@ std::unique_ptr<Mesh> TerraMesh::convert_to_mesh()
             f[2] = vertex_id.value((int)p1.y, (int)p1.x);
         }
 
-        mfaces.push_back(f);
+        faces.push_back(f);
 
         t = t->getLink();
     }
+}
+
+template<typename T>
+std::unique_ptr<Mesh> TerraMesh<T>::convert_to_mesh()
+{
+    std::vector<Vertex> mvertices;
+    std::vector<Face> mfaces;
+    decompose(mvertices, mfaces);
+
+    for(Vertex& v : mvertices)
+    {
+        v.x = m_raster->col2x(static_cast<int>(v.x));
+        v.y = m_raster->row2y(static_cast<int>(v.y));
+    }
 
     // now initialise our mesh class with this
     auto mesh = std::make_unique<Mesh>();
@@ -241,5 +313,8 @@ std::unique_ptr<Mesh> TerraMesh::convert_to_mesh()
     return mesh;
 }
 
+template class TerraMesh<double>;
+template class TerraMesh<float>;
+
 } //namespace terra
 } //namespace tntn
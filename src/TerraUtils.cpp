@@ -1,30 +1,160 @@
 #include "tntn/TerraUtils.h"
 #include "tntn/logging.h"
 #include "tntn/raster_tools.h"
+#include "tntn/tntn_assert.h"
 
 namespace tntn {
 namespace terra {
 
-void TerraBaseMesh::repair_point(int px, int py)
+constexpr uint32_t CandidateList::not_in_heap;
+
+void CandidateList::update(const Candidate& candidate)
+{
+    const size_t index = candidate.triangle.index();
+    if(index >= m_position.size())
+    {
+        m_position.resize(std::max(index + 1, 2 * m_position.size()), not_in_heap);
+    }
+
+    const uint32_t pos = m_position[index];
+    if(pos == not_in_heap)
+    {
+        TNTN_ASSERT(m_heap.size() < not_in_heap);
+        m_heap.emplace_back();
+        sift_up(Candidate(candidate), m_heap.size() - 1);
+    }
+    else if(m_heap[pos] < candidate)
+    {
+        sift_up(Candidate(candidate), pos);
+    }
+    else
+    {
+        sift_down(Candidate(candidate), pos);
+    }
+}
+
+void CandidateList::remove(const dt_ptr& t)
+{
+    const size_t index = t.index();
+    if(index < m_position.size() && m_position[index] != not_in_heap)
+    {
+        erase_at(m_position[index]);
+    }
+}
+
+Candidate CandidateList::grab_greatest()
+{
+    if(m_heap.empty())
+    {
+        return Candidate();
+    }
+
+    Candidate candidate = m_heap.front();
+    erase_at(0);
+    return candidate;
+}
+
+void CandidateList::place(Candidate&& candidate, size_t pos)
+{
+    m_position[candidate.triangle.index()] = pos;
+    m_heap[pos] = std::move(candidate);
+}
+
+void CandidateList::sift_up(Candidate&& candidate, size_t pos)
 {
-    double& p = m_raster->value(py, px);
-    const double z = raster_tools::sample_nearest_valid_avg(*m_raster, py, px);
-    const double no_data_value = m_raster->get_no_data_value();
+    while(pos > 0)
+    {
+        const size_t parent = (pos - 1) / 2;
+        if(!(m_heap[parent] < candidate))
+        {
+            break;
+        }
+        place(std::move(m_heap[parent]), pos);
+        pos = parent;
+    }
+    place(std::move(candidate), pos);
+}
+
+void CandidateList::sift_down(Candidate&& candidate, size_t pos)
+{
+    const size_t size = m_heap.size();
+    while(true)
+    {
+        size_t child = 2 * pos + 1;
+        if(child >= size)
+        {
+            break;
+        }
+        if(child + 1 < size && m_heap[child] < m_heap[child + 1])
+        {
+            child++;
+        }
+        if(!(candidate < m_heap[child]))
+        {
+            break;
+        }
+        place(std::move(m_heap[child]), pos);
+        pos = child;
+    }
+    place(std::move(candidate), pos);
+}
+
+void CandidateList::erase_at(size_t pos)
+{
+    m_position[m_heap[pos].triangle.index()] = not_in_heap;
+
+    Candidate last = std::move(m_heap.back());
+    m_heap.pop_back();
+    if(pos == m_heap.size())
+    {
+        return;
+    }
+
+    // the last element fills the hole and moves whichever way restores the heap
+    if(pos > 0 && m_heap[(pos - 1) / 2] < last)
+    {
+        sift_up(std::move(last), pos);
+    }
+    else
+    {
+        sift_down(std::move(last), pos);
+    }
+}
+
+template<typename T>
+void repair_point(Raster<T>& raster, int px, int py)
+{
+    T& p = raster.value(py, px);
+    const double z = raster_tools::sample_nearest_valid_avg(raster, py, px);
+    const double no_data_value = raster.get_no_data_value();
     if(is_no_data(z, no_data_value))
     {
-        p = 0.0;
+        p = 0;
     }
     else
     {
         TNTN_LOG_DEBUG("fill missing point: ({}, {}, {})", px, py, z);
-        p = z;
+        p = static_cast<T>(z);
     }
 }
 
-void TerraBaseMesh::load_raster(std::unique_ptr<RasterDouble> raster)
+template<typename T>
+void TerraBaseMesh<T>::repair_point(int px, int py)
+{
+    terra::repair_point(*m_raster, px, py);
+}
+
+template<typename T>
+void TerraBaseMesh<T>::load_raster(std::unique_ptr<Raster<T>> raster)
 {
     m_raster = std::move(raster);
 }
 
+template void repair_point(Raster<double>&, int, int);
+template void repair_point(Raster<float>&, int, int);
+
+template class TerraBaseMesh<double>;
+template class TerraBaseMesh<float>;
+
 } // namespace terra
 } // namespace tntn
@@ -0,0 +1,177 @@
+#include "tntn/ThreadPool.h"
+#include "tntn/logging.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+namespace tntn {
+
+ThreadPool::ThreadPool(int num_threads) :
+    m_num_threads(num_threads < 1 ? hardware_concurrency() : num_threads)
+{
+    //the thread calling parallel_for is also doing work
+    const int num_workers = m_num_threads - 1;
+    m_workers.reserve(num_workers);
+    for(int i = 0; i < num_workers; i++)
+    {
+        m_workers.emplace_back([this]() { worker_main(); });
+    }
+    TNTN_LOG_DEBUG("started thread pool with {} worker threads", num_workers);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_task_available.notify_all();
+    for(auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+int ThreadPool::hardware_concurrency() noexcept
+{
+    const unsigned int n = std::thread::hardware_concurrency();
+    return n > 0 ? static_cast<int>(n) : 1;
+}
+
+void ThreadPool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_task_available.notify_one();
+}
+
+void ThreadPool::worker_main()
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_task_available.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if(m_tasks.empty())
+            {
+                //only reached when stopping
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+
+struct ParallelForState
+{
+    const std::function<bool(size_t)>* fn = nullptr;
+    size_t count = 0;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t next = 0;
+    size_t running = 0;
+    bool failed = false;
+    std::exception_ptr first_exception;
+
+    bool is_exhausted() const { return failed || next >= count; }
+};
+
+// claims and runs indices until there is nothing left to do
+void run_parallel_for_items(ParallelForState& s)
+{
+    while(true)
+    {
+        size_t i = 0;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if(s.is_exhausted())
+            {
+                return;
+            }
+            i = s.next++;
+            s.running++;
+        }
+
+        bool ok = false;
+        std::exception_ptr exception;
+        try
+        {
+            ok = (*s.fn)(i);
+        }
+        catch(...)
+        {
+            exception = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.running--;
+        if(!ok)
+        {
+            s.failed = true;
+            if(exception && !s.first_exception)
+            {
+                s.first_exception = exception;
+            }
+        }
+        if(s.running == 0 && s.is_exhausted())
+        {
+            s.finished.notify_all();
+        }
+    }
+}
+
+} //namespace
+
+bool ThreadPool::parallel_for(size_t count, const std::function<bool(size_t)>& fn)
+{
+    if(count == 0)
+    {
+        return true;
+    }
+
+    if(m_workers.empty() || count == 1)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            if(!fn(i))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //helpers may get scheduled after this call returned (e.g. when all workers were busy),
+    //they then find the state exhausted and return without touching fn
+    auto state = std::make_shared<ParallelForState>();
+    state->fn = &fn;
+    state->count = count;
+
+    const size_t num_helpers = std::min(m_workers.size(), count - 1);
+    for(size_t i = 0; i < num_helpers; i++)
+    {
+        post([state]() { run_parallel_for_items(*state); });
+    }
+
+    run_parallel_for_items(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state]() { return state->running == 0; });
+
+    if(state->first_exception)
+    {
+        std::rethrow_exception(state->first_exception);
+    }
+    return !state->failed;
+}
+
+} //namespace tntn
@@ -0,0 +1,325 @@
+#include "tntn/TileArchive.h"
+#include "tntn/logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <tuple>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tntn {
+
+static const char archive_magic[8] = {'T', 'N', 'T', 'N', 'P', 'A', 'K', '1'};
+static const char index_magic[8] = {'T', 'N', 'T', 'N', 'I', 'D', 'X', '1'};
+
+static constexpr size_t header_size = sizeof(archive_magic);
+static constexpr size_t index_entry_size = 24;
+static constexpr size_t trailer_size = 24;
+
+static void put_uint32(unsigned char* p, uint32_t v)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+static void put_uint64(unsigned char* p, uint64_t v)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+static uint32_t get_uint32(const unsigned char* p)
+{
+    uint32_t v = 0;
+    for(int i = 3; i >= 0; i--)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static uint64_t get_uint64(const unsigned char* p)
+{
+    uint64_t v = 0;
+    for(int i = 7; i >= 0; i--)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+bool TileArchiveWriter::open(std::shared_ptr<FileLike> f)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_file = std::move(f);
+    m_index.clear();
+    m_finished = false;
+    m_write_position = header_size;
+
+    if(!m_file || !m_file->write(0, archive_magic, header_size))
+    {
+        TNTN_LOG_ERROR("unable to write tile archive header");
+        m_file.reset();
+        return false;
+    }
+    return true;
+}
+
+bool TileArchiveWriter::add_tile(
+    const int zoom, const int x, const int y, const unsigned char* data, const size_t size)
+{
+    if(zoom < 0 || x < 0 || y < 0)
+    {
+        TNTN_LOG_ERROR("invalid tile coordinates z:{} x:{} y:{}", zoom, x, y);
+        return false;
+    }
+    if(size > std::numeric_limits<uint32_t>::max())
+    {
+        TNTN_LOG_ERROR("tile z:{} x:{} y:{} too large for archive", zoom, x, y);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(!m_file || m_finished)
+    {
+        TNTN_LOG_ERROR("tile archive is not open for writing");
+        return false;
+    }
+
+    if(size > 0 && !m_file->write(m_write_position, data, size))
+    {
+        TNTN_LOG_ERROR("error writing tile z:{} x:{} y:{} to archive {}",
+                       zoom,
+                       x,
+                       y,
+                       m_file->name());
+        return false;
+    }
+
+    m_index.push_back(IndexEntry{static_cast<uint32_t>(zoom),
+                                 static_cast<uint32_t>(x),
+                                 static_cast<uint32_t>(y),
+                                 static_cast<uint32_t>(size),
+                                 m_write_position});
+    m_write_position += size;
+    return true;
+}
+
+bool TileArchiveWriter::finish()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(!m_file || m_finished)
+    {
+        TNTN_LOG_ERROR("tile archive is not open for writing");
+        return false;
+    }
+    m_finished = true;
+
+    std::sort(m_index.begin(), m_index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return std::tie(a.zoom, a.x, a.y) < std::tie(b.zoom, b.x, b.y);
+    });
+
+    for(size_t i = 1; i < m_index.size(); i++)
+    {
+        const IndexEntry& a = m_index[i - 1];
+        const IndexEntry& b = m_index[i];
+        if(a.zoom == b.zoom && a.x == b.x && a.y == b.y)
+        {
+            TNTN_LOG_ERROR("tile z:{} x:{} y:{} added to archive twice", a.zoom, a.x, a.y);
+            return false;
+        }
+    }
+
+    std::vector<unsigned char> buffer(m_index.size() * index_entry_size + trailer_size);
+    unsigned char* p = buffer.data();
+    for(const IndexEntry& e : m_index)
+    {
+        put_uint32(p, e.zoom);
+        put_uint32(p + 4, e.x);
+        put_uint32(p + 8, e.y);
+        put_uint32(p + 12, e.length);
+        put_uint64(p + 16, e.offset);
+        p += index_entry_size;
+    }
+    put_uint64(p, m_write_position);
+    put_uint64(p + 8, m_index.size());
+    memcpy(p + 16, index_magic, sizeof(index_magic));
+
+    if(!m_file->write(m_write_position, buffer))
+    {
+        TNTN_LOG_ERROR("error writing tile archive index to {}", m_file->name());
+        return false;
+    }
+    m_file->flush();
+
+    TNTN_LOG_INFO("wrote {} tiles into archive {}", m_index.size(), m_file->name());
+    return true;
+}
+
+size_t TileArchiveWriter::num_tiles() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.size();
+}
+
+TileArchiveReader::~TileArchiveReader()
+{
+    close();
+}
+
+void TileArchiveReader::close()
+{
+    if(m_mapping)
+    {
+        munmap(m_mapping, m_mapping_size);
+    }
+    m_mapping = nullptr;
+    m_mapping_size = 0;
+    m_data = nullptr;
+    m_size = 0;
+    m_index = nullptr;
+    m_num_tiles = 0;
+}
+
+bool TileArchiveReader::open(const std::string& filename)
+{
+    close();
+
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        const auto err = errno;
+        TNTN_LOG_ERROR("unable to open tile archive {}, errno = {}", filename, err);
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        TNTN_LOG_ERROR("unable to get size of tile archive {}", filename);
+        ::close(fd);
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        const auto err = errno;
+        TNTN_LOG_ERROR("unable to map tile archive {}, errno = {}", filename, err);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mapping_size = size;
+    m_data = static_cast<const unsigned char*>(mapping);
+    m_size = size;
+
+    if(!parse())
+    {
+        TNTN_LOG_ERROR("{} is not a valid tile archive", filename);
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TileArchiveReader::open(const unsigned char* data, size_t size)
+{
+    close();
+    m_data = data;
+    m_size = size;
+    if(!parse())
+    {
+        TNTN_LOG_ERROR("invalid tile archive");
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TileArchiveReader::parse()
+{
+    if(m_size < header_size + trailer_size || memcmp(m_data, archive_magic, header_size) != 0)
+    {
+        return false;
+    }
+
+    const unsigned char* trailer = m_data + m_size - trailer_size;
+    if(memcmp(trailer + 16, index_magic, sizeof(index_magic)) != 0)
+    {
+        return false;
+    }
+
+    const uint64_t index_offset = get_uint64(trailer);
+    const uint64_t num_tiles = get_uint64(trailer + 8);
+    const uint64_t index_end = m_size - trailer_size;
+    if(index_offset < header_size || index_offset > index_end ||
+       (index_end - index_offset) / index_entry_size != num_tiles ||
+       (index_end - index_offset) % index_entry_size != 0)
+    {
+        return false;
+    }
+
+    m_index = m_data + index_offset;
+    m_num_tiles = static_cast<size_t>(num_tiles);
+    return true;
+}
+
+bool TileArchiveReader::get_tile(
+    const int zoom, const int x, const int y, const unsigned char*& data, size_t& size) const
+{
+    if(!m_index || zoom < 0 || x < 0 || y < 0)
+    {
+        return false;
+    }
+
+    const auto key =
+        std::make_tuple(static_cast<uint32_t>(zoom), static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+
+    size_t lo = 0;
+    size_t hi = m_num_tiles;
+    while(lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        const unsigned char* e = m_index + mid * index_entry_size;
+        const auto entry_key = std::make_tuple(get_uint32(e), get_uint32(e + 4), get_uint32(e + 8));
+        if(entry_key < key)
+        {
+            lo = mid + 1;
+        }
+        else if(key < entry_key)
+        {
+            hi = mid;
+        }
+        else
+        {
+            const uint32_t length = get_uint32(e + 12);
+            const uint64_t offset = get_uint64(e + 16);
+            if(offset + length > static_cast<uint64_t>(m_index - m_data))
+            {
+                TNTN_LOG_ERROR("corrupt tile archive entry z:{} x:{} y:{}", zoom, x, y);
+                return false;
+            }
+            data = m_data + offset;
+            size = length;
+            return true;
+        }
+    }
+    return false;
+}
+
+} //namespace tntn
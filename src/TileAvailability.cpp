@@ -0,0 +1,343 @@
+#include "tntn/TileAvailability.h"
+#include "tntn/logging.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <utility>
+
+#include "fmt/format.h"
+
+namespace tntn {
+
+void TileAvailability::insert_run(Runs& runs, int x1, int x2)
+{
+    // merge with a run ending right before or overlapping x1
+    auto it = runs.upper_bound(x1);
+    if(it != runs.begin())
+    {
+        auto prev = std::prev(it);
+        if(prev->second >= x1 - 1)
+        {
+            x1 = prev->first;
+            x2 = std::max(x2, prev->second);
+            it = runs.erase(prev);
+        }
+    }
+
+    // and with the runs starting inside or right after [x1, x2]
+    while(it != runs.end() && it->first <= x2 + 1)
+    {
+        x2 = std::max(x2, it->second);
+        it = runs.erase(it);
+    }
+
+    runs.emplace_hint(it, x1, x2);
+}
+
+void TileAvailability::add_tile(const int zoom, const int tx, const int ty)
+{
+    insert_run(m_levels[zoom][ty], tx, tx);
+}
+
+void TileAvailability::add_range(const int zoom, const TileRange& range)
+{
+    if(range.end_x < range.start_x || range.end_y < range.start_y)
+    {
+        return;
+    }
+    auto& rows = m_levels[zoom];
+    for(int ty = range.start_y; ty <= range.end_y; ty++)
+    {
+        insert_run(rows[ty], range.start_x, range.end_x);
+    }
+}
+
+void TileAvailability::remove_tile(const int zoom, const int tx, const int ty)
+{
+    const auto level = m_levels.find(zoom);
+    if(level == m_levels.end())
+    {
+        return;
+    }
+    const auto row = level->second.find(ty);
+    if(row == level->second.end())
+    {
+        return;
+    }
+
+    Runs& runs = row->second;
+    auto it = runs.upper_bound(tx);
+    if(it == runs.begin() || std::prev(it)->second < tx)
+    {
+        return;
+    }
+
+    // split the run containing tx around it
+    it = std::prev(it);
+    const int x1 = it->first;
+    const int x2 = it->second;
+    runs.erase(it);
+    if(x1 < tx)
+    {
+        runs.emplace(x1, tx - 1);
+    }
+    if(tx < x2)
+    {
+        runs.emplace(tx + 1, x2);
+    }
+
+    // keep min_zoom and max_zoom to levels with tiles
+    if(runs.empty())
+    {
+        level->second.erase(row);
+        if(level->second.empty())
+        {
+            m_levels.erase(level);
+        }
+    }
+}
+
+bool TileAvailability::has_tile(const int zoom, const int tx, const int ty) const
+{
+    const auto level = m_levels.find(zoom);
+    if(level == m_levels.end())
+    {
+        return false;
+    }
+    const auto row = level->second.find(ty);
+    if(row == level->second.end())
+    {
+        return false;
+    }
+    auto it = row->second.upper_bound(tx);
+    return it != row->second.begin() && std::prev(it)->second >= tx;
+}
+
+size_t TileAvailability::num_tiles() const
+{
+    size_t n = 0;
+    for(const auto& level : m_levels)
+    {
+        for(const auto& row : level.second)
+        {
+            for(const auto& run : row.second)
+            {
+                n += run.second - run.first + 1;
+            }
+        }
+    }
+    return n;
+}
+
+int TileAvailability::min_zoom() const
+{
+    return m_levels.empty() ? -1 : m_levels.begin()->first;
+}
+
+int TileAvailability::max_zoom() const
+{
+    return m_levels.empty() ? -1 : m_levels.rbegin()->first;
+}
+
+std::vector<TileRange> TileAvailability::ranges(const int zoom) const
+{
+    std::vector<TileRange> out;
+    const auto level = m_levels.find(zoom);
+    if(level == m_levels.end())
+    {
+        return out;
+    }
+
+    // rectangles reaching up to the previous row, by their x extent
+    std::map<std::pair<int, int>, TileRange> open;
+    std::map<std::pair<int, int>, TileRange> next_open;
+    for(const auto& row : level->second)
+    {
+        const int ty = row.first;
+        for(const auto& run : row.second)
+        {
+            const auto key = std::make_pair(run.first, run.second);
+            const auto it = open.find(key);
+            if(it != open.end() && it->second.end_y == ty - 1)
+            {
+                TileRange r = it->second;
+                r.end_y = ty;
+                open.erase(it);
+                next_open.emplace(key, r);
+            }
+            else
+            {
+                TileRange r;
+                r.start_x = run.first;
+                r.start_y = ty;
+                r.end_x = run.second;
+                r.end_y = ty;
+                next_open.emplace(key, r);
+            }
+        }
+
+        // whatever was not continued in this row is complete
+        for(const auto& closed : open)
+        {
+            out.push_back(closed.second);
+        }
+        open.clear();
+        open.swap(next_open);
+    }
+    for(const auto& closed : open)
+    {
+        out.push_back(closed.second);
+    }
+
+    std::sort(out.begin(), out.end(), [](const TileRange& a, const TileRange& b) {
+        return a.start_y != b.start_y ? a.start_y < b.start_y : a.start_x < b.start_x;
+    });
+    return out;
+}
+
+bool TileAvailability::write_layer_json(FileLike& f,
+                                        const std::string& tile_extension,
+                                        const std::vector<std::string>& extensions) const
+{
+    std::string extension_list;
+    for(const std::string& e : extensions)
+    {
+        extension_list += (extension_list.empty() ? "\"" : ", \"") + e + "\"";
+    }
+
+    std::string out = "{\n";
+    out += "  \"tilejson\": \"2.1.0\",\n";
+    out += "  \"name\": \"tntn\",\n";
+    out += "  \"version\": \"1.0.0\",\n";
+    out += "  \"format\": \"quantized-mesh-1.0\",\n";
+    out += "  \"scheme\": \"tms\",\n";
+    out += "  \"projection\": \"EPSG:3857\",\n";
+    out += fmt::format("  \"tiles\": [\"{{z}}/{{x}}/{{y}}.{}\"],\n", tile_extension);
+    out += fmt::format("  \"extensions\": [{}],\n", extension_list);
+    out += fmt::format("  \"minzoom\": {},\n", std::max(min_zoom(), 0));
+    out += fmt::format("  \"maxzoom\": {},\n", std::max(max_zoom(), 0));
+
+    // one list of ranges per zoom level starting at 0
+    out += "  \"available\": [";
+    for(int zoom = 0; zoom <= max_zoom(); zoom++)
+    {
+        out += zoom == 0 ? "\n    [" : ",\n    [";
+        const auto level_ranges = ranges(zoom);
+        for(size_t i = 0; i < level_ranges.size(); i++)
+        {
+            const TileRange& r = level_ranges[i];
+            out += fmt::format("{}{{\"startX\": {}, \"startY\": {}, \"endX\": {}, \"endY\": {}}}",
+                               i == 0 ? "" : ", ",
+                               r.start_x,
+                               r.start_y,
+                               r.end_x,
+                               r.end_y);
+        }
+        out += "]";
+    }
+    out += max_zoom() >= 0 ? "\n  ]\n" : "]\n";
+    out += "}\n";
+
+    if(!f.write(0, out))
+    {
+        TNTN_LOG_ERROR("unable to write layer.json to {}", f.name());
+        return false;
+    }
+    return true;
+}
+
+// value of "key": <int> inside a json object
+static bool find_int_member(const std::string& object, const char* key, int& value)
+{
+    const auto key_pos = object.find(std::string("\"") + key + "\"");
+    if(key_pos == std::string::npos)
+    {
+        return false;
+    }
+    const auto colon = object.find(':', key_pos);
+    if(colon == std::string::npos)
+    {
+        return false;
+    }
+    const char* begin = object.c_str() + colon + 1;
+    char* end = nullptr;
+    value = static_cast<int>(std::strtol(begin, &end, 10));
+    return end != begin;
+}
+
+bool TileAvailability::read_layer_json(FileLike& f)
+{
+    std::string json;
+    f.read(0, json, f.size());
+
+    auto fail = [&f]() {
+        TNTN_LOG_ERROR("unable to parse available ranges in {}", f.name());
+        return false;
+    };
+
+    size_t pos = json.find("\"available\"");
+    if(pos == std::string::npos)
+    {
+        return fail();
+    }
+    pos = json.find('[', pos);
+    if(pos == std::string::npos)
+    {
+        return fail();
+    }
+    pos++;
+
+    // [ [ {range}, ... ], ... ], the position in the outer list is the zoom level
+    int zoom = -1;
+    int depth = 1;
+    while(pos < json.size() && depth > 0)
+    {
+        const char c = json[pos];
+        if(c == '[')
+        {
+            if(depth != 1)
+            {
+                return fail();
+            }
+            depth++;
+            zoom++;
+            pos++;
+        }
+        else if(c == ']')
+        {
+            depth--;
+            pos++;
+        }
+        else if(c == '{')
+        {
+            const size_t end = json.find('}', pos);
+            if(depth != 2 || end == std::string::npos)
+            {
+                return fail();
+            }
+            const std::string object = json.substr(pos, end - pos + 1);
+            TileRange r;
+            if(!find_int_member(object, "startX", r.start_x) ||
+               !find_int_member(object, "startY", r.start_y) ||
+               !find_int_member(object, "endX", r.end_x) ||
+               !find_int_member(object, "endY", r.end_y))
+            {
+                return fail();
+            }
+            add_range(zoom, r);
+            pos = end + 1;
+        }
+        else
+        {
+            pos++;
+        }
+    }
+    if(depth != 0)
+    {
+        return fail();
+    }
+    return true;
+}
+
+} //namespace tntn
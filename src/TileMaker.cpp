@@ -5,6 +5,7 @@
 #include "tntn/Mesh.h"
 #include "tntn/MeshIO.h"
 #include "tntn/logging.h"
+#include "tntn/vertex_normals.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtx/normal.hpp"
@@ -12,16 +13,13 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <unordered_map>
 
 namespace tntn {
 
-static bool triangle_could_be_in_tile(const Triangle& t, const BBox2D& tile_bounds)
-{
-    BBox2D triangle_bounds(t);
-    return triangle_bounds.intersects(tile_bounds);
-}
-
 // Load an OBJ file
 bool TileMaker::loadObj(const char* filename)
 {
@@ -36,13 +34,177 @@ bool TileMaker::loadObj(const char* filename)
     return true;
 }
 
-void TileMaker::loadMesh(std::unique_ptr<Mesh> mesh)
+void TileMaker::loadMesh(std::unique_ptr<Mesh> mesh, const bool with_normals)
 {
     m_mesh = std::move(mesh);
+    m_vertex_normals.clear();
+
+    if(with_normals)
+    {
+        m_mesh->generate_decomposed();
+    }
+    m_mesh->generate_triangles();
+
+    if(with_normals)
+    {
+        if(m_mesh->triangles().distance() == m_mesh->faces().distance())
+        {
+            compute_ecef_vertex_normals(*m_mesh, m_vertex_normals);
+        }
+        else
+        {
+            TNTN_LOG_ERROR("mesh has invalid faces, tiles will be made without normals");
+        }
+    }
+
+    build_triangle_index();
 }
 
-// Dump a tile into an terrain tile in format determined by a MeshWriter
-bool TileMaker::dumpTile(int tx, int ty, int zoom, const char* filename, MeshWriter& mesh_writer)
+// upper limit for grid cells per axis, keeps the index small for huge meshes
+static constexpr int max_grid_cells_per_axis = 4096;
+
+void TileMaker::build_triangle_index()
+{
+    const auto triangles_range = m_mesh->triangles();
+    const size_t num_triangles = triangles_range.distance();
+
+    m_grid_cell_start.clear();
+    m_grid_triangles.clear();
+
+    BBox2D mesh_bounds(glm::dvec2(0, 0), glm::dvec2(0, 0));
+    if(num_triangles > 0)
+    {
+        mesh_bounds.reset();
+        mesh_bounds.add(triangles_range.begin, triangles_range.end);
+    }
+
+    // aim for roughly one triangle per cell
+    const int cells_per_axis = std::max(
+        1,
+        std::min(max_grid_cells_per_axis,
+                 static_cast<int>(std::ceil(std::sqrt(static_cast<double>(num_triangles))))));
+
+    const glm::dvec2 extent = mesh_bounds.max - mesh_bounds.min;
+    m_grid_origin = mesh_bounds.min;
+    m_grid_width = extent.x > 0 ? cells_per_axis : 1;
+    m_grid_height = extent.y > 0 ? cells_per_axis : 1;
+    m_grid_inverse_cell_size.x = extent.x > 0 ? m_grid_width / extent.x : 0;
+    m_grid_inverse_cell_size.y = extent.y > 0 ? m_grid_height / extent.y : 0;
+
+    // first pass counts the entries per cell, second pass fills them in
+    const size_t num_cells = static_cast<size_t>(m_grid_width) * m_grid_height;
+    m_grid_cell_start.assign(num_cells + 1, 0);
+
+    auto for_each_cell = [this](const Triangle& t, auto&& fn) {
+        const BBox2D tb(t);
+        const int c1 = grid_col(tb.min.x);
+        const int c2 = grid_col(tb.max.x);
+        const int r1 = grid_row(tb.min.y);
+        const int r2 = grid_row(tb.max.y);
+        for(int r = r1; r <= r2; r++)
+        {
+            for(int c = c1; c <= c2; c++)
+            {
+                fn(static_cast<size_t>(r) * m_grid_width + c);
+            }
+        }
+    };
+
+    for(const Triangle* tp = triangles_range.begin; tp != triangles_range.end; tp++)
+    {
+        for_each_cell(*tp, [this](size_t cell) { m_grid_cell_start[cell + 1]++; });
+    }
+
+    for(size_t i = 0; i < num_cells; i++)
+    {
+        m_grid_cell_start[i + 1] += m_grid_cell_start[i];
+    }
+
+    m_grid_triangles.resize(m_grid_cell_start[num_cells]);
+    std::vector<uint32_t> cell_fill(m_grid_cell_start.begin(), m_grid_cell_start.end() - 1);
+
+    for(const Triangle* tp = triangles_range.begin; tp != triangles_range.end; tp++)
+    {
+        const uint32_t ti = static_cast<uint32_t>(tp - triangles_range.begin);
+        for_each_cell(*tp,
+                      [this, ti, &cell_fill](size_t cell) { m_grid_triangles[cell_fill[cell]++] = ti; });
+    }
+
+    TNTN_LOG_DEBUG("triangle index: {}x{} cells, {} entries for {} triangles",
+                   m_grid_width,
+                   m_grid_height,
+                   m_grid_triangles.size(),
+                   num_triangles);
+}
+
+int TileMaker::grid_col(double x) const
+{
+    const double c = std::floor((x - m_grid_origin.x) * m_grid_inverse_cell_size.x);
+    return static_cast<int>(std::max(0.0, std::min(c, m_grid_width - 1.0)));
+}
+
+int TileMaker::grid_row(double y) const
+{
+    const double r = std::floor((y - m_grid_origin.y) * m_grid_inverse_cell_size.y);
+    return static_cast<int>(std::max(0.0, std::min(r, m_grid_height - 1.0)));
+}
+
+void TileMaker::find_triangle_indices(const BBox2D& bounds, std::vector<uint32_t>& found) const
+{
+    found.clear();
+    if(m_grid_cell_start.empty())
+    {
+        return;
+    }
+
+    // intersects() tolerates an epsilon, widen the cell range accordingly
+    const int c1 = grid_col(bounds.min.x - BBox2D::eps);
+    const int c2 = grid_col(bounds.max.x + BBox2D::eps);
+    const int r1 = grid_row(bounds.min.y - BBox2D::eps);
+    const int r2 = grid_row(bounds.max.y + BBox2D::eps);
+
+    const Triangle* mesh_triangles = m_mesh->triangles().begin;
+
+    for(int r = r1; r <= r2; r++)
+    {
+        const size_t row_start = static_cast<size_t>(r) * m_grid_width;
+        for(int c = c1; c <= c2; c++)
+        {
+            const uint32_t* cell_begin = m_grid_triangles.data() + m_grid_cell_start[row_start + c];
+            const uint32_t* cell_end = m_grid_triangles.data() + m_grid_cell_start[row_start + c + 1];
+            for(const uint32_t* ti = cell_begin; ti != cell_end; ti++)
+            {
+                const BBox2D tb(mesh_triangles[*ti]);
+                // a triangle spanning several cells is only reported from the first of them
+                // that is covered by the query
+                if(std::max(grid_col(tb.min.x), c1) == c && std::max(grid_row(tb.min.y), r1) == r
+                   && tb.intersects(bounds))
+                {
+                    found.push_back(*ti);
+                }
+            }
+        }
+    }
+
+    // restore the order of the mesh
+    std::sort(found.begin(), found.end());
+}
+
+void TileMaker::find_triangles(const BBox2D& bounds, std::vector<Triangle>& triangles) const
+{
+    std::vector<uint32_t> found;
+    find_triangle_indices(bounds, found);
+
+    const Triangle* mesh_triangles = m_mesh->triangles().begin;
+    triangles.reserve(triangles.size() + found.size());
+    for(const uint32_t ti : found)
+    {
+        triangles.push_back(mesh_triangles[ti]);
+    }
+}
+
+// Clip the mesh to a tile and rescale it to the 0-1 quadrant
+std::unique_ptr<Mesh> TileMaker::makeTile(int tx, int ty, int zoom, BBox3D& tileSpaceBbox) const
 {
     MercatorProjection projection;
 
@@ -54,16 +216,15 @@ bool TileMaker::dumpTile(int tx, int ty, int zoom, const char* filename, MeshWri
         glm::dvec2(tileBounds.max.x + buffer, tileBounds.max.y + buffer)};
 
     // Find all triangles within the tile bounds
-    std::vector<Triangle> trianglesInTile;
-    m_mesh->generate_triangles();
-    const auto triangles_range = m_mesh->triangles();
+    std::vector<uint32_t> triangleIndices;
+    find_triangle_indices(tileBoundsWithBuffer, triangleIndices);
 
-    for(const Triangle* tp = triangles_range.begin; tp != triangles_range.end; tp++)
+    const Triangle* meshTriangles = m_mesh->triangles().begin;
+    std::vector<Triangle> trianglesInTile;
+    trianglesInTile.reserve(triangleIndices.size());
+    for(const uint32_t ti : triangleIndices)
     {
-        if(triangle_could_be_in_tile(*tp, tileBoundsWithBuffer))
-        {
-            trianglesInTile.push_back(*tp);
-        }
+        trianglesInTile.push_back(meshTriangles[ti]);
     }
 
     TNTN_LOG_DEBUG("before clipping: {} triangles in tile", trianglesInTile.size());
@@ -71,8 +232,7 @@ bool TileMaker::dumpTile(int tx, int ty, int zoom, const char* filename, MeshWri
     // Convert to 0-1 scale (upper right quadrant)
     const glm::dvec2 tileOrigin = {tileBounds.min.x, tileBounds.min.y};
 
-    BBox3D tileSpaceBbox;
-
+    tileSpaceBbox.reset();
     tileSpaceBbox.min.x = tileBounds.min.x;
     tileSpaceBbox.min.y = tileBounds.min.y;
     tileSpaceBbox.max.x = tileBounds.max.x;
@@ -104,6 +264,11 @@ bool TileMaker::dumpTile(int tx, int ty, int zoom, const char* filename, MeshWri
         }
     }
 
+    if(!m_vertex_normals.empty())
+    {
+        return clip_tile_with_normals(trianglesInTile, triangleIndices);
+    }
+
     // Clip the triangles to upper right quadrant
     clip_25D_triangles_to_01_quadrant(trianglesInTile);
 
@@ -111,16 +276,128 @@ bool TileMaker::dumpTile(int tx, int ty, int zoom, const char* filename, MeshWri
     TNTN_LOG_DEBUG("tile mesh bbox {}: ", tileSpaceBbox.to_string());
 
     if(trianglesInTile.size() == 0)
+    {
+        return nullptr;
+    }
+
+    auto tileMesh = std::make_unique<Mesh>();
+    tileMesh->from_triangles(std::move(trianglesInTile));
+    tileMesh->generate_decomposed();
+    return tileMesh;
+}
+
+static bool inside_01_quadrant(const Triangle& t)
+{
+    for(const Vertex& v : t)
+    {
+        if(v.x < 0 || v.x > 1 || v.y < 0 || v.y > 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// normal at p interpolated linearly over the triangle t, only x and y are considered.
+// on an edge the weight of the opposite corner vanishes, so both triangles sharing
+// the edge give the same normal
+static Normal interpolate_normal(const Triangle& t, const Normal* corner_normals, const Vertex& p)
+{
+    const glm::dvec2 e1 = glm::dvec2(t[1]) - glm::dvec2(t[0]);
+    const glm::dvec2 e2 = glm::dvec2(t[2]) - glm::dvec2(t[0]);
+    const glm::dvec2 ep = glm::dvec2(p) - glm::dvec2(t[0]);
+
+    const double det = e1.x * e2.y - e2.x * e1.y;
+    if(det == 0)
+    {
+        return glm::normalize(corner_normals[0] + corner_normals[1] + corner_normals[2]);
+    }
+    const double w1 = (ep.x * e2.y - e2.x * ep.y) / det;
+    const double w2 = (e1.x * ep.y - ep.x * e1.y) / det;
+    const double w0 = 1.0 - w1 - w2;
+
+    return glm::normalize(w0 * corner_normals[0] + w1 * corner_normals[1] +
+                          w2 * corner_normals[2]);
+}
+
+std::unique_ptr<Mesh> TileMaker::clip_tile_with_normals(
+    const std::vector<Triangle>& trianglesInTile,
+    const std::vector<uint32_t>& triangleIndices) const
+{
+    const Face* meshFaces = m_mesh->faces().begin;
+
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    std::vector<Normal> normals;
+    std::unordered_map<Vertex, VertexIndex> vertexLookup;
+
+    auto add_triangle = [&](const Triangle& t,
+                            const Normal* corner_normals,
+                            const Triangle* source) {
+        Face f;
+        for(int i = 0; i < 3; i++)
+        {
+            const auto inserted = vertexLookup.emplace(t[i], vertices.size());
+            if(inserted.second)
+            {
+                vertices.push_back(t[i]);
+                normals.push_back(source ? interpolate_normal(*source, corner_normals, t[i])
+                                         : corner_normals[i]);
+            }
+            f[i] = inserted.first->second;
+        }
+        faces.push_back(f);
+    };
+
+    // triangles are clipped one by one to know which triangle each piece comes from
+    std::vector<Triangle> pieces;
+    for(size_t i = 0; i < trianglesInTile.size(); i++)
+    {
+        const Triangle& t = trianglesInTile[i];
+        const Face& face = meshFaces[triangleIndices[i]];
+        const Normal corner_normals[3] = {
+            m_vertex_normals[face[0]], m_vertex_normals[face[1]], m_vertex_normals[face[2]]};
+
+        if(inside_01_quadrant(t))
+        {
+            add_triangle(t, corner_normals, nullptr);
+            continue;
+        }
+
+        pieces.assign(1, t);
+        clip_25D_triangles_to_01_quadrant(pieces);
+        for(const Triangle& piece : pieces)
+        {
+            add_triangle(piece, corner_normals, &t);
+        }
+    }
+
+    TNTN_LOG_INFO("after clipping: {} triangles in tile", faces.size());
+
+    if(faces.empty())
+    {
+        return nullptr;
+    }
+
+    auto tileMesh = std::make_unique<Mesh>();
+    tileMesh->from_decomposed(std::move(vertices), std::move(faces));
+    tileMesh->set_normals(std::move(normals));
+    return tileMesh;
+}
+
+// Dump a tile into an terrain tile in format determined by a MeshWriter
+bool TileMaker::dumpTile(
+    int tx, int ty, int zoom, const char* filename, MeshWriter& mesh_writer) const
+{
+    BBox3D tileSpaceBbox;
+    auto tileMesh = makeTile(tx, ty, zoom, tileSpaceBbox);
+    if(!tileMesh)
     {
         //ignore empty meshes
         return true;
     }
 
-    Mesh tileMesh;
-    tileMesh.from_triangles(std::move(trianglesInTile));
-    tileMesh.generate_decomposed();
-
-    return mesh_writer.write_mesh_to_file(filename, tileMesh, tileSpaceBbox);
+    return mesh_writer.write_mesh_to_file(filename, *tileMesh, tileSpaceBbox);
 }
 
 } //namespace tntn
@@ -0,0 +1,168 @@
+#include "tntn/TileManifest.h"
+#include "tntn/logging.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+namespace tntn {
+
+namespace fs = boost::filesystem;
+
+static const char* manifest_magic = "tntn-manifest 1 ";
+
+static std::string header_line(const std::string& fingerprint)
+{
+    return manifest_magic + fingerprint;
+}
+
+bool TileManifest::load(FileLike& f, const std::string& fingerprint)
+{
+    std::string contents;
+    f.read(0, contents, f.size());
+
+    std::istringstream in(contents);
+    std::string line;
+    if(!std::getline(in, line) || line != header_line(fingerprint))
+    {
+        TNTN_LOG_ERROR(
+            "manifest {} was written for a different input or different parameters, "
+            "cannot resume",
+            f.name());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t num_lines = 1;
+    while(std::getline(in, line))
+    {
+        num_lines++;
+        if(in.eof())
+        {
+            // no trailing newline, the run was killed while writing this line
+            TNTN_LOG_WARN("ignoring incomplete line {} in manifest {}", num_lines, f.name());
+            break;
+        }
+
+        std::istringstream line_in(line);
+        std::string tag;
+        int zoom, x1, y1, x2, y2;
+        if(!(line_in >> tag >> zoom >> x1 >> y1 >> x2 >> y2) || tag != "done")
+        {
+            TNTN_LOG_ERROR("malformed line {} in manifest {}", num_lines, f.name());
+            return false;
+        }
+        m_done.insert(Key(zoom, x1, y1, x2, y2));
+    }
+
+    TNTN_LOG_INFO("manifest {} lists {} finished partitions", f.name(), m_done.size());
+    return true;
+}
+
+bool TileManifest::start(std::shared_ptr<FileLike> f, const std::string& fingerprint)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_file = std::move(f);
+    m_write_position = 0;
+
+    std::string contents = header_line(fingerprint) + "\n";
+    for(const Key& k : m_done)
+    {
+        contents += fmt::format("done {} {} {} {} {}\n",
+                                std::get<0>(k),
+                                std::get<1>(k),
+                                std::get<2>(k),
+                                std::get<3>(k),
+                                std::get<4>(k));
+    }
+    return append_line(contents);
+}
+
+bool TileManifest::is_done(int zoom, const glm::ivec2& tmin, const glm::ivec2& tmax) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_done.count(make_key(zoom, tmin, tmax)) > 0;
+}
+
+bool TileManifest::mark_done(int zoom, const glm::ivec2& tmin, const glm::ivec2& tmax)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_done.insert(make_key(zoom, tmin, tmax)).second)
+    {
+        return true;
+    }
+    return append_line(
+        fmt::format("done {} {} {} {} {}\n", zoom, tmin.x, tmin.y, tmax.x, tmax.y));
+}
+
+size_t TileManifest::num_done() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_done.size();
+}
+
+bool TileManifest::append_line(const std::string& line)
+{
+    if(!m_file || !m_file->write(m_write_position, line))
+    {
+        TNTN_LOG_ERROR("unable to write manifest");
+        return false;
+    }
+    m_write_position += line.size();
+    // make finished partitions visible to a resuming run even if this one is killed
+    m_file->flush();
+    return true;
+}
+
+// 64 bit FNV-1a
+static uint64_t hash_bytes(uint64_t h, const std::vector<unsigned char>& data)
+{
+    for(const unsigned char c : data)
+    {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool TileManifest::fingerprint_file(const std::string& filename, std::string& fingerprint)
+{
+    boost::system::error_code e;
+    const uint64_t file_size = fs::file_size(filename, e);
+    if(e)
+    {
+        TNTN_LOG_ERROR("unable to get size of {}, message: {}", filename, e.message());
+        return false;
+    }
+    const int64_t mtime = static_cast<int64_t>(fs::last_write_time(filename, e));
+    if(e)
+    {
+        TNTN_LOG_ERROR("unable to get modification time of {}, message: {}", filename, e.message());
+        return false;
+    }
+
+    File f;
+    if(!f.open(filename, File::OM_R))
+    {
+        TNTN_LOG_ERROR("unable to open {}", filename);
+        return false;
+    }
+
+    constexpr uint64_t sample_size = 1024 * 1024;
+    std::vector<unsigned char> sample;
+    uint64_t h = 14695981039346656037ULL;
+    f.read(0, sample, static_cast<size_t>(std::min(sample_size, file_size)));
+    h = hash_bytes(h, sample);
+    if(file_size > sample_size)
+    {
+        f.read(file_size - sample_size, sample, sample_size);
+        h = hash_bytes(h, sample);
+    }
+
+    fingerprint = fmt::format("size={} mtime={} hash={:016x}", file_size, mtime, h);
+    return true;
+}
+
+} //namespace tntn
@@ -0,0 +1,488 @@
+#include "tntn/WindowedRaster.h"
+#include "tntn/logging.h"
+#include "tntn/tntn_assert.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace tntn {
+
+void WindowedRaster::set_geometry(unsigned int width,
+                                  unsigned int height,
+                                  double xpos,
+                                  double ypos,
+                                  double cellsize,
+                                  double no_data_value)
+{
+    m_width = width;
+    m_height = height;
+    m_xpos = xpos;
+    m_ypos = ypos;
+    m_cellsize = cellsize;
+    m_no_data_value = no_data_value;
+}
+
+BBox2D WindowedRaster::get_bounding_box() const
+{
+    BBox2D bb;
+
+    bb.min.x = m_xpos + 0.5 * m_cellsize;
+    bb.min.y = m_ypos + 0.5 * m_cellsize;
+
+    bb.max.x = m_xpos + (m_width - 1 + 0.5) * m_cellsize;
+    bb.max.y = m_ypos + (m_height - 1 + 0.5) * m_cellsize;
+
+    return bb;
+}
+
+int WindowedRaster::x2col(double x) const
+{
+    if(m_cellsize > 0)
+    {
+        return (int)(0.5 + ((x - m_xpos - 0.5 * m_cellsize) / m_cellsize));
+    }
+    return 0;
+}
+
+int WindowedRaster::y2row(double y) const
+{
+    if(m_cellsize > 0)
+    {
+        int r_ll = (int)(0.5 + (y - m_ypos - 0.5 * m_cellsize) / m_cellsize);
+        return m_height - r_ll - 1;
+    }
+    return 0;
+}
+
+bool WindowedRaster::crop(
+    const int cx, const int cy, const int cw, const int ch, RasterDouble& dst_raster)
+{
+    return crop_into(cx, cy, cw, ch, dst_raster);
+}
+
+bool WindowedRaster::crop(
+    const int cx, const int cy, const int cw, const int ch, RasterFloat& dst_raster)
+{
+    return crop_into(cx, cy, cw, ch, dst_raster);
+}
+
+bool WindowedRaster::read_float(int x, int y, int w, int h, float* dst)
+{
+    std::vector<double> pixels(static_cast<size_t>(w) * h);
+    if(!read(x, y, w, h, pixels.data()))
+    {
+        return false;
+    }
+    std::copy(pixels.begin(), pixels.end(), dst);
+    return true;
+}
+
+template<typename T>
+bool WindowedRaster::crop_into(
+    const int cx, const int cy, const int cw, const int ch, Raster<T>& dst_raster)
+{
+    const int width = m_width;
+    const int height = m_height;
+
+    const int max_x = std::min(cx + cw, width);
+    const int max_y = std::min(cy + ch, height);
+    const int min_x = std::max(cx, 0);
+    const int min_y = std::max(cy, 0);
+
+    const int crop_width = std::max(max_x - min_x, 0);
+    const int crop_height = std::max(max_y - min_y, 0);
+
+    dst_raster.allocate(crop_width, crop_height);
+    dst_raster.set_no_data_value(m_no_data_value);
+    dst_raster.set_cell_size(m_cellsize);
+
+    // same as Raster::col2x(min_x) and Raster::row2y(max_y - 1) minus half a cell
+    dst_raster.set_pos_x(m_xpos + (min_x + 0.5) * m_cellsize - 0.5 * m_cellsize);
+    dst_raster.set_pos_y(m_ypos + (height - max_y + 0.5) * m_cellsize - 0.5 * m_cellsize);
+
+    if(crop_width == 0 || crop_height == 0)
+    {
+        return true;
+    }
+    return read_pixels(min_x, min_y, crop_width, crop_height, dst_raster.get_ptr());
+}
+
+template<typename T>
+BasicMemoryWindowedRaster<T>::BasicMemoryWindowedRaster(
+    std::shared_ptr<const Raster<T>> raster) :
+    m_owned_raster(std::move(raster)),
+    m_raster(*m_owned_raster)
+{
+    set_geometry(m_raster.get_width(),
+                 m_raster.get_height(),
+                 m_raster.get_pos_x(),
+                 m_raster.get_pos_y(),
+                 m_raster.get_cell_size(),
+                 m_raster.get_no_data_value());
+    set_single_precision(std::is_same<T, float>::value);
+}
+
+template<typename T>
+BasicMemoryWindowedRaster<T>::BasicMemoryWindowedRaster(const Raster<T>& raster) :
+    m_raster(raster)
+{
+    set_geometry(m_raster.get_width(),
+                 m_raster.get_height(),
+                 m_raster.get_pos_x(),
+                 m_raster.get_pos_y(),
+                 m_raster.get_cell_size(),
+                 m_raster.get_no_data_value());
+    set_single_precision(std::is_same<T, float>::value);
+}
+
+template<typename T>
+template<typename U>
+void BasicMemoryWindowedRaster<T>::copy_window(int x, int y, int w, int h, U* dst) const
+{
+    for(int r = 0; r < h; r++)
+    {
+        const T* src = m_raster.get_ptr(y + r) + x;
+        std::copy(src, src + w, dst + static_cast<size_t>(r) * w);
+    }
+}
+
+template<typename T>
+bool BasicMemoryWindowedRaster<T>::read(int x, int y, int w, int h, double* dst)
+{
+    copy_window(x, y, w, h, dst);
+    return true;
+}
+
+template<typename T>
+bool BasicMemoryWindowedRaster<T>::read_float(int x, int y, int w, int h, float* dst)
+{
+    copy_window(x, y, w, h, dst);
+    return true;
+}
+
+template class BasicMemoryWindowedRaster<double>;
+template class BasicMemoryWindowedRaster<float>;
+
+DownsampledWindowedRaster::DownsampledWindowedRaster(std::shared_ptr<WindowedRaster> source,
+                                                     int window_size) :
+    m_source(std::move(source)),
+    m_window_size(std::max(window_size, 1))
+{
+    // parameters as produced by raster_tools::integer_downsample_mean
+    set_geometry(m_source->get_width() / m_window_size,
+                 m_source->get_height() / m_window_size,
+                 m_source->get_pos_x(),
+                 m_source->get_pos_y(),
+                 m_source->get_cell_size() * m_window_size,
+                 m_source->get_no_data_value());
+    set_single_precision(m_source->is_single_precision());
+}
+
+bool DownsampledWindowedRaster::read(int x, int y, int w, int h, double* dst)
+{
+    const int win = m_window_size;
+    const double ndv = get_no_data_value();
+    const int src_w = w * win;
+
+    // the source rows of an output row are read in strips of bounded size and summed up
+    // per output column, so memory does not grow with the window size
+    constexpr int max_strip_pixels = 1 << 20;
+    const int strip_height = std::max(1, std::min(win, max_strip_pixels / src_w));
+    std::vector<double> strip(static_cast<size_t>(src_w) * strip_height);
+    std::vector<double> sums(w);
+    std::vector<int> counts(w);
+
+    for(int r = 0; r < h; r++)
+    {
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+
+        for(int i = 0; i < win; i += strip_height)
+        {
+            const int strip_rows = std::min(strip_height, win - i);
+            if(!m_source->read(x * win, (y + r) * win + i, src_w, strip_rows, strip.data()))
+            {
+                return false;
+            }
+
+            for(int k = 0; k < strip_rows; k++)
+            {
+                const double* p = strip.data() + static_cast<size_t>(k) * src_w;
+                for(int c = 0; c < w; c++)
+                {
+                    for(int j = 0; j < win; j++, p++)
+                    {
+                        if(*p != ndv)
+                        {
+                            sums[c] += *p;
+                            counts[c]++;
+                        }
+                    }
+                }
+            }
+        }
+
+        double* dst_row = dst + static_cast<size_t>(r) * w;
+        for(int c = 0; c < w; c++)
+        {
+            // same rules as integer_downsample_mean
+            dst_row[c] = counts[c] > 0 && sums[c] > 0 ? sums[c] / (double)(counts[c]) : ndv;
+        }
+    }
+    return true;
+}
+
+void BlockCachedWindowedRaster::set_block_layout(int block_width,
+                                                 int block_height,
+                                                 bool flip_x,
+                                                 bool flip_y)
+{
+    m_block_width = std::max(block_width, 1);
+    m_block_height = std::max(block_height, 1);
+    m_flip_x = flip_x;
+    m_flip_y = flip_y;
+}
+
+BlockCachedWindowedRaster::BlockPtr BlockCachedWindowedRaster::get_block(int bx, int by)
+{
+    const uint64_t key = (static_cast<uint64_t>(by) << 32) | static_cast<uint32_t>(bx);
+
+    std::promise<BlockPtr> loaded;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        auto it = m_cache.find(key);
+        if(it != m_cache.end())
+        {
+            m_cache_hits++;
+            m_lru.splice(m_lru.begin(), m_lru, it->second.lru_position);
+            return it->second.block;
+        }
+
+        auto loading = m_loading.find(key);
+        if(loading != m_loading.end())
+        {
+            // another thread is reading the block already
+            m_cache_hits++;
+            std::shared_future<BlockPtr> pending = loading->second;
+            lock.unlock();
+            return pending.get();
+        }
+
+        m_cache_misses++;
+        m_loading.emplace(key, loaded.get_future().share());
+    }
+
+    const int x = bx * m_block_width;
+    const int y = by * m_block_height;
+    const int w = std::min(m_block_width, static_cast<int>(get_width()) - x);
+    const int h = std::min(m_block_height, static_cast<int>(get_height()) - y);
+    const size_t size = static_cast<size_t>(w) * h;
+
+    auto block = std::make_shared<Block>();
+    bool ok = false;
+    if(is_single_precision())
+    {
+        block->float_samples.resize(size);
+        ok = read_block_float(x, y, w, h, block->float_samples.data());
+    }
+    else
+    {
+        block->samples.resize(size);
+        ok = read_block(x, y, w, h, block->samples.data());
+    }
+
+    BlockPtr result = block;
+    if(!ok)
+    {
+        TNTN_LOG_ERROR("reading raster block ({},{}) failed", bx, by);
+        result = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loading.erase(key);
+
+        if(result)
+        {
+            const size_t block_bytes = block->bytes();
+
+            // evict least recently used blocks, the new block is always kept
+            // even if it alone exceeds the budget
+            while(!m_lru.empty() && m_cache_bytes + block_bytes > m_cache_budget)
+            {
+                auto evicted = m_cache.find(m_lru.back());
+                m_cache_bytes -= evicted->second.block->bytes();
+                m_cache.erase(evicted);
+                m_lru.pop_back();
+            }
+
+            m_lru.push_front(key);
+            m_cache[key] = CacheEntry{result, m_lru.begin()};
+            m_cache_bytes += block_bytes;
+        }
+    }
+
+    loaded.set_value(result);
+    return result;
+}
+
+bool BlockCachedWindowedRaster::read_block_float(int x, int y, int w, int h, float* dst)
+{
+    std::vector<double> pixels(static_cast<size_t>(w) * h);
+    if(!read_block(x, y, w, h, pixels.data()))
+    {
+        return false;
+    }
+    std::copy(pixels.begin(), pixels.end(), dst);
+    return true;
+}
+
+// copies n samples from src to out, in reverse order if mirrored
+template<typename S, typename T>
+static void copy_samples(const S* src, const int n, const bool mirrored, T* out)
+{
+    if(mirrored)
+    {
+        std::reverse_copy(src, src + n, out);
+    }
+    else
+    {
+        std::copy(src, src + n, out);
+    }
+}
+
+template<typename T>
+bool BlockCachedWindowedRaster::copy_window(int x, int y, int w, int h, T* dst)
+{
+    // window in source coordinates
+    const int sx = m_flip_x ? get_width() - x - w : x;
+    const int sy = m_flip_y ? get_height() - y - h : y;
+
+    const int bx_begin = sx / m_block_width;
+    const int bx_end = (sx + w - 1) / m_block_width;
+    const int by_begin = sy / m_block_height;
+    const int by_end = (sy + h - 1) / m_block_height;
+
+    for(int by = by_begin; by <= by_end; by++)
+    {
+        for(int bx = bx_begin; bx <= bx_end; bx++)
+        {
+            const BlockPtr block = get_block(bx, by);
+            if(!block)
+            {
+                return false;
+            }
+
+            const int block_x = bx * m_block_width;
+            const int block_y = by * m_block_height;
+            const int block_w = std::min(m_block_width, static_cast<int>(get_width()) - block_x);
+
+            // intersection of block and window in source coordinates
+            const int x1 = std::max(sx, block_x);
+            const int x2 = std::min(sx + w, block_x + block_w);
+            const int y1 = std::max(sy, block_y);
+            const int y2 = std::min(sy + h, block_y + m_block_height);
+
+            for(int src_y = y1; src_y < y2; src_y++)
+            {
+                const size_t offset =
+                    static_cast<size_t>(src_y - block_y) * block_w + (x1 - block_x);
+                const int dst_row = m_flip_y ? sy + h - 1 - src_y : src_y - sy;
+
+                // source column sx + w - 1 - i ends up in column i when mirrored
+                T* out = dst + static_cast<size_t>(dst_row) * w +
+                    (m_flip_x ? sx + w - x2 : x1 - sx);
+
+                if(block->float_samples.empty())
+                {
+                    copy_samples(block->samples.data() + offset, x2 - x1, m_flip_x, out);
+                }
+                else
+                {
+                    copy_samples(block->float_samples.data() + offset, x2 - x1, m_flip_x, out);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool BlockCachedWindowedRaster::read(int x, int y, int w, int h, double* dst)
+{
+    return copy_window(x, y, w, h, dst);
+}
+
+bool BlockCachedWindowedRaster::read_float(int x, int y, int w, int h, float* dst)
+{
+    return copy_window(x, y, w, h, dst);
+}
+
+bool find_changed_region(WindowedRaster& a, WindowedRaster& b, BBox2D& region)
+{
+    region.reset();
+
+    if(a.get_width() != b.get_width() || a.get_height() != b.get_height() ||
+       a.get_pos_x() != b.get_pos_x() || a.get_pos_y() != b.get_pos_y() ||
+       a.get_cell_size() != b.get_cell_size())
+    {
+        TNTN_LOG_ERROR("rasters differ in size or georeference, cannot compare them");
+        return false;
+    }
+
+    const int width = a.get_width();
+    const int height = a.get_height();
+    const double ndv_a = a.get_no_data_value();
+    const double ndv_b = b.get_no_data_value();
+
+    int min_col = width;
+    int max_col = -1;
+    int min_row = height;
+    int max_row = -1;
+
+    constexpr int band_height = 256;
+    RasterDouble band_a;
+    RasterDouble band_b;
+    for(int y = 0; y < height; y += band_height)
+    {
+        const int h = std::min(band_height, height - y);
+        if(!a.crop(0, y, width, h, band_a) || !b.crop(0, y, width, h, band_b))
+        {
+            return false;
+        }
+
+        for(int r = 0; r < h; r++)
+        {
+            const double* row_a = band_a.get_ptr(r);
+            const double* row_b = band_b.get_ptr(r);
+            for(int c = 0; c < width; c++)
+            {
+                // both no data counts as equal even if the no data values differ
+                const bool a_valid = row_a[c] != ndv_a;
+                const bool b_valid = row_b[c] != ndv_b;
+                if(a_valid != b_valid || (a_valid && row_a[c] != row_b[c]))
+                {
+                    min_col = std::min(min_col, c);
+                    max_col = std::max(max_col, c);
+                    min_row = std::min(min_row, y + r);
+                    max_row = std::max(max_row, y + r);
+                }
+            }
+        }
+    }
+
+    if(max_row < 0)
+    {
+        return true;
+    }
+
+    // extent of the changed cells, rows count from the top
+    const double cs = a.get_cell_size();
+    region.min.x = a.get_pos_x() + min_col * cs;
+    region.max.x = a.get_pos_x() + (max_col + 1) * cs;
+    region.min.y = a.get_pos_y() + (height - 1 - max_row) * cs;
+    region.max.y = a.get_pos_y() + (height - min_row) * cs;
+    return true;
+}
+
+} //namespace tntn
@@ -1,5 +1,6 @@
 #include "tntn/ZemlyaMesh.h"
 #include "tntn/TerraUtils.h"
+#include "tntn/terra_scanline.h"
 #include "tntn/logging.h"
 #include "tntn/SurfacePoints.h"
 #include "tntn/DelaunayTriangle.h"
@@ -7,6 +8,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include <array>
 #include <unordered_map>
 #include <cmath>
@@ -40,65 +42,49 @@ static double average_of(
     }
 }
 
-void ZemlyaMesh::greedy_insert(double max_error)
+template<typename T>
+void ZemlyaMesh<T>::greedy_insert(double max_error)
 {
     m_max_error = max_error;
-    m_counter = 0;
     int w = m_raster->get_width();
     int h = m_raster->get_height();
     m_max_level = static_cast<int>(ceil(log2(w > h ? w : h)));
 
     TNTN_LOG_INFO("starting greedy insertion with raster width: {}, height: {}", w, h);
 
-    // Create another raster to store average values
-    m_sample.allocate(w, h);
-    m_sample.set_all(NAN);
-
     const double no_data_value = m_raster->get_no_data_value();
 
-    for(int level = m_max_level - 1; level >= 1; level--)
+    // Build the pyramid of average values bottom up, each step averages four points of the
+    // step below. Only the steps read by the levels below 5 are kept.
+    const int max_step = m_max_level - 1;
+    const int min_kept_step = std::max(1, m_max_level - 6);
+    m_sample.reset(w, h);
+    for(int step = 1; step <= max_step; step++)
     {
-        int step = m_max_level - level;
-        for(int y = 0; y < h; y += pow(2, step))
+        m_sample.allocate_step(step);
+        if(step == 1)
+        {
+            m_sample.for_each_point(step, [&](int y, int x, double& z) {
+                z = average_of(m_raster->value(y - 1, x - 1),
+                               m_raster->value(y - 1, x),
+                               m_raster->value(y, x - 1),
+                               m_raster->value(y, x),
+                               no_data_value);
+            });
+        }
+        else
         {
-            for(int x = 0; x < w; x += pow(2, step))
+            const int d = 1 << (step - 2); // delta
+            m_sample.for_each_point(step, [&](int y, int x, double& z) {
+                z = average_of(m_sample.value(y - d, x - d),
+                               m_sample.value(y - d, x + d),
+                               m_sample.value(y + d, x - d),
+                               m_sample.value(y + d, x + d),
+                               no_data_value);
+            });
+            if(step - 1 < min_kept_step)
             {
-                if(step == 1)
-                {
-                    double v1 = y < h && x < w ? m_raster->value(y, x) : NAN;
-                    double v2 = y < h && x + 1 < w ? m_raster->value(y, x + 1) : NAN;
-                    double v3 = y + 1 < h && x < w ? m_raster->value(y + 1, x) : NAN;
-                    double v4 = y + 1 < h && x + 1 < w ? m_raster->value(y + 1, x + 1) : NAN;
-
-                    if(y + 1 < h && x + 1 < w)
-                    {
-                        m_sample.value(y + 1, x + 1) = average_of(v1, v2, v3, v4, no_data_value);
-                    }
-                }
-                else
-                {
-                    int co = pow(2, step - 1); // offset
-                    int d = pow(2, step - 2); // delta
-
-                    double v1 = y + co - d < h && x + co - d < w
-                        ? m_sample.value(y + co - d, x + co - d)
-                        : NAN;
-                    double v2 = y + co - d < h && x + co + d < w
-                        ? m_sample.value(y + co - d, x + co + d)
-                        : NAN;
-                    double v3 = y + co + d < h && x + co - d < w
-                        ? m_sample.value(y + co + d, x + co - d)
-                        : NAN;
-                    double v4 = y + co + d < h && x + co + d < w
-                        ? m_sample.value(y + co + d, x + co + d)
-                        : NAN;
-
-                    if(y + co < h && x + co < w)
-                    {
-                        m_sample.value(y + co, x + co) =
-                            average_of(v1, v2, v3, v4, no_data_value);
-                    }
-                }
+                m_sample.release_step(step - 1);
             }
         }
     }
@@ -118,17 +104,12 @@ void ZemlyaMesh::greedy_insert(double max_error)
     m_result.value(h - 1, w - 1) = m_raster->value(h - 1, w - 1);
     m_result.value(0, w - 1) = m_raster->value(0, w - 1);
 
-    // Initialize m_insert
-    m_insert.allocate(w, h);
-    m_insert.set_all(NAN);
+    // Initialize m_insert, its steps are added level by level
+    m_insert.reset(w, h);
 
     // Initialize m_used
     m_used.allocate(w, h);
 
-    // Initialize m_token
-    m_token.allocate(w, h);
-    m_token.set_all(0);
-
     // Initialize the mesh to two triangles with the height field grid corners as vertices
     TNTN_LOG_INFO("initialize the mesh with four corner points");
     this->init_mesh(
@@ -141,93 +122,69 @@ void ZemlyaMesh::greedy_insert(double max_error)
         TNTN_LOG_INFO("starting level {}", level);
 
         // Clear m_used
-        m_used.set_all(0);
+        m_used.set_all(false);
 
         // Use points from the original raster starting from level 5 to compensate for the half-pixel offset of average values.
         if(level >= 5 && level <= m_max_level - 1)
         {
-            int step = m_max_level - level;
+            const int step = m_max_level - level;
 
             // Update points from previous levels
-            for(int y = 0; y < h; y++)
+            for(int s = step + 1; s <= max_step; s++)
             {
-                for(int x = 0; x < w; x++)
-                {
-                    double& z = m_insert.value(y, x);
-                    if(terra::is_no_data(z, no_data_value))
+                m_insert.for_each_point(s, [&](int y, int x, double& z) {
+                    if(!terra::is_no_data(z, no_data_value))
                     {
-                        continue;
+                        z = m_raster->value(y, x);
                     }
-                    z = m_raster->value(y, x);
-                }
+                });
             }
 
             // Add new points from this level
-            for(int y = 0; y < h; y += pow(2, step))
-            {
-                for(int x = 0; x < w; x += pow(2, step))
-                {
-                    int co = pow(2, step - 1); // current step's offset
-                    if(y + co < h && x + co < w)
-                    {
-                        m_insert.value(y + co, x + co) = m_raster->value(y + co, x + co);
-                    }
-                }
-            }
+            m_insert.allocate_step(step);
+            m_insert.for_each_point(
+                step, [&](int y, int x, double& z) { z = m_raster->value(y, x); });
+
+            // The averages are not needed any more
+            m_sample.reset(0, 0);
         }
         else if(level < m_max_level)
         {
-            int step = m_max_level - level;
+            const int step = m_max_level - level;
 
             // Update points from previous levels by shrinking their commanding areas
             // This is crucial for transitioning from global averages to local values.
             if(step >= 3)
             {
-                double d = pow(2, step - 3); // delta
+                const int d = 1 << (step - 3); // delta
 
-                for(int y = 0; y < h; y++)
+                for(int s = step + 1; s <= max_step; s++)
                 {
-                    for(int x = 0; x < w; x++)
-                    {
-                        double& z = m_insert.value(y, x);
+                    m_insert.for_each_point(s, [&](int y, int x, double& z) {
                         if(terra::is_no_data(z, no_data_value))
                         {
-                            continue;
+                            return;
                         }
-
-                        const double v1 =
-                            y - d < h && x - d < w ? m_sample.value(y - d, x - d) : NAN;
-                        const double v2 =
-                            y - d < h && x + d < w ? m_sample.value(y - d, x + d) : NAN;
-                        const double v3 =
-                            y + d < h && x - d < w ? m_sample.value(y + d, x - d) : NAN;
-                        const double v4 =
-                            y + d < h && x + d < w ? m_sample.value(y + d, x + d) : NAN;
-                        const double avg = average_of(v1, v2, v3, v4, no_data_value);
-                        if(terra::is_no_data(avg, no_data_value))
+                        const double avg = average_of(m_sample.value(y - d, x - d),
+                                                      m_sample.value(y - d, x + d),
+                                                      m_sample.value(y + d, x - d),
+                                                      m_sample.value(y + d, x + d),
+                                                      no_data_value);
+                        if(!terra::is_no_data(avg, no_data_value))
                         {
-                            continue;
+                            z = avg;
                         }
-                        z = avg;
-                    }
+                    });
                 }
             }
 
             // Add new points from this level
-            for(int y = 0; y < h; y += pow(2, step))
-            {
-                for(int x = 0; x < w; x += pow(2, step))
-                {
-                    int co = pow(2, step - 1); // current step's offset
-                    if(y + co < h && x + co < w)
-                    {
-                        m_insert.value(y + co, x + co) = m_sample.value(y + co, x + co);
-                    }
-                }
-            }
+            m_insert.allocate_step(step);
+            m_insert.for_each_point(
+                step, [&](int y, int x, double& z) { z = m_sample.value(y, x); });
         }
 
-        // Scan all the triangles and push all candidates into a stack
+        // Scan all the triangles and collect their candidates
         dt_ptr t = m_first_face;
         while(t)
         {
@@ -240,13 +197,15 @@ void ZemlyaMesh::greedy_insert(double max_error)
         {
             terra::Candidate candidate = m_candidates.grab_greatest();
 
-            if(candidate.importance < m_max_error) continue;
-
-            // Skip if the candidate is not the latest
-            if(m_token.value(candidate.y, candidate.x) != candidate.token) continue;
+            // The point may have been taken through a neighbouring triangle, look again
+            if(m_used.value(candidate.y, candidate.x))
+            {
+                scan_triangle(candidate.triangle);
+                continue;
+            }
 
-            m_result.value(candidate.y, candidate.x) = candidate.z;
-            m_used.value(candidate.y, candidate.x) = 1;
+            m_result.value(candidate.y, candidate.x) = static_cast<T>(candidate.z);
+            m_used.set(candidate.y, candidate.x);
 
             //TNTN_LOG_DEBUG("inserting point: ({}, {}, {})", candidate.x, candidate.y, candidate.z);
             this->insert(glm::dvec2(candidate.x, candidate.y), candidate.triangle);
@@ -256,40 +215,56 @@ void ZemlyaMesh::greedy_insert(double max_error)
     TNTN_LOG_INFO("finished greedy insertion");
 }
 
-void ZemlyaMesh::scan_triangle_line(const Plane& plane,
-                                    int y,
-                                    double x1,
-                                    double x2,
-                                    Candidate& candidate,
-                                    const double no_data_value)
+template<typename T>
+void ZemlyaMesh<T>::scan_triangle_line(const Plane& plane,
+                                       int y,
+                                       double x1,
+                                       double x2,
+                                       Candidate& candidate,
+                                       const double no_data_value)
 {
     const int startx = static_cast<int>(ceil(fmin(x1, x2)));
     const int endx = static_cast<int>(floor(fmax(x1, x2)));
 
     if(startx > endx) return;
 
-    double z0 = plane.eval(startx, y);
-    const double dz = plane.a;
+    const double row_offset = plane.b * y + plane.c;
+    if(m_current_level == m_max_level)
+    {
+        const T* row = m_raster->get_ptr(y);
+        double error = 0;
+        const int x = terra::scan_row_max_error(
+            row, m_used.get_ptr(y), startx, endx, plane.a, row_offset, no_data_value, error);
+        if(x >= 0)
+        {
+            candidate.consider(x, y, row[x], error);
+        }
+        return;
+    }
 
-    for(int x = startx; x <= endx; x++)
+    // Below the last level only the points of the steps inserted so far are candidates,
+    // in row y these are the ones of its step at every 2^step-th column.
+    const int step = PyramidRaster::step_of(y);
+    if(!m_insert.has_step(step))
+    {
+        return;
+    }
+    const int co = 1 << (step - 1);
+    const int spacing = 1 << step;
+    const int first = startx <= co ? co : co + (startx - co + spacing - 1) / spacing * spacing;
+    for(int x = first; x <= endx; x += spacing)
     {
-        if(!m_used.value(y, x))
+        const double z = m_insert.at(step, y, x);
+        if(m_used.value(y, x) || terra::is_no_data(z, no_data_value))
         {
-            //attention - use m_raster/m_insert depending on level
-            const double z =
-                m_current_level == m_max_level ? m_raster->value(y, x) : m_insert.value(y, x);
-            if(!terra::is_no_data(z, no_data_value))
-            {
-                const double diff = fabs(z - z0);
-                //TNTN_LOG_DEBUG("candidate consider: ({}, {}, {}), diff: {}", x, y, z, diff);
-                candidate.consider(x, y, z, diff);
-            }
+            continue;
         }
-        z0 += dz;
+        candidate.consider(x, y, z, std::abs(z - (plane.a * x + row_offset)));
     }
 }
 
-void ZemlyaMesh::scan_triangle(dt_ptr t)
+template<typename T>
+void ZemlyaMesh<T>::scan_triangle(dt_ptr t)
 {
     Plane z_plane;
     terra::compute_plane(z_plane, t, m_result);
@@ -307,7 +282,7 @@ void ZemlyaMesh::scan_triangle(dt_ptr t)
     const double v2_x = by_y[2].x;
     const double v2_y = by_y[2].y;
 
-    terra::Candidate candidate = {0, 0, 0.0, -DBL_MAX, m_counter++, t};
+    terra::Candidate candidate = {0, 0, 0.0, -DBL_MAX, t};
 
     const double dx2 = (v2_x - v0_x) / (v2_y - v0_y);
     const double no_data_value = m_raster->get_no_data_value();
@@ -319,8 +294,9 @@ void ZemlyaMesh::scan_triangle(dt_ptr t)
         double x1 = v0_x;
         double x2 = v0_x;
 
+        // the row of v1 is scanned with the lower half, or here if there is none
         const int starty = v0_y;
-        const int endy = v1_y;
+        const int endy = v2_y != v1_y ? v1_y : v1_y + 1;
 
         for(int y = starty; y < endy; y++)
         {
@@ -335,7 +311,7 @@ void ZemlyaMesh::scan_triangle(dt_ptr t)
         const double dx1 = (v2_x - v1_x) / (v2_y - v1_y);
 
         double x1 = v1_x;
-        double x2 = v0_x;
+        double x2 = v0_x + dx2 * (v1_y - v0_y);
 
         const int starty = v1_y;
         const int endy = v2_y;
@@ -348,14 +324,20 @@ void ZemlyaMesh::scan_triangle(dt_ptr t)
         }
     }
 
-    // We have now found the appropriate candidate point
-    m_token.value(candidate.y, candidate.x) = candidate.token;
-
-    // Push the candidate into the stack
-    m_candidates.push_back(candidate);
+    // We have now found the appropriate candidate point, it replaces the triangle's
+    // previous one and is only kept while it exceeds the error threshold
+    if(candidate.importance >= m_max_error)
+    {
+        m_candidates.update(candidate);
+    }
+    else
+    {
+        m_candidates.remove(t);
+    }
 }
 
-std::unique_ptr<Mesh> ZemlyaMesh::convert_to_mesh()
+template<typename T>
+std::unique_ptr<Mesh> ZemlyaMesh<T>::convert_to_mesh()
 {
     // Find all the vertices
     int w = m_raster->get_width();
@@ -419,5 +401,8 @@ std::unique_ptr<Mesh> ZemlyaMesh::convert_to_mesh()
     return mesh;
 }
 
+template class ZemlyaMesh<double>;
+template class ZemlyaMesh<float>;
+
 } //namespace zemlya
 } //namespace tntn
@@ -582,6 +582,52 @@ class BenchmarkMeshingMethodZemlya : public BenchmarkMeshingMethodTerraLike
     }
 };
 
+// single precision variants of terra and zemlya on the same input, their error statistics
+// against the original raster show the precision lost compared to the double variants
+class BenchmarkMeshingMethodTerraFloat : public BenchmarkMeshingMethodTerraLike
+{
+  public:
+    std::string name() const override { return "terra_float"; }
+
+  protected:
+    std::unique_ptr<Mesh> generate_tin_like_terra(const SurfacePoints& sp,
+                                                  const double max_error) const override
+    {
+        auto raster = std::make_unique<RasterFloat>(sp.to_raster()->convert<float>());
+        return generate_tin_terra(std::move(raster), max_error);
+    }
+};
+
+class BenchmarkMeshingMethodZemlyaFloat : public BenchmarkMeshingMethodTerraLike
+{
+  public:
+    std::string name() const override { return "zemlya_float"; }
+
+  protected:
+    std::unique_ptr<Mesh> generate_tin_like_terra(const SurfacePoints& sp,
+                                                  const double max_error) const override
+    {
+        auto raster = std::make_unique<RasterFloat>(sp.to_raster()->convert<float>());
+        return generate_tin_zemlya(std::move(raster), max_error);
+    }
+};
+
+// terra meshing blocks of the raster on all cores, compared to terra it shows what the seams
+// between the blocks cost in vertices and error
+class BenchmarkMeshingMethodTerraBlocks : public BenchmarkMeshingMethodTerraLike
+{
+  public:
+    std::string name() const override { return "terra_blocks"; }
+
+  protected:
+    std::unique_ptr<Mesh> generate_tin_like_terra(const SurfacePoints& sp,
+                                                  const double max_error) const override
+    {
+        ThreadPool thread_pool(0);
+        return generate_tin_terra(sp.to_raster(), max_error, thread_pool);
+    }
+};
+
 static bool prepare_parametrization_subdir(const fs::path& output_dir,
                                            const BenchmarkMeshingMethod& method,
                                            const int parametrization,
@@ -743,6 +789,9 @@ static bool run_all_dem2tin_method_benchmarks_on_single_file(
     available_methods.push_back(std::make_unique<BenchmarkMeshingMethodRegular>());
     available_methods.push_back(std::make_unique<BenchmarkMeshingMethodTerra>());
     available_methods.push_back(std::make_unique<BenchmarkMeshingMethodZemlya>());
+    available_methods.push_back(std::make_unique<BenchmarkMeshingMethodTerraFloat>());
+    available_methods.push_back(std::make_unique<BenchmarkMeshingMethodZemlyaFloat>());
+    available_methods.push_back(std::make_unique<BenchmarkMeshingMethodTerraBlocks>());
 
 #if defined(TNTN_USE_ADDONS) && TNTN_USE_ADDONS
     available_methods.push_back(std::make_unique<BenchmarkMeshingMethodCurvature>());
@@ -14,6 +14,9 @@
 #include "tntn/version_info.h"
 #include "tntn/RasterOverviews.h"
 #include "tntn/println.h"
+#include "tntn/ThreadPool.h"
+#include "tntn/TileArchive.h"
+#include "tntn/TileAvailability.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
@@ -22,6 +25,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include <chrono>
+#include <sstream>
 #include <string>
 
 namespace po = boost::program_options;
@@ -41,6 +45,37 @@ struct subcommand_t
     const char* description;
 };
 
+static bool find_update_region(const po::variables_map& varmap,
+                               const std::string& input_file,
+                               BBox2D& region)
+{
+    if(varmap.count("update-region"))
+    {
+        const std::string box = varmap["update-region"].as<std::string>();
+        double minx, miny, maxx, maxy;
+        char c1, c2, c3;
+        std::istringstream in(box);
+        if(!(in >> minx >> c1 >> miny >> c2 >> maxx >> c3 >> maxy) || c1 != ',' || c2 != ',' ||
+           c3 != ',' || minx > maxx || miny > maxy)
+        {
+            throw po::error(std::string("invalid --update-region ") + box);
+        }
+        region = BBox2D(glm::dvec2(minx, miny), glm::dvec2(maxx, maxy));
+        return true;
+    }
+
+    // only bands of both rasters are held in memory while comparing
+    const size_t cache_budget = 64 << 20;
+    const std::string previous_file = varmap["update-from"].as<std::string>();
+    auto previous = open_windowed_raster_file(previous_file, cache_budget);
+    auto current = open_windowed_raster_file(input_file, cache_budget);
+    if(!previous || !current)
+    {
+        return false;
+    }
+    return find_changed_region(*previous, *current, region);
+}
+
 static int subcommand_dem2tintiles(bool need_help,
                                    const po::variables_map& global_varmap,
                                    const std::vector<std::string>& unrecognized)
@@ -50,11 +85,23 @@ static int subcommand_dem2tintiles(bool need_help,
     subdesc.add_options()
         ("input", po::value<std::string>(), "input filename")
         ("output-dir", po::value<std::string>()->default_value("./output"))
+        ("output-container", po::value<std::string>(), "pack all tiles into this single archive file instead of writing a z/x/y directory tree")
         ("max-zoom", po::value<int>()->default_value(-1), "maximum zoom level to generate tiles for. will guesstimate from resolution if not provided.")
         ("min-zoom", po::value<int>()->default_value(-1), "minimum zoom level to generate tiles for will guesstimate from resolution if not provided.")
         ("max-error", po::value<double>(), "max error parameter when using terra or zemlya method")
         ("step", po::value<int>()->default_value(1), "grid spacing in pixels when using dense method")
         ("output-format", po::value<std::string>()->default_value("terrain"), "output tiles in terrain (quantized mesh) or obj")
+        ("optimize-triangle-order", "reorder triangles and vertices of terrain tiles for GPU vertex cache reuse before encoding")
+        ("vertex-normals", "add per vertex normals to terrain tiles using the octvertexnormals extension for lighting")
+        ("gzip-level", po::value<int>()->default_value(0), "gzip compress terrain tiles with this zlib level (1-9) for serving with Content-Encoding: gzip, 0 writes them uncompressed")
+        ("threads", po::value<int>()->default_value(1), "number of threads used to mesh partitions and to encode tiles, 0 uses all available cores")
+        ("queue-size", po::value<int>()->default_value(0), "number of items buffered between pipeline stages, 0 picks 4 per thread")
+        ("terra-block-size", po::value<int>()->default_value(0), "mesh terra partitions larger than this many pixels in blocks of this size in parallel, 0 meshes each partition in one piece")
+        ("cascaded-overviews", "compute each zoom level by 2x2 downsampling of the previous one instead of from the input raster")
+        ("resume", "skip partitions a previous run with the same input and parameters has finished, as recorded in the manifest in output-dir")
+        ("update-region", po::value<std::string>(), "only regenerate the tiles of an existing output-dir affected by input changes inside this box, given as minx,miny,maxx,maxy in input raster coordinates")
+        ("update-from", po::value<std::string>(), "only regenerate the tiles of an existing output-dir affected by the differences between this raster, the previous input, and --input")
+        ("raster-cache-mb", po::value<int>()->default_value(0), "read the input raster window by window keeping at most this many MB of decoded blocks, 0 loads the whole raster into memory")
 #if defined(TNTN_USE_ADDONS) && TNTN_USE_ADDONS
         ("method", po::value<std::string>()->default_value("terra"), "meshing algorithm. one of: terra, zemlya, curvature or dense")
         ("threshold", po::value<double>(), "threshold when using curvature method");
@@ -95,6 +142,51 @@ static int subcommand_dem2tintiles(bool need_help,
         throw po::error("max zoom is less than min zoom");
     }
 
+    const int num_threads = local_varmap["threads"].as<int>();
+    if(num_threads < 0)
+    {
+        throw po::error("--threads must not be negative");
+    }
+
+    const int requested_queue_size = local_varmap["queue-size"].as<int>();
+    if(requested_queue_size < 0)
+    {
+        throw po::error("--queue-size must not be negative");
+    }
+
+    const int raster_cache_mb = local_varmap["raster-cache-mb"].as<int>();
+    if(raster_cache_mb < 0)
+    {
+        throw po::error("--raster-cache-mb must not be negative");
+    }
+
+    const int terra_block_size = local_varmap["terra-block-size"].as<int>();
+    if(terra_block_size < 0)
+    {
+        throw po::error("--terra-block-size must not be negative");
+    }
+    if(raster_cache_mb > 0 && local_varmap.count("cascaded-overviews") > 0)
+    {
+        throw po::error("--cascaded-overviews can not be combined with --raster-cache-mb");
+    }
+
+    const bool resume = local_varmap.count("resume") > 0;
+    if(resume && local_varmap.count("output-container") > 0)
+    {
+        throw po::error("--resume can not be combined with --output-container");
+    }
+
+    const bool update =
+        local_varmap.count("update-region") > 0 || local_varmap.count("update-from") > 0;
+    if(local_varmap.count("update-region") > 0 && local_varmap.count("update-from") > 0)
+    {
+        throw po::error("--update-region and --update-from are mutually exclusive");
+    }
+    if(update && (resume || local_varmap.count("output-container") > 0))
+    {
+        throw po::error("updating tiles can not be combined with --resume or --output-container");
+    }
+
     if(!local_varmap.count("input"))
     {
         throw po::error("no --input option given");
@@ -122,15 +214,31 @@ static int subcommand_dem2tintiles(bool need_help,
         throw po::error("max-error must be positive");
     }
 
+    const int gzip_level = local_varmap["gzip-level"].as<int>();
+    if(gzip_level < 0 || gzip_level > 9)
+    {
+        throw po::error("--gzip-level must be in range [0,9]");
+    }
+
     std::unique_ptr<MeshWriter> w;
 
     if(local_varmap["output-format"].as<std::string>() == "obj")
     {
+        if(gzip_level > 0)
+        {
+            throw po::error("--gzip-level is only supported for terrain output");
+        }
+        if(local_varmap.count("vertex-normals") > 0)
+        {
+            throw po::error("--vertex-normals is only supported for terrain output");
+        }
         w.reset(new ObjMeshWriter());
     }
     else if(local_varmap["output-format"].as<std::string>() == "terrain")
     {
-        w.reset(new QuantizedMeshWriter());
+        w.reset(new QuantizedMeshWriter(local_varmap.count("optimize-triangle-order") > 0,
+                                        gzip_level,
+                                        local_varmap.count("vertex-normals") > 0));
     }
     else
     {
@@ -140,16 +248,44 @@ static int subcommand_dem2tintiles(bool need_help,
 
     const std::string meshing_method = local_varmap["method"].as<std::string>();
 
-    auto input_raster = std::make_unique<RasterDouble>();
+    // sources with 8 or 16 bit integer or Float32 samples are kept in single precision
+    std::unique_ptr<RasterDouble> input_raster;
+    std::unique_ptr<RasterFloat> input_raster_float;
+    std::shared_ptr<BlockCachedWindowedRaster> windowed_input;
+    double input_cell_size = 0;
 
-    if(!load_raster_file(input_file.c_str(), *input_raster))
+    if(raster_cache_mb > 0)
     {
-        return false;
+        windowed_input =
+            open_windowed_raster_file(input_file, static_cast<size_t>(raster_cache_mb) << 20);
+        if(!windowed_input)
+        {
+            return -2;
+        }
+        input_cell_size = windowed_input->get_cell_size();
+    }
+    else if(is_single_precision_raster_file(input_file))
+    {
+        input_raster_float = std::make_unique<RasterFloat>();
+        if(!load_raster_file(input_file, *input_raster_float))
+        {
+            return -2;
+        }
+        input_cell_size = input_raster_float->get_cell_size();
+    }
+    else
+    {
+        input_raster = std::make_unique<RasterDouble>();
+        if(!load_raster_file(input_file.c_str(), *input_raster))
+        {
+            return -2;
+        }
+        input_cell_size = input_raster->get_cell_size();
     }
 
     if("zemlya" == meshing_method || "terra" == meshing_method)
     {
-        max_error = input_raster->get_cell_size();
+        max_error = input_cell_size;
         if(local_varmap.count("max-error"))
         {
             max_error_given = true;
@@ -176,52 +312,228 @@ static int subcommand_dem2tintiles(bool need_help,
         throw po::error(std::string("unknown method ") + meshing_method);
     }
 
-    RasterOverviews overviews(std::move(input_raster), min_zoom, max_zoom);
+    const int pipeline_threads =
+        num_threads == 0 ? ThreadPool::hardware_concurrency() : num_threads;
+    const size_t queue_size = requested_queue_size > 0 ? requested_queue_size : 4 * pipeline_threads;
+
+    // at most pipeline_threads threads mesh at the same time. with a terra block size half of
+    // them mesh partitions and the workers of the pool help them with their blocks.
+    // the pool also computes the in-memory overviews next to the overview stage
+    const int meshing_threads =
+        terra_block_size > 0 ? std::max(1, pipeline_threads / 2) : pipeline_threads;
+    ThreadPool thread_pool(pipeline_threads - meshing_threads + 1);
+    TNTN_LOG_INFO("using {} meshing, {} encoding and {} pool worker threads, queue size {}",
+                  meshing_threads,
+                  meshing_threads,
+                  thread_pool.num_threads() - 1,
+                  queue_size);
+
+    std::unique_ptr<TileArchiveWriter> archive;
+    if(local_varmap.count("output-container"))
+    {
+        const std::string archive_file = local_varmap["output-container"].as<std::string>();
+        auto f = std::make_shared<File>();
+        archive = std::make_unique<TileArchiveWriter>();
+        if(!f->open(archive_file, File::OM_RWCF) || !archive->open(f))
+        {
+            TNTN_LOG_ERROR("unable to create tile archive {}", archive_file);
+            return -2;
+        }
+    }
 
-    RasterOverview overview;
+    PartitionFilter partition_filter;
+    if(update)
+    {
+        BBox2D dirty_region;
+        if(!find_update_region(local_varmap, input_file, dirty_region))
+        {
+            return -2;
+        }
+        if(dirty_region.min.x > dirty_region.max.x || dirty_region.min.y > dirty_region.max.y)
+        {
+            TNTN_LOG_INFO("input unchanged, nothing to update");
+            return 0;
+        }
+        TNTN_LOG_INFO("updating tiles affected by changes in {}", dirty_region.to_string());
+        partition_filter = dirty_region_filter(dirty_region);
+    }
 
-    while(overviews.next(overview))
+    // the manifest records finished partitions so that --resume can skip them,
+    // everything influencing the tiles goes into its fingerprint.
+    // an update leaves the manifest alone, it no longer matches the input anyway
+    std::unique_ptr<TileManifest> manifest;
+    if(!archive && !update)
     {
-        if(!max_error_given)
+        namespace fs = boost::filesystem;
+
+        std::string input_fingerprint;
+        if(!TileManifest::fingerprint_file(input_file, input_fingerprint))
+        {
+            return -2;
+        }
+        const std::string fingerprint = fmt::format(
+            "{} method={} max_error={} min_zoom={} max_zoom={} format={} gzip={} overviews={}"
+            "{}{}{}",
+            input_fingerprint,
+            meshing_method,
+            max_error_given ? fmt::format("{}", max_error) : std::string("auto"),
+            min_zoom,
+            max_zoom,
+            w->file_extension(),
+            gzip_level,
+            local_varmap.count("cascaded-overviews") > 0 ? "cascaded" : "direct",
+            local_varmap.count("optimize-triangle-order") > 0 ? " optimize_triangle_order" : "",
+            w->wants_vertex_normals() ? " vertex_normals" : "",
+            terra_block_size > 0 ? fmt::format(" terra_block_size={}", terra_block_size)
+                                 : std::string());
+
+        const fs::path manifest_path = fs::path(output_basedir) / "tntn_manifest";
+        manifest = std::make_unique<TileManifest>();
+
+        boost::system::error_code e;
+        if(resume && fs::exists(manifest_path, e))
         {
-            max_error = overview.resolution;
+            File in;
+            if(!in.open(manifest_path.string(), File::OM_R) || !manifest->load(in, fingerprint))
+            {
+                return -2;
+            }
+        }
+        else if(resume)
+        {
+            TNTN_LOG_WARN("no manifest found in {}, starting from scratch", output_basedir);
         }
 
-        const int zoom_level = overview.zoom_level;
+        // rewrite the manifest next to the old one and swap, so a crash never loses it
+        fs::create_directories(output_basedir);
+        const fs::path manifest_tmp_path = fs::path(output_basedir) / "tntn_manifest.tmp";
+        auto out = std::make_shared<File>();
+        if(!out->open(manifest_tmp_path.string(), File::OM_RWCF) ||
+           !manifest->start(out, fingerprint))
+        {
+            TNTN_LOG_ERROR("unable to write manifest {}", manifest_tmp_path.string());
+            return -2;
+        }
+        fs::rename(manifest_tmp_path, manifest_path);
+    }
 
-        int overview_width = overview.raster->get_width();
-        int overview_height = overview.raster->get_height();
+    // layer.json lists the tiles that exist, so that clients do not request missing ones.
+    // an update only rewrites some tiles, it extends the availability of the previous run
+    std::unique_ptr<TileAvailability> availability;
+    const boost::filesystem::path layer_json_path =
+        boost::filesystem::path(output_basedir) / "layer.json";
+    if(!archive && w->file_extension() == "terrain")
+    {
+        availability = std::make_unique<TileAvailability>();
+        if(update)
+        {
+            File in;
+            if(!in.open(layer_json_path.string(), File::OM_R) ||
+               !availability->read_layer_json(in))
+            {
+                TNTN_LOG_WARN("no usable layer.json in {}, it will not be updated",
+                              output_basedir);
+                availability.reset();
+            }
+        }
+    }
 
-        if(overview_height < 1 || overview_width < 1)
+    bool tiles_created = false;
+    if(windowed_input)
+    {
+        tiles_created = create_tiles_pipelined(windowed_input,
+                                               min_zoom,
+                                               max_zoom,
+                                               output_basedir,
+                                               max_error_given ? max_error : -1.0,
+                                               meshing_method,
+                                               *w,
+                                               meshing_threads,
+                                               queue_size,
+                                               archive.get(),
+                                               manifest.get(),
+                                               partition_filter,
+                                               availability.get(),
+                                               terra_block_size,
+                                               &thread_pool);
+        TNTN_LOG_INFO("raster block cache: {} hits, {} misses",
+                      windowed_input->cache_hits(),
+                      windowed_input->cache_misses());
+    }
+    else
+    {
+        const OverviewMode overview_mode = local_varmap.count("cascaded-overviews") > 0
+            ? OverviewMode::cascaded
+            : OverviewMode::direct;
+
+        auto create_tiles = [&](auto& overviews) {
+            return create_tiles_pipelined(overviews,
+                                          output_basedir,
+                                          max_error_given ? max_error : -1.0,
+                                          meshing_method,
+                                          *w,
+                                          meshing_threads,
+                                          queue_size,
+                                          archive.get(),
+                                          manifest.get(),
+                                          partition_filter,
+                                          availability.get(),
+                                          terra_block_size,
+                                          &thread_pool);
+        };
+
+        if(input_raster_float)
+        {
+            RasterOverviewsFloat overviews(std::move(input_raster_float),
+                                           min_zoom,
+                                           max_zoom,
+                                           overview_mode,
+                                           &thread_pool);
+            tiles_created = create_tiles(overviews);
+        }
+        else
         {
-            TNTN_LOG_WARN("raster on zoom level {} empty, cannot create tiles, proceeding...",
-                          zoom_level);
-            continue;
+            RasterOverviews overviews(std::move(input_raster),
+                                      min_zoom,
+                                      max_zoom,
+                                      overview_mode,
+                                      &thread_pool);
+            tiles_created = create_tiles(overviews);
         }
+    }
 
-        TNTN_LOG_INFO("Processing zoom level {}, raster size {}x{}",
-                      zoom_level,
-                      overview_width,
-                      overview_height);
+    if(tiles_created && archive)
+    {
+        tiles_created = archive->finish();
+    }
 
-        const auto& partitions = create_partitions_for_zoom_level(*overview.raster, zoom_level);
+    if(!tiles_created)
+    {
+        TNTN_LOG_ERROR("error creating tiles");
+        return -2;
+    }
 
-        if(partitions.empty())
+    if(availability)
+    {
+        std::vector<std::string> extensions;
+        if(w->wants_vertex_normals())
         {
-            continue;
+            extensions.push_back("octvertexnormals");
         }
 
-        if(!create_tiles_for_zoom_level(*overview.raster,
-                                        partitions,
-                                        zoom_level,
-                                        output_basedir,
-                                        max_error,
-                                        meshing_method,
-                                        *w))
+        // written next to the old one and swapped, readers never see a partial file
+        const boost::filesystem::path layer_json_tmp_path =
+            boost::filesystem::path(output_basedir) / "layer.json.tmp";
+        File out;
+        if(!out.open(layer_json_tmp_path.string(), File::OM_RWCF) ||
+           !availability->write_layer_json(out, w->file_extension(), extensions) ||
+           !out.close())
         {
-            TNTN_LOG_ERROR("error creating files for zoom level {}", zoom_level);
+            TNTN_LOG_ERROR("unable to write {}", layer_json_tmp_path.string());
             return -2;
         }
+        boost::filesystem::rename(layer_json_tmp_path, layer_json_path);
+        TNTN_LOG_INFO("layer.json lists {} tiles", availability->num_tiles());
     }
 
     return 0;
@@ -284,6 +596,8 @@ static int subcommand_dem2tin(bool need_help,
         ("output-format", po::value<std::string>()->default_value("auto"), "output file format, can be any of: auto, obj, off, terrain (quantized mesh), json/geojson")
         ("max-error", po::value<double>(), "max error parameter when using terra or zemlya method")
         ("step", po::value<int>(), "grid spacing in pixels when using dense method")
+        ("terra-block-size", po::value<int>()->default_value(0), "mesh rasters larger than this many pixels in blocks of this size with the terra method, 0 meshes the raster in one piece")
+        ("threads", po::value<int>()->default_value(1), "number of threads meshing the blocks of --terra-block-size in parallel, 0 uses all available cores")
 #if defined(TNTN_USE_ADDONS) && TNTN_USE_ADDONS
         ("threshold", po::value<double>(), "threshold when using curvature method")
         ("method", po::value<std::string>()->default_value("terra"), "meshing method, valid values are: dense, terra, zemlya, curvature");
@@ -344,10 +658,31 @@ static int subcommand_dem2tin(bool need_help,
 
     const std::string method = local_varmap["method"].as<std::string>();
 
+    const int num_threads = local_varmap["threads"].as<int>();
+    if(num_threads < 0)
+    {
+        throw po::error("--threads must not be negative");
+    }
+
+    const int terra_block_size = local_varmap["terra-block-size"].as<int>();
+    if(terra_block_size < 0)
+    {
+        throw po::error("--terra-block-size must not be negative");
+    }
+    if(num_threads != 1 && terra_block_size == 0)
+    {
+        TNTN_LOG_WARN("--threads has no effect without --terra-block-size");
+    }
+
+    // terra and zemlya mesh sources with single precision samples in single precision
+    const bool single_precision =
+        (method == "terra" || method == "zemlya") && is_single_precision_raster_file(input_file);
     auto raster = std::make_unique<RasterDouble>();
+    auto raster_float = std::make_unique<RasterFloat>();
 
     // Import raster file without projection validation
-    if(!load_raster_file(input_file, *raster, false))
+    if(!(single_precision ? load_raster_file(input_file, *raster_float, false)
+                          : load_raster_file(input_file, *raster, false)))
     {
         TNTN_LOG_ERROR("Unable to load input file, aborting");
         return false;
@@ -361,7 +696,8 @@ static int subcommand_dem2tin(bool need_help,
 
     if(method == "terra" || method == "zemlya")
     {
-        double max_error = raster->get_cell_size();
+        double max_error =
+            single_precision ? raster_float->get_cell_size() : raster->get_cell_size();
         if(local_varmap.count("max-error"))
         {
             max_error = local_varmap["max-error"].as<double>();
@@ -370,12 +706,30 @@ static int subcommand_dem2tin(bool need_help,
         if("terra" == method)
         {
             TNTN_LOG_INFO("performing terra meshing...");
-            mesh = generate_tin_terra(std::move(raster), max_error);
+            if(terra_block_size == 0)
+            {
+                mesh = single_precision ? generate_tin_terra(std::move(raster_float), max_error)
+                                        : generate_tin_terra(std::move(raster), max_error);
+            }
+            else
+            {
+                // the blocks only depend on the block size, the pool just runs them
+                ThreadPool thread_pool(num_threads);
+                TNTN_LOG_INFO("meshing blocks of {} pixels on {} threads",
+                              terra_block_size,
+                              thread_pool.num_threads());
+                mesh = single_precision
+                    ? generate_tin_terra(
+                          std::move(raster_float), max_error, thread_pool, terra_block_size)
+                    : generate_tin_terra(
+                          std::move(raster), max_error, thread_pool, terra_block_size);
+            }
         }
         else if("zemlya" == method)
         {
             TNTN_LOG_INFO("performing zemlya meshing...");
-            mesh = generate_tin_zemlya(std::move(raster), max_error);
+            mesh = single_precision ? generate_tin_zemlya(std::move(raster_float), max_error)
+                                    : generate_tin_zemlya(std::move(raster), max_error);
         }
     }
     else if(method == "dense")
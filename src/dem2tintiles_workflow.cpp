@@ -4,8 +4,15 @@
 #include "tntn/simple_meshing.h"
 #include "tntn/zemlya_meshing.h"
 #include "tntn/TileMaker.h"
+#include "tntn/BoundedQueue.h"
+#include "tntn/File.h"
 #include "tntn/logging.h"
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 #include <boost/filesystem.hpp>
 
@@ -13,14 +20,13 @@ namespace tntn {
 
 namespace fs = boost::filesystem;
 
-std::vector<Partition> create_partitions_for_zoom_level(const RasterDouble& dem, int zoom)
+static std::vector<Partition> create_partitions(const BBox2D& points_bbox,
+                                                double resolution,
+                                                int zoom)
 {
     MercatorProjection projection;
     std::vector<Partition> partitions;
 
-    double resolution = dem.get_cell_size();
-    const auto points_bbox = dem.get_bounding_box();
-
     // const auto points_bbox = points.bounding_box();
 
     auto tile_xy = projection.MetersToTileXY({points_bbox.min.x, points_bbox.min.y}, zoom);
@@ -63,49 +69,140 @@ std::vector<Partition> create_partitions_for_zoom_level(const RasterDouble& dem,
     return partitions;
 }
 
-bool create_tiles_for_zoom_level(const RasterDouble& dem,
-                                 const std::vector<Partition>& partitions,
-                                 int zoom,
-                                 const std::string& output_basedir,
-                                 const double method_parameter,
-                                 const std::string& meshing_method,
-                                 MeshWriter& mesh_writer)
+std::vector<Partition> create_partitions_for_zoom_level(const RasterDouble& dem, int zoom)
+{
+    return create_partitions(dem.get_bounding_box(), dem.get_cell_size(), zoom);
+}
+
+std::vector<Partition> create_partitions_for_zoom_level(const WindowedRaster& dem, int zoom)
+{
+    return create_partitions(dem.get_bounding_box(), dem.get_cell_size(), zoom);
+}
+
+PartitionFilter dirty_region_filter(const BBox2D& region)
 {
-    for(const auto& part : partitions)
+    return [region](const Partition& part, int zoom, double cell_size) {
+        // a changed source cell spreads into the downsampled cell containing it,
+        // one more cell covers the rounding of the partition window to whole cells
+        BBox2D affected = region;
+        affected.grow(2 * cell_size);
+
+        const BBox2D window(part.bbox.min, part.bbox.max);
+        return window.intersects(affected, 0);
+    };
+}
+
+template<typename T>
+static bool crop_partition(WindowedRaster& dem, const Partition& part, Raster<T>& raster_tile)
+{
+    const auto bbox = part.bbox;
+    TNTN_LOG_DEBUG("current tile bbox (world coordinates) [({},{}),({},{})]",
+                   bbox.min.x,
+                   bbox.min.y,
+                   bbox.max.x,
+                   bbox.max.y);
+
+    int x1 = dem.x2col(bbox.min.x);
+    int y1 = dem.y2row(bbox.min.y);
+
+    int x2 = dem.x2col(bbox.max.x);
+    int y2 = dem.y2row(bbox.max.y);
+
+    TNTN_LOG_DEBUG("current tile raster crop box: [({},{}),({},{})]", x1, y1, x2, y2);
+
+    if(x2 < x1)
     {
-        const auto bbox = part.bbox;
-        TNTN_LOG_DEBUG("current tile bbox (world coordinates) [({},{}),({},{})]",
-                       bbox.min.x,
-                       bbox.min.y,
-                       bbox.max.x,
-                       bbox.max.y);
+        std::swap(x1, x2);
+    }
 
-        int x1 = dem.x2col(bbox.min.x);
-        int y1 = dem.y2row(bbox.min.y);
+    if(y2 < y1)
+    {
+        std::swap(y1, y2);
+    }
 
-        int x2 = dem.x2col(bbox.max.x);
-        int y2 = dem.y2row(bbox.max.y);
+    if(!dem.crop(x1, y1, x2 - x1, y2 - y1, raster_tile))
+    {
+        TNTN_LOG_ERROR("reading raster window for partition failed");
+        return false;
+    }
+    return true;
+}
 
-        TNTN_LOG_DEBUG("current tile raster crop box: [({},{}),({},{})]", x1, y1, x2, y2);
+// a positive block_size meshes rasters larger than one block in blocks of that size on
+// thread_pool, the blocks only depend on block_size so the mesh does not depend on the pool
+template<typename T>
+static std::unique_ptr<Mesh> mesh_partition_terra(std::unique_ptr<Raster<T>> raster_tile,
+                                                  const double max_error,
+                                                  const int block_size,
+                                                  ThreadPool& thread_pool)
+{
+    if(block_size > 0)
+    {
+        return generate_tin_terra(std::move(raster_tile), max_error, thread_pool, block_size);
+    }
+    return generate_tin_terra(std::move(raster_tile), max_error);
+}
 
-        if(x2 < x1)
+// the meshing methods make up a flat surface for a raster without valid samples
+template<typename T>
+static bool has_valid_samples(const Raster<T>& raster)
+{
+    for(unsigned int r = 0; r < raster.get_height(); r++)
+    {
+        const T* row = raster.get_ptr(r);
+        for(unsigned int c = 0; c < raster.get_width(); c++)
         {
-            std::swap(x1, x2);
+            if(!raster.is_no_data(row[c]))
+            {
+                return true;
+            }
         }
+    }
+    return false;
+}
+
+static std::unique_ptr<Mesh> mesh_partition(WindowedRaster& dem,
+                                            const Partition& part,
+                                            const double method_parameter,
+                                            const std::string& meshing_method,
+                                            const int terra_block_size,
+                                            ThreadPool& thread_pool)
+{
+    std::unique_ptr<Mesh> mesh;
 
-        if(y2 < y1)
+    // terra and zemlya mesh single precision sources in single precision
+    if(dem.is_single_precision() && (meshing_method == "terra" || meshing_method == "zemlya"))
+    {
+        auto raster_tile = std::make_unique<RasterFloat>();
+        if(!crop_partition(dem, part, *raster_tile))
         {
-            std::swap(y1, y2);
+            return nullptr;
         }
-
+        if(!has_valid_samples(*raster_tile))
+        {
+            return std::make_unique<Mesh>();
+        }
+        mesh = meshing_method == "terra"
+            ? mesh_partition_terra(
+                  std::move(raster_tile), method_parameter, terra_block_size, thread_pool)
+            : generate_tin_zemlya(std::move(raster_tile), method_parameter);
+    }
+    else
+    {
         auto raster_tile = std::make_unique<RasterDouble>();
-        dem.crop(x1, y1, x2 - x1, y2 - y1, *raster_tile);
-
-        std::unique_ptr<Mesh> mesh;
+        if(!crop_partition(dem, part, *raster_tile))
+        {
+            return nullptr;
+        }
+        if(!has_valid_samples(*raster_tile))
+        {
+            return std::make_unique<Mesh>();
+        }
 
         if(meshing_method == "terra")
         {
-            mesh = generate_tin_terra(std::move(raster_tile), method_parameter);
+            mesh = mesh_partition_terra(
+                std::move(raster_tile), method_parameter, terra_block_size, thread_pool);
         }
         else if(meshing_method == "zemlya")
         {
@@ -124,38 +221,657 @@ bool create_tiles_for_zoom_level(const RasterDouble& dem,
         else
         {
             TNTN_LOG_ERROR("Unknown meshing method {}, aborting", meshing_method);
-            return false;
+            return nullptr;
         }
+    }
 
-        // Cut the TIN into tiles
-        TileMaker tm;
-        tm.loadMesh(std::move(mesh));
+    if(!mesh)
+    {
+        TNTN_LOG_ERROR("meshing of partition with tiles ({},{}) - ({},{}) failed",
+                       part.tmin.x,
+                       part.tmin.y,
+                       part.tmax.x,
+                       part.tmax.y);
+    }
+    return mesh;
+}
 
-        fs::create_directory(fs::path(output_basedir));
-        fs::create_directory(fs::path(output_basedir) / std::to_string(zoom));
+namespace {
 
-        for(int tx = part.tmin.x; tx <= part.tmax.x; tx++)
+struct ZoomLevelRaster
+{
+    int zoom_level = 0;
+    double resolution = 0;
+    std::shared_ptr<WindowedRaster> raster;
+};
+
+typedef std::function<bool(ZoomLevelRaster&)> ZoomLevelGenerator;
+
+struct PartitionJob
+{
+    std::shared_ptr<WindowedRaster> dem;
+    int zoom = 0;
+    double method_parameter = 0;
+    Partition part;
+};
+
+// tracks the tiles of a partition still in flight, for the manifest
+struct PartitionProgress
+{
+    int zoom = 0;
+    Partition part;
+    std::atomic<int> remaining_tiles{0};
+};
+
+struct TileJob
+{
+    std::shared_ptr<PartitionProgress> progress;
+    std::shared_ptr<const TileMaker> tile_maker;
+    int zoom = 0;
+    int tx = 0;
+    int ty = 0;
+};
+
+struct EncodedTile
+{
+    std::shared_ptr<PartitionProgress> progress;
+    int zoom = 0;
+    int tx = 0;
+    int ty = 0;
+    std::shared_ptr<MemoryFile> data; //null if the tile is empty and has to be removed
+};
+
+class TilePipeline
+{
+  public:
+    TilePipeline(ZoomLevelGenerator next_level,
+                 const std::string& output_basedir,
+                 const double method_parameter,
+                 const std::string& meshing_method,
+                 const int terra_block_size,
+                 MeshWriter& mesh_writer,
+                 TileArchiveWriter* archive,
+                 TileManifest* manifest,
+                 const PartitionFilter& filter,
+                 TileAvailability* availability,
+                 const int num_threads,
+                 const size_t queue_capacity,
+                 ThreadPool& block_pool) :
+        m_next_level(std::move(next_level)),
+        m_output_basedir(output_basedir),
+        m_method_parameter(method_parameter),
+        m_meshing_method(meshing_method),
+        m_terra_block_size(terra_block_size),
+        m_mesh_writer(mesh_writer),
+        m_archive(archive),
+        m_manifest(manifest),
+        m_filter(filter),
+        m_availability(availability),
+        m_file_extension(mesh_writer.file_extension()),
+        m_num_threads(num_threads),
+        m_block_pool(block_pool),
+        m_partitions(queue_capacity),
+        m_tiles(queue_capacity),
+        m_encoded_tiles(queue_capacity)
+    {
+    }
+
+    bool run()
+    {
+        std::vector<std::thread> threads;
+        start_stage(threads, 1, [this]() { run_overviews(); }, [this]() { m_partitions.close(); });
+        start_stage(threads,
+                    m_num_threads,
+                    [this]() { run_meshing(); },
+                    [this]() { m_tiles.close(); });
+        start_stage(threads,
+                    m_num_threads,
+                    [this]() { run_encoding(); },
+                    [this]() { m_encoded_tiles.close(); });
+        start_stage(threads, 1, [this]() { run_writing(); }, []() {});
+
+        for(auto& t : threads)
         {
-            for(int ty = part.tmin.y; ty <= part.tmax.y; ty++)
+            t.join();
+        }
+
+        log_queue_stats("overviews -> meshing (partitions)", m_partitions.stats());
+        log_queue_stats("meshing -> encoding (tiles)", m_tiles.stats());
+        log_queue_stats("encoding -> writing (encoded tiles)", m_encoded_tiles.stats());
+        TNTN_LOG_INFO("pipeline wrote {} tiles", m_num_written);
+        if(m_manifest || m_filter)
+        {
+            TNTN_LOG_INFO("skipped {} partitions", m_num_skipped);
+        }
+
+        return !m_failed;
+    }
+
+  private:
+    // starts num_workers threads running work, on_done is called by the last one to finish.
+    // work is restarted after an exception, which then only drains its input queue
+    // so that upstream stages never block on a full queue.
+    void start_stage(std::vector<std::thread>& threads,
+                     const int num_workers,
+                     std::function<void()> work,
+                     std::function<void()> on_done)
+    {
+        auto remaining = std::make_shared<std::atomic<int>>(num_workers);
+        for(int i = 0; i < num_workers; i++)
+        {
+            threads.emplace_back([this, work, on_done, remaining]() {
+                while(true)
+                {
+                    try
+                    {
+                        work();
+                        break;
+                    }
+                    catch(const std::exception& e)
+                    {
+                        TNTN_LOG_ERROR("pipeline stage failed: {}", e.what());
+                        m_failed = true;
+                    }
+                }
+                if(--(*remaining) == 0)
+                {
+                    on_done();
+                }
+            });
+        }
+    }
+
+    void run_overviews()
+    {
+        ZoomLevelRaster level;
+        while(!m_failed && m_next_level(level))
+        {
+            const int zoom_level = level.zoom_level;
+
+            int overview_width = level.raster->get_width();
+            int overview_height = level.raster->get_height();
+
+            if(overview_height < 1 || overview_width < 1)
             {
-                TNTN_LOG_INFO("Creating tile: {},{}", tx, ty);
+                TNTN_LOG_WARN("raster on zoom level {} empty, cannot create tiles, proceeding...",
+                              zoom_level);
+                continue;
+            }
 
-                auto tile_dir =
-                    fs::path(output_basedir) / std::to_string(zoom) / std::to_string(tx);
-                fs::create_directory(tile_dir);
+            TNTN_LOG_INFO("Processing zoom level {}, raster size {}x{}",
+                          zoom_level,
+                          overview_width,
+                          overview_height);
 
-                auto file_path =
-                    tile_dir / (std::to_string(ty) + "." + mesh_writer.file_extension());
+            std::shared_ptr<WindowedRaster> dem = std::move(level.raster);
+            for(const auto& part : create_partitions_for_zoom_level(*dem, zoom_level))
+            {
+                if(m_filter && !m_filter(part, zoom_level, dem->get_cell_size()))
+                {
+                    m_num_skipped++;
+                    continue;
+                }
+                if(m_manifest && m_manifest->is_done(zoom_level, part.tmin, part.tmax))
+                {
+                    add_existing_tiles(zoom_level, part);
+                    m_num_skipped++;
+                    continue;
+                }
 
-                if(!tm.dumpTile(tx, ty, zoom, file_path.c_str(), mesh_writer))
+                PartitionJob job;
+                job.dem = dem;
+                job.zoom = zoom_level;
+                job.method_parameter =
+                    m_method_parameter < 0 ? level.resolution : m_method_parameter;
+                job.part = part;
+                if(!m_partitions.push(std::move(job)))
                 {
-                    TNTN_LOG_ERROR("error dumping tile z:{} x:{} y:{}", zoom, tx, ty);
-                    return false;
+                    return;
                 }
             }
         }
     }
-    return true;
+
+    void run_meshing()
+    {
+        PartitionJob job;
+        while(m_partitions.pop(job))
+        {
+            if(m_failed)
+            {
+                continue;
+            }
+
+            // with a terra block size the blocks of a large partition are meshed on the
+            // shared pool, so threads left idle by a zoom level with few partitions help
+            auto mesh = mesh_partition(*job.dem,
+                                       job.part,
+                                       job.method_parameter,
+                                       m_meshing_method,
+                                       m_terra_block_size,
+                                       m_block_pool);
+            job.dem.reset();
+            if(!mesh)
+            {
+                m_failed = true;
+                continue;
+            }
+
+            auto tm = std::make_shared<TileMaker>();
+            tm->loadMesh(std::move(mesh), m_mesh_writer.wants_vertex_normals());
+
+            auto progress = std::make_shared<PartitionProgress>();
+            progress->zoom = job.zoom;
+            progress->part = job.part;
+            progress->remaining_tiles = (job.part.tmax.x - job.part.tmin.x + 1) *
+                (job.part.tmax.y - job.part.tmin.y + 1);
+
+            for(int tx = job.part.tmin.x; tx <= job.part.tmax.x; tx++)
+            {
+                for(int ty = job.part.tmin.y; ty <= job.part.tmax.y; ty++)
+                {
+                    TileJob tile;
+                    tile.progress = progress;
+                    tile.tile_maker = tm;
+                    tile.zoom = job.zoom;
+                    tile.tx = tx;
+                    tile.ty = ty;
+                    m_tiles.push(std::move(tile));
+                }
+            }
+        }
+    }
+
+    void run_encoding()
+    {
+        TileJob job;
+        while(m_tiles.pop(job))
+        {
+            if(m_failed)
+            {
+                continue;
+            }
+
+            TNTN_LOG_INFO("Creating tile: {},{}", job.tx, job.ty);
+
+            BBox3D bbox;
+            auto tile_mesh = job.tile_maker->makeTile(job.tx, job.ty, job.zoom, bbox);
+            job.tile_maker.reset();
+            if(!tile_mesh)
+            {
+                //ignore empty meshes, unless they replace a tile of a previous run
+                if(m_filter)
+                {
+                    EncodedTile removed;
+                    removed.progress = std::move(job.progress);
+                    removed.zoom = job.zoom;
+                    removed.tx = job.tx;
+                    removed.ty = job.ty;
+                    m_encoded_tiles.push(std::move(removed));
+                    continue;
+                }
+                tile_finished(*job.progress);
+                continue;
+            }
+
+            EncodedTile encoded;
+            encoded.progress = std::move(job.progress);
+            encoded.zoom = job.zoom;
+            encoded.tx = job.tx;
+            encoded.ty = job.ty;
+            encoded.data = std::make_shared<MemoryFile>();
+            if(!m_mesh_writer.write_mesh(encoded.data, *tile_mesh, bbox))
+            {
+                TNTN_LOG_ERROR("error encoding tile z:{} x:{} y:{}", job.zoom, job.tx, job.ty);
+                m_failed = true;
+                continue;
+            }
+            m_encoded_tiles.push(std::move(encoded));
+        }
+    }
+
+    void run_writing()
+    {
+        std::set<fs::path> created_dirs;
+        std::vector<unsigned char> buffer;
+
+        EncodedTile tile;
+        while(m_encoded_tiles.pop(tile))
+        {
+            if(m_failed)
+            {
+                continue;
+            }
+
+            if(!tile.data)
+            {
+                remove_tile(tile.zoom, tile.tx, tile.ty);
+                tile_finished(*tile.progress);
+                continue;
+            }
+
+            if(m_archive)
+            {
+                tile.data->read(0, buffer, tile.data->size());
+                tile.data.reset();
+                if(!m_archive->add_tile(tile.zoom, tile.tx, tile.ty, buffer))
+                {
+                    m_failed = true;
+                    continue;
+                }
+                m_num_written++;
+                record_available(tile.zoom, tile.tx, tile.ty);
+                tile_finished(*tile.progress);
+                continue;
+            }
+
+            const fs::path tile_dir =
+                fs::path(m_output_basedir) / std::to_string(tile.zoom) / std::to_string(tile.tx);
+            if(created_dirs.insert(tile_dir).second)
+            {
+                fs::create_directories(tile_dir);
+            }
+
+            const fs::path file_path = tile_dir / (std::to_string(tile.ty) + "." + m_file_extension);
+            tile.data->read(0, buffer, tile.data->size());
+            tile.data.reset();
+
+            File f;
+            if(!f.open(file_path.string(), File::OM_RWCF) || !f.write(0, buffer))
+            {
+                TNTN_LOG_ERROR("error writing tile z:{} x:{} y:{} to {}",
+                               tile.zoom,
+                               tile.tx,
+                               tile.ty,
+                               file_path.string());
+                m_failed = true;
+                continue;
+            }
+            m_num_written++;
+            record_available(tile.zoom, tile.tx, tile.ty);
+            tile_finished(*tile.progress);
+        }
+    }
+
+    // called by the writing stage and by the overview stage for resumed partitions
+    void record_available(const int zoom, const int tx, const int ty)
+    {
+        if(m_availability)
+        {
+            std::lock_guard<std::mutex> lock(m_availability_mutex);
+            m_availability->add_tile(zoom, tx, ty);
+        }
+    }
+
+    // an update left the tile empty, the file of the previous run must not be served anymore
+    void remove_tile(const int zoom, const int tx, const int ty)
+    {
+        if(!m_archive)
+        {
+            const fs::path file_path = fs::path(m_output_basedir) / std::to_string(zoom) /
+                std::to_string(tx) / (std::to_string(ty) + "." + m_file_extension);
+            boost::system::error_code e;
+            fs::remove(file_path, e);
+            if(e)
+            {
+                TNTN_LOG_ERROR("error removing tile z:{} x:{} y:{} at {}",
+                               zoom,
+                               tx,
+                               ty,
+                               file_path.string());
+                m_failed = true;
+                return;
+            }
+        }
+        if(m_availability)
+        {
+            std::lock_guard<std::mutex> lock(m_availability_mutex);
+            m_availability->remove_tile(zoom, tx, ty);
+        }
+    }
+
+    // a resumed run does not write the tiles of finished partitions again,
+    // their files tell which of them were not empty
+    void add_existing_tiles(const int zoom, const Partition& part)
+    {
+        if(!m_availability || m_archive)
+        {
+            return;
+        }
+        for(int tx = part.tmin.x; tx <= part.tmax.x; tx++)
+        {
+            const fs::path tile_dir =
+                fs::path(m_output_basedir) / std::to_string(zoom) / std::to_string(tx);
+            for(int ty = part.tmin.y; ty <= part.tmax.y; ty++)
+            {
+                boost::system::error_code e;
+                if(fs::exists(tile_dir / (std::to_string(ty) + "." + m_file_extension), e))
+                {
+                    record_available(zoom, tx, ty);
+                }
+            }
+        }
+    }
+
+    // called once per tile after it was written or found empty
+    void tile_finished(PartitionProgress& progress)
+    {
+        if(--progress.remaining_tiles == 0 && m_manifest && !m_failed)
+        {
+            if(!m_manifest->mark_done(progress.zoom, progress.part.tmin, progress.part.tmax))
+            {
+                m_failed = true;
+            }
+        }
+    }
+
+    static void log_queue_stats(const char* name, const BoundedQueueStats& stats)
+    {
+        TNTN_LOG_INFO(
+            "queue {}: {} items, max depth {}/{}, mean depth {:.1f}, "
+            "producers stalled {:.3f}s, consumers stalled {:.3f}s",
+            name,
+            stats.items,
+            stats.max_depth,
+            stats.capacity,
+            stats.mean_depth,
+            stats.push_stall_seconds,
+            stats.pop_stall_seconds);
+    }
+
+    ZoomLevelGenerator m_next_level;
+    const std::string m_output_basedir;
+    const double m_method_parameter;
+    const std::string m_meshing_method;
+    const int m_terra_block_size; //0 meshes partitions with plain terra
+    MeshWriter& m_mesh_writer;
+    TileArchiveWriter* m_archive; //optional, replaces the z/x/y files
+    TileManifest* m_manifest; //optional, records finished partitions
+    const PartitionFilter m_filter; //optional
+    TileAvailability* m_availability; //optional, records the tiles written
+    std::mutex m_availability_mutex;
+    const std::string m_file_extension;
+    const int m_num_threads;
+    ThreadPool& m_block_pool; //runs the blocks of terra_block_size meshing
+
+    BoundedQueue<PartitionJob> m_partitions;
+    BoundedQueue<TileJob> m_tiles;
+    BoundedQueue<EncodedTile> m_encoded_tiles;
+
+    std::atomic<bool> m_failed{false};
+    size_t m_num_written = 0; //only touched by the writing stage
+    size_t m_num_skipped = 0; //only touched by the overview stage
+};
+
+} //namespace
+
+static bool run_tile_pipeline(ZoomLevelGenerator next_level,
+                              const std::string& output_basedir,
+                              const double method_parameter,
+                              const std::string& meshing_method,
+                              MeshWriter& mesh_writer,
+                              const int num_threads,
+                              const size_t queue_capacity,
+                              TileArchiveWriter* archive,
+                              TileManifest* manifest,
+                              const PartitionFilter& filter,
+                              TileAvailability* availability,
+                              const int terra_block_size,
+                              ThreadPool* thread_pool)
+{
+    if(!archive)
+    {
+        fs::create_directories(fs::path(output_basedir));
+    }
+
+    // without a pool the meshing threads run their blocks themselves
+    ThreadPool serial_pool(1);
+    TilePipeline pipeline(std::move(next_level),
+                          output_basedir,
+                          method_parameter,
+                          meshing_method,
+                          terra_block_size,
+                          mesh_writer,
+                          archive,
+                          manifest,
+                          filter,
+                          availability,
+                          std::max(num_threads, 1),
+                          queue_capacity,
+                          thread_pool ? *thread_pool : serial_pool);
+    return pipeline.run();
+}
+
+// hands out the overviews one zoom level at a time
+template<typename T>
+static ZoomLevelGenerator overview_levels(BasicRasterOverviews<T>& overviews)
+{
+    return [&overviews](ZoomLevelRaster& level) {
+        BasicRasterOverview<T> overview;
+        if(!overviews.next(overview))
+        {
+            return false;
+        }
+        level.zoom_level = overview.zoom_level;
+        level.resolution = overview.resolution;
+        level.raster = std::make_shared<BasicMemoryWindowedRaster<T>>(
+            std::shared_ptr<const Raster<T>>(std::move(overview.raster)));
+        return true;
+    };
+}
+
+bool create_tiles_pipelined(RasterOverviews& overviews,
+                            const std::string& output_basedir,
+                            const double method_parameter,
+                            const std::string& meshing_method,
+                            MeshWriter& mesh_writer,
+                            const int num_threads,
+                            const size_t queue_capacity,
+                            TileArchiveWriter* archive,
+                            TileManifest* manifest,
+                            const PartitionFilter& filter,
+                            TileAvailability* availability,
+                            const int terra_block_size,
+                            ThreadPool* thread_pool)
+{
+    return run_tile_pipeline(overview_levels(overviews),
+                             output_basedir,
+                             method_parameter,
+                             meshing_method,
+                             mesh_writer,
+                             num_threads,
+                             queue_capacity,
+                             archive,
+                             manifest,
+                             filter,
+                             availability,
+                             terra_block_size,
+                             thread_pool);
+}
+
+bool create_tiles_pipelined(RasterOverviewsFloat& overviews,
+                            const std::string& output_basedir,
+                            const double method_parameter,
+                            const std::string& meshing_method,
+                            MeshWriter& mesh_writer,
+                            const int num_threads,
+                            const size_t queue_capacity,
+                            TileArchiveWriter* archive,
+                            TileManifest* manifest,
+                            const PartitionFilter& filter,
+                            TileAvailability* availability,
+                            const int terra_block_size,
+                            ThreadPool* thread_pool)
+{
+    return run_tile_pipeline(overview_levels(overviews),
+                             output_basedir,
+                             method_parameter,
+                             meshing_method,
+                             mesh_writer,
+                             num_threads,
+                             queue_capacity,
+                             archive,
+                             manifest,
+                             filter,
+                             availability,
+                             terra_block_size,
+                             thread_pool);
+}
+
+bool create_tiles_pipelined(std::shared_ptr<WindowedRaster> dem,
+                            int min_zoom,
+                            int max_zoom,
+                            const std::string& output_basedir,
+                            const double method_parameter,
+                            const std::string& meshing_method,
+                            MeshWriter& mesh_writer,
+                            const int num_threads,
+                            const size_t queue_capacity,
+                            TileArchiveWriter* archive,
+                            TileManifest* manifest,
+                            const PartitionFilter& filter,
+                            TileAvailability* availability,
+                            const int terra_block_size,
+                            ThreadPool* thread_pool)
+{
+    int native_zoom = 0;
+    RasterOverviews::compute_zoom_range(dem->get_width(),
+                                        dem->get_height(),
+                                        dem->get_cell_size(),
+                                        min_zoom,
+                                        max_zoom,
+                                        native_zoom);
+
+    // same levels as RasterOverviews in direct mode, but each window is only
+    // read and downsampled when a partition needs it
+    int current_zoom = max_zoom;
+    auto next_level = [=, &current_zoom](ZoomLevelRaster& level) {
+        if(current_zoom < min_zoom)
+        {
+            return false;
+        }
+        const int window_size = 1 << (native_zoom - current_zoom);
+        level.zoom_level = current_zoom--;
+        level.raster = window_size == 1
+            ? dem
+            : std::make_shared<DownsampledWindowedRaster>(dem, window_size);
+        level.resolution = level.raster->get_cell_size();
+        return true;
+    };
+
+    return run_tile_pipeline(next_level,
+                             output_basedir,
+                             method_parameter,
+                             meshing_method,
+                             mesh_writer,
+                             num_threads,
+                             queue_capacity,
+                             archive,
+                             manifest,
+                             filter,
+                             availability,
+                             terra_block_size,
+                             thread_pool);
 }
 
 } //namespace tntn
@@ -0,0 +1,99 @@
+#include "tntn/gzip.h"
+#include "tntn/logging.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <zlib.h>
+
+namespace tntn {
+
+// adding 16 to the window bits selects the gzip wrapper instead of zlib's own
+static constexpr int gzip_window_bits = 15 + 16;
+
+bool gzip_compress(const unsigned char* data,
+                   const size_t size,
+                   std::vector<unsigned char>& out,
+                   const int level)
+{
+    out.clear();
+    if(size > std::numeric_limits<uInt>::max())
+    {
+        TNTN_LOG_ERROR("buffer of {} bytes too large to compress", size);
+        return false;
+    }
+
+    z_stream stream = {};
+    if(deflateInit2(&stream, level, Z_DEFLATED, gzip_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        TNTN_LOG_ERROR("unable to initialize gzip compression: {}", stream.msg ? stream.msg : "");
+        return false;
+    }
+
+    // the bound covers the gzip header and trailer, a single deflate call suffices
+    out.resize(deflateBound(&stream, size));
+    stream.next_in = const_cast<unsigned char*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+    stream.next_out = out.data();
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    const int rc = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if(rc != Z_STREAM_END)
+    {
+        TNTN_LOG_ERROR("gzip compression failed with code {}", rc);
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool gzip_decompress(const unsigned char* data, const size_t size, std::vector<unsigned char>& out)
+{
+    out.clear();
+    if(size > std::numeric_limits<uInt>::max())
+    {
+        TNTN_LOG_ERROR("buffer of {} bytes too large to decompress", size);
+        return false;
+    }
+
+    z_stream stream = {};
+    if(inflateInit2(&stream, gzip_window_bits) != Z_OK)
+    {
+        TNTN_LOG_ERROR("unable to initialize gzip decompression: {}",
+                       stream.msg ? stream.msg : "");
+        return false;
+    }
+
+    stream.next_in = const_cast<unsigned char*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+
+    int rc = Z_OK;
+    while(rc == Z_OK)
+    {
+        const size_t produced = out.size();
+        out.resize(produced + std::max<size_t>(size * 2, 4096));
+        stream.next_out = out.data() + produced;
+        stream.avail_out = static_cast<uInt>(out.size() - produced);
+        rc = inflate(&stream, Z_NO_FLUSH);
+        out.resize(out.size() - stream.avail_out);
+    }
+    inflateEnd(&stream);
+
+    if(rc != Z_STREAM_END)
+    {
+        TNTN_LOG_ERROR("gzip decompression failed with code {}", rc);
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool is_gzip(const unsigned char* data, const size_t size)
+{
+    return size >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+} //namespace tntn
@@ -0,0 +1,329 @@
+#include "tntn/mesh_optimization.h"
+#include "tntn/logging.h"
+#include "tntn/tntn_assert.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace tntn {
+
+double average_cache_miss_ratio(const std::vector<Face>& faces,
+                                const size_t num_vertices,
+                                const size_t cache_size)
+{
+    if(faces.empty())
+    {
+        return 0;
+    }
+
+    // a vertex is in the FIFO if fewer than cache_size misses happened since it was loaded
+    std::vector<size_t> loaded_at(num_vertices, 0);
+    std::vector<bool> seen(num_vertices, false);
+    size_t misses = 0;
+
+    for(const Face& f : faces)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            const size_t v = f[k];
+            TNTN_ASSERT(v < num_vertices);
+            if(!seen[v] || misses - loaded_at[v] >= cache_size)
+            {
+                seen[v] = true;
+                loaded_at[v] = misses;
+                misses++;
+            }
+        }
+    }
+    return static_cast<double>(misses) / faces.size();
+}
+
+namespace {
+
+// parameters as given in the article
+constexpr int forsyth_cache_size = 32;
+constexpr double cache_decay_power = 1.5;
+constexpr double last_triangle_score = 0.75;
+constexpr double valence_boost_scale = 2.0;
+constexpr double valence_boost_power = 0.5;
+
+constexpr int max_precomputed_valence = 32;
+
+class VertexScores
+{
+  public:
+    VertexScores()
+    {
+        for(int i = 0; i < forsyth_cache_size; i++)
+        {
+            if(i < 3)
+            {
+                // the vertices of the last triangle get a fixed score so that
+                // strips are not favoured too much over fans
+                m_cache_score[i] = last_triangle_score;
+            }
+            else
+            {
+                const double scaler = 1.0 / (forsyth_cache_size - 3);
+                m_cache_score[i] = std::pow(1.0 - (i - 3) * scaler, cache_decay_power);
+            }
+        }
+        m_valence_score[0] = 0;
+        for(int i = 1; i <= max_precomputed_valence; i++)
+        {
+            m_valence_score[i] = valence_boost_scale * std::pow(i, -valence_boost_power);
+        }
+    }
+
+    double score(const int cache_position, const int remaining_faces) const
+    {
+        if(remaining_faces == 0)
+        {
+            return -1.0;
+        }
+        double s = cache_position >= 0 ? m_cache_score[cache_position] : 0.0;
+        s += remaining_faces <= max_precomputed_valence
+            ? m_valence_score[remaining_faces]
+            : valence_boost_scale * std::pow(remaining_faces, -valence_boost_power);
+        return s;
+    }
+
+  private:
+    double m_cache_score[forsyth_cache_size];
+    double m_valence_score[max_precomputed_valence + 1];
+};
+
+} //namespace
+
+void optimize_vertex_cache(std::vector<Face>& faces, const size_t num_vertices)
+{
+    const size_t num_faces = faces.size();
+    if(num_faces < 2)
+    {
+        return;
+    }
+
+    static const VertexScores scores;
+
+    // faces adjacent to each vertex, the first remaining[v] entries are not yet emitted
+    std::vector<uint32_t> remaining(num_vertices, 0);
+    for(const Face& f : faces)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            TNTN_ASSERT(f[k] < num_vertices);
+            remaining[f[k]]++;
+        }
+    }
+
+    std::vector<size_t> adjacency_start(num_vertices + 1, 0);
+    for(size_t v = 0; v < num_vertices; v++)
+    {
+        adjacency_start[v + 1] = adjacency_start[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(adjacency_start[num_vertices]);
+    {
+        std::vector<size_t> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+        for(size_t i = 0; i < num_faces; i++)
+        {
+            for(int k = 0; k < 3; k++)
+            {
+                adjacency[fill[faces[i][k]]++] = i;
+            }
+        }
+    }
+
+    std::vector<int> cache_position(num_vertices, -1);
+    std::vector<double> vertex_score(num_vertices);
+    for(size_t v = 0; v < num_vertices; v++)
+    {
+        vertex_score[v] = scores.score(-1, remaining[v]);
+    }
+
+    std::vector<double> face_score(num_faces);
+    std::vector<bool> emitted(num_faces, false);
+    for(size_t i = 0; i < num_faces; i++)
+    {
+        const Face& f = faces[i];
+        face_score[i] = vertex_score[f[0]] + vertex_score[f[1]] + vertex_score[f[2]];
+    }
+
+    std::vector<Face> out;
+    out.reserve(num_faces);
+
+    std::vector<size_t> cache;
+    std::vector<size_t> new_cache;
+    cache.reserve(forsyth_cache_size + 3);
+    new_cache.reserve(forsyth_cache_size + 3);
+
+    // where to look for the next face when no face touches the cache
+    size_t next_unemitted = 0;
+    int64_t best_face = -1;
+
+    while(out.size() < num_faces)
+    {
+        if(best_face < 0)
+        {
+            while(emitted[next_unemitted])
+            {
+                next_unemitted++;
+            }
+            best_face = next_unemitted;
+        }
+
+        const Face& face = faces[best_face];
+        out.push_back(face);
+        emitted[best_face] = true;
+
+        for(int k = 0; k < 3; k++)
+        {
+            const size_t v = face[k];
+            uint32_t* adj = adjacency.data() + adjacency_start[v];
+            for(uint32_t j = 0; j < remaining[v]; j++)
+            {
+                if(adj[j] == best_face)
+                {
+                    std::swap(adj[j], adj[remaining[v] - 1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+
+        // the face's vertices move to the front of the LRU cache
+        new_cache.clear();
+        new_cache.push_back(face[0]);
+        new_cache.push_back(face[1]);
+        new_cache.push_back(face[2]);
+        for(const size_t v : cache)
+        {
+            if(v != face[0] && v != face[1] && v != face[2])
+            {
+                new_cache.push_back(v);
+            }
+        }
+
+        best_face = -1;
+        double best_score = -std::numeric_limits<double>::infinity();
+        for(size_t i = 0; i < new_cache.size(); i++)
+        {
+            const size_t v = new_cache[i];
+            cache_position[v] = i < forsyth_cache_size ? static_cast<int>(i) : -1;
+
+            const double score = scores.score(cache_position[v], remaining[v]);
+            const double delta = score - vertex_score[v];
+            vertex_score[v] = score;
+
+            const uint32_t* adj = adjacency.data() + adjacency_start[v];
+            for(uint32_t j = 0; j < remaining[v]; j++)
+            {
+                face_score[adj[j]] += delta;
+            }
+        }
+
+        // the best candidate is among the faces of cached vertices
+        for(size_t i = 0; i < new_cache.size() && i < forsyth_cache_size; i++)
+        {
+            const size_t v = new_cache[i];
+            const uint32_t* adj = adjacency.data() + adjacency_start[v];
+            for(uint32_t j = 0; j < remaining[v]; j++)
+            {
+                if(face_score[adj[j]] > best_score)
+                {
+                    best_score = face_score[adj[j]];
+                    best_face = adj[j];
+                }
+            }
+        }
+
+        if(new_cache.size() > forsyth_cache_size)
+        {
+            new_cache.resize(forsyth_cache_size);
+        }
+        cache.swap(new_cache);
+    }
+
+    faces.swap(out);
+}
+
+void reorder_vertices_by_first_use(std::vector<Vertex>& vertices,
+                                   std::vector<Face>& faces,
+                                   std::vector<Normal>* normals)
+{
+    static constexpr VertexIndex unused = std::numeric_limits<VertexIndex>::max();
+
+    TNTN_ASSERT(normals == nullptr || normals->size() == vertices.size());
+
+    std::vector<VertexIndex> remap(vertices.size(), unused);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    std::vector<Normal> reordered_normals;
+    if(normals)
+    {
+        reordered_normals.reserve(normals->size());
+    }
+
+    for(Face& f : faces)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            TNTN_ASSERT(f[k] < vertices.size());
+            if(remap[f[k]] == unused)
+            {
+                remap[f[k]] = reordered.size();
+                reordered.push_back(vertices[f[k]]);
+                if(normals)
+                {
+                    reordered_normals.push_back((*normals)[f[k]]);
+                }
+            }
+            f[k] = remap[f[k]];
+        }
+    }
+
+    vertices.swap(reordered);
+    if(normals)
+    {
+        normals->swap(reordered_normals);
+    }
+}
+
+void optimize_mesh_for_vertex_cache(Mesh& mesh)
+{
+    if(mesh.empty())
+    {
+        return;
+    }
+
+    mesh.generate_decomposed();
+
+    std::vector<Normal> normals;
+    if(mesh.has_normals())
+    {
+        mesh.grab_normals(normals);
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    mesh.grab_decomposed(vertices, faces);
+    mesh.clear_triangles();
+
+    const double acmr_before = average_cache_miss_ratio(faces, vertices.size());
+    optimize_vertex_cache(faces, vertices.size());
+    reorder_vertices_by_first_use(vertices, faces, normals.empty() ? nullptr : &normals);
+    const double acmr_after = average_cache_miss_ratio(faces, vertices.size());
+
+    TNTN_LOG_DEBUG("vertex cache optimization of {} faces: ACMR {:.3f} -> {:.3f}",
+                   faces.size(),
+                   acmr_before,
+                   acmr_after);
+
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+    if(!normals.empty())
+    {
+        mesh.set_normals(std::move(normals));
+    }
+}
+
+} // namespace tntn
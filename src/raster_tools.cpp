@@ -1,4 +1,5 @@
 #include "tntn/raster_tools.h"
+#include "tntn/tntn_assert.h"
 #include <vector>
 #include <algorithm>
 
@@ -12,7 +13,8 @@ namespace tntn {
      @param window_size - factor to downsample by (will truncate output size to nearest integer)
      @return downsampled raster image
     */
-RasterDouble raster_tools::integer_downsample_mean(const RasterDouble& src, int win)
+template<typename T>
+Raster<T> raster_tools::integer_downsample_mean(const Raster<T>& src, int win)
 {
     int w = src.get_width();
     int h = src.get_height();
@@ -22,7 +24,7 @@ RasterDouble raster_tools::integer_downsample_mean(const RasterDouble& src, int
 
     double ndv = src.get_no_data_value();
 
-    RasterDouble dst(ws, hs);
+    Raster<T> dst(ws, hs);
 
     dst.copy_parameters(src);
     dst.set_cell_size(src.get_cell_size() * win);
@@ -52,13 +54,105 @@ RasterDouble raster_tools::integer_downsample_mean(const RasterDouble& src, int
             if(count == 0)
                 dst.value(rs, cs) = ndv;
             else if(sum > 0)
-                dst.value(rs, cs) = sum / (double)(count);
+                dst.value(rs, cs) = static_cast<T>(sum / (double)(count));
         }
     }
 
     return dst;
 }
 
+/** downsample image by a factor of 2
+     takes the weighted mean of the valid pixels in each 2 by 2 block, ignoring no data pixels.
+     weights holds the number of valid base pixels each pixel of src was averaged from
+     and is replaced by the weights of the result, so repeated calls produce the mean of all
+     valid base pixels in a 2^k by 2^k window (like integer_downsample_mean, but from the
+     previous level instead of the base raster).
+     @param src - source raster image
+     @param weights - per pixel weights of src, an empty raster means 1 for every valid pixel
+     @param thread_pool - optional, rows of the result are then computed in parallel bands
+     @return downsampled raster image
+    */
+template<typename T>
+Raster<T> raster_tools::downsample_mean_2x2(const Raster<T>& src,
+                                            Raster<uint32_t>& weights,
+                                            ThreadPool* thread_pool)
+{
+    const int ws = src.get_width() / 2;
+    const int hs = src.get_height() / 2;
+
+    const double ndv = src.get_no_data_value();
+    const bool has_weights = !weights.empty();
+
+    TNTN_ASSERT(!has_weights
+                || (weights.get_width() == src.get_width()
+                    && weights.get_height() == src.get_height()));
+
+    Raster<T> dst(ws, hs);
+    dst.copy_parameters(src);
+    dst.set_cell_size(src.get_cell_size() * 2);
+
+    Raster<uint32_t> dst_weights(ws, hs);
+
+    auto reduce_rows = [&](int row_begin, int row_end) {
+        for(int rs = row_begin; rs < row_end; rs++)
+        {
+            const T* src_rows[2] = {src.get_ptr(2 * rs), src.get_ptr(2 * rs + 1)};
+            const uint32_t* weight_rows[2] = {nullptr, nullptr};
+            if(has_weights)
+            {
+                weight_rows[0] = weights.get_ptr(2 * rs);
+                weight_rows[1] = weights.get_ptr(2 * rs + 1);
+            }
+
+            T* dst_row = dst.get_ptr(rs);
+            uint32_t* dst_weight_row = dst_weights.get_ptr(rs);
+
+            for(int cs = 0; cs < ws; cs++)
+            {
+                double sum = 0;
+                uint32_t count = 0;
+
+                for(int i = 0; i < 2; i++)
+                {
+                    for(int j = 0; j < 2; j++)
+                    {
+                        const double sv = src_rows[i][2 * cs + j];
+                        if(sv != ndv)
+                        {
+                            const uint32_t w = has_weights ? weight_rows[i][2 * cs + j] : 1;
+                            sum += sv * w;
+                            count += w;
+                        }
+                    }
+                }
+
+                dst_row[cs] = static_cast<T>(count == 0 ? ndv : sum / count);
+                dst_weight_row[cs] = count;
+            }
+        }
+    };
+
+    // bands of rows keep per task overhead low and memory access sequential
+    const int rows_per_band = 64;
+    const int num_bands = (hs + rows_per_band - 1) / rows_per_band;
+
+    if(thread_pool)
+    {
+        thread_pool->parallel_for(num_bands, [&](size_t band) {
+            const int row_begin = static_cast<int>(band) * rows_per_band;
+            reduce_rows(row_begin, std::min(row_begin + rows_per_band, hs));
+            return true;
+        });
+    }
+    else
+    {
+        reduce_rows(0, hs);
+    }
+
+    weights = std::move(dst_weights);
+    return dst;
+}
+
 RasterDouble raster_tools::convolution_filter(const RasterDouble& src,
                                               std::vector<double> kernel,
                                               int size)
@@ -159,20 +253,22 @@ RasterDouble raster_tools::max_filter(const RasterDouble& src,
     return dst;
 }
 
-void raster_tools::flip_data_x(RasterDouble& raster)
+template<typename T>
+void raster_tools::flip_data_x(Raster<T>& raster)
 {
     const int height = raster.get_height();
     const int width = raster.get_width();
 
     for(int row = 0; row < height; row++)
     {
-        double* begin = raster.get_ptr(row);
-        double* end = begin + width;
+        T* begin = raster.get_ptr(row);
+        T* end = begin + width;
         std::reverse(begin, end);
     }
 }
 
-void raster_tools::flip_data_y(RasterDouble& raster)
+template<typename T>
+void raster_tools::flip_data_y(Raster<T>& raster)
 {
     int row = 0;
     const int height = raster.get_height();
@@ -181,16 +277,17 @@ void raster_tools::flip_data_y(RasterDouble& raster)
 
     while(row < half_height)
     {
-        double* a_begin = raster.get_ptr(row);
-        double* a_end = a_begin + width;
-        double* b_begin = raster.get_ptr_ll(row);
+        T* a_begin = raster.get_ptr(row);
+        T* a_end = a_begin + width;
+        T* b_begin = raster.get_ptr_ll(row);
 
         std::swap_ranges(a_begin, a_end, b_begin);
         row++;
     }
 }
 
-void raster_tools::find_minmax(const RasterDouble& raster, double& min_val, double& max_val)
+template<typename T>
+void raster_tools::find_minmax(const Raster<T>& raster, double& min_val, double& max_val)
 {
     if(raster.empty())
     {
@@ -210,8 +307,8 @@ void raster_tools::find_minmax(const RasterDouble& raster, double& min_val, doub
             continue;
         }
 
-        min = std::min(*pixel, min);
-        max = std::max(*pixel, max);
+        min = std::min<double>(*pixel, min);
+        max = std::max<double>(*pixel, max);
     }
 
     min_val = min;
@@ -223,7 +320,8 @@ void raster_tools::find_minmax(const RasterDouble& raster, double& min_val, doub
        
      @return 3d bounding box
 	*/
-BBox3D raster_tools::get_bounding_box3d(const RasterDouble& raster)
+template<typename T>
+BBox3D raster_tools::get_bounding_box3d(const Raster<T>& raster)
 {
     double min_height = 0.0;
     double max_height = 0.0;
@@ -265,13 +363,15 @@ static inline double average_nan_arr(const std::array<double, Size>& to_average)
     return sum / avg_count;
 }
 
+template<typename T>
 static inline double safe_get_pixel(
-    const RasterDouble& src, const int64_t w, const int64_t h, const int64_t r, const int64_t c)
+    const Raster<T>& src, const int64_t w, const int64_t h, const int64_t r, const int64_t c)
 {
     return r >= 0 && r < h && c >= 0 && c < w ? src.value(r, c) : NAN;
 }
 
-static double subsample_raster_3x3(const RasterDouble& src,
+template<typename T>
+static double subsample_raster_3x3(const Raster<T>& src,
                                    const double no_data_value,
                                    const int64_t w,
                                    const int64_t h,
@@ -340,7 +440,8 @@ static inline double average(const std::array<double, MAX_AVERAGING_SAMPLES>& to
     return avg;
 }
 
-double raster_tools::sample_nearest_valid_avg(const RasterDouble& src,
+template<typename T>
+double raster_tools::sample_nearest_valid_avg(const Raster<T>& src,
                                               const unsigned int _row,
                                               const unsigned int _column,
                                               int min_averaging_samples)
@@ -426,4 +527,30 @@ double raster_tools::sample_nearest_valid_avg(const RasterDouble& src,
     return average(to_average, avg_count);
 }
 
+template Raster<double> raster_tools::integer_downsample_mean(const Raster<double>&, int);
+template Raster<double> raster_tools::downsample_mean_2x2(const Raster<double>&,
+                                                          Raster<uint32_t>&,
+                                                          ThreadPool*);
+template void raster_tools::flip_data_x(Raster<double>&);
+template void raster_tools::flip_data_y(Raster<double>&);
+template void raster_tools::find_minmax(const Raster<double>&, double&, double&);
+template BBox3D raster_tools::get_bounding_box3d(const Raster<double>&);
+template double raster_tools::sample_nearest_valid_avg(const Raster<double>&,
+                                                       const unsigned int,
+                                                       const unsigned int,
+                                                       int);
+
+template Raster<float> raster_tools::integer_downsample_mean(const Raster<float>&, int);
+template Raster<float> raster_tools::downsample_mean_2x2(const Raster<float>&,
+                                                         Raster<uint32_t>&,
+                                                         ThreadPool*);
+template void raster_tools::flip_data_x(Raster<float>&);
+template void raster_tools::flip_data_y(Raster<float>&);
+template void raster_tools::find_minmax(const Raster<float>&, double&, double&);
+template BBox3D raster_tools::get_bounding_box3d(const Raster<float>&);
+template double raster_tools::sample_nearest_valid_avg(const Raster<float>&,
+                                                       const unsigned int,
+                                                       const unsigned int,
+                                                       int);
+
 } // namespace tntn
@@ -2,25 +2,271 @@
 #include "tntn/MeshIO.h"
 #include "tntn/TerraMesh.h"
 #include "tntn/tntn_assert.h"
+#include "tntn/logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace tntn {
 
+namespace {
+
+// first pixel of each block along a side of size pixels, the last entry is the last pixel.
+// neighbouring blocks share the pixels of the border between them.
+std::vector<int> block_borders(const int size, const int block_size)
+{
+    const int count = std::max(1, (size - 1 + block_size - 2) / (block_size - 1));
+    std::vector<int> borders(count + 1);
+    for(int i = 0; i <= count; i++)
+    {
+        borders[i] = static_cast<int>(static_cast<int64_t>(size - 1) * i / count);
+    }
+    return borders;
+}
+
+// Douglas-Peucker along one block border from first to last, sample(i) gives the sample at i.
+// adds the positions in between that are needed to stay below max_error in ascending order.
+template<typename Sample>
+void simplify_border(const Sample& sample,
+                     const int first,
+                     const int last,
+                     const double max_error,
+                     const double no_data_value,
+                     std::vector<int>& points)
+{
+    const size_t begin = points.size();
+    std::vector<std::pair<int, int>> spans = {{first, last}};
+    while(!spans.empty())
+    {
+        const int a = spans.back().first;
+        const int b = spans.back().second;
+        spans.pop_back();
+
+        const double za = sample(a);
+        const double zb = sample(b);
+        double worst_error = -1;
+        int worst = -1;
+        for(int i = a + 1; i < b; i++)
+        {
+            const double z = sample(i);
+            if(terra::is_no_data(z, no_data_value))
+            {
+                continue;
+            }
+            const double error = std::abs(z - (za + (zb - za) * (i - a) / (b - a)));
+            if(error > worst_error)
+            {
+                worst_error = error;
+                worst = i;
+            }
+        }
+
+        // same threshold as for the candidates of terra
+        if(worst_error >= max_error)
+        {
+            points.push_back(worst);
+            spans.emplace_back(a, worst);
+            spans.emplace_back(worst, b);
+        }
+    }
+    std::sort(points.begin() + begin, points.end());
+}
+
+template<typename T>
+std::unique_ptr<Mesh> generate_tin_terra_blocks(std::unique_ptr<Raster<T>> raster,
+                                                const double max_error,
+                                                ThreadPool& thread_pool,
+                                                const int block_size)
+{
+    TNTN_ASSERT(raster != nullptr);
+    TNTN_ASSERT(block_size >= 2);
+    const int w = raster->get_width();
+    const int h = raster->get_height();
+    const std::vector<int> xs = block_borders(w, block_size);
+    const std::vector<int> ys = block_borders(h, block_size);
+    const int nx = static_cast<int>(xs.size()) - 1;
+    const int ny = static_cast<int>(ys.size()) - 1;
+
+    if(nx * ny == 1 || w < 2 || h < 2)
+    {
+        terra::TerraMesh<T> g;
+        g.load_raster(std::move(raster));
+        g.greedy_insert(max_error);
+        return g.convert_to_mesh();
+    }
+
+    TNTN_LOG_INFO("meshing {}x{} blocks of at most {} pixels", nx, ny, block_size);
+
+    // The block corners are vertices of all blocks around them
+    for(const int y : ys)
+    {
+        for(const int x : xs)
+        {
+            terra::repair_point(*raster, x, y);
+        }
+    }
+
+    // Pick the points on the borders between the block corners, per line and block
+    const double no_data_value = raster->get_no_data_value();
+    std::vector<std::vector<int>> column_points((nx + 1) * ny);
+    std::vector<std::vector<int>> row_points((ny + 1) * nx);
+    for(int i = 0; i <= nx; i++)
+    {
+        const int x = xs[i];
+        for(int j = 0; j < ny; j++)
+        {
+            auto sample = [&](int y) { return raster->value(y, x); };
+            simplify_border(
+                sample, ys[j], ys[j + 1], max_error, no_data_value, column_points[i * ny + j]);
+        }
+    }
+    for(int j = 0; j <= ny; j++)
+    {
+        const T* row = raster->get_ptr(ys[j]);
+        for(int i = 0; i < nx; i++)
+        {
+            auto sample = [&](int x) { return row[x]; };
+            simplify_border(
+                sample, xs[i], xs[i + 1], max_error, no_data_value, row_points[j * nx + i]);
+        }
+    }
+
+    // Mesh the blocks, with vertices in raster columns and rows
+    struct BlockMesh
+    {
+        std::vector<Vertex> vertices;
+        std::vector<Face> faces;
+    };
+    std::vector<BlockMesh> blocks(nx * ny);
+    thread_pool.parallel_for(blocks.size(), [&](size_t b) {
+        const int i = b % nx;
+        const int j = b / nx;
+        const int x0 = xs[i];
+        const int y0 = ys[j];
+        const int bw = xs[i + 1] - x0 + 1;
+        const int bh = ys[j + 1] - y0 + 1;
+
+        std::vector<glm::ivec2> border_points;
+        for(const int y : column_points[i * ny + j])
+        {
+            border_points.emplace_back(0, y - y0);
+        }
+        for(const int y : column_points[(i + 1) * ny + j])
+        {
+            border_points.emplace_back(bw - 1, y - y0);
+        }
+        for(const int x : row_points[j * nx + i])
+        {
+            border_points.emplace_back(x - x0, 0);
+        }
+        for(const int x : row_points[(j + 1) * nx + i])
+        {
+            border_points.emplace_back(x - x0, bh - 1);
+        }
+
+        auto block_raster = std::make_unique<Raster<T>>();
+        raster->crop(x0, y0, bw, bh, *block_raster);
+
+        terra::TerraMesh<T> g;
+        g.load_raster(std::move(block_raster));
+        g.greedy_insert(max_error, border_points);
+        g.decompose(blocks[b].vertices, blocks[b].faces);
+        return true;
+    });
+
+    // Merge the blocks, vertices on block borders are shared with the neighbouring blocks
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    std::unordered_map<int64_t, VertexIndex> border_vertices;
+    std::vector<VertexIndex> block_index;
+    for(size_t b = 0; b < blocks.size(); b++)
+    {
+        const int i = b % nx;
+        const int j = b / nx;
+        BlockMesh& block = blocks[b];
+
+        block_index.resize(block.vertices.size());
+        for(size_t k = 0; k < block.vertices.size(); k++)
+        {
+            const Vertex& v = block.vertices[k];
+            const int x = xs[i] + static_cast<int>(v.x);
+            const int y = ys[j] + static_cast<int>(v.y);
+            const bool on_border = x == xs[i] || x == xs[i + 1] || y == ys[j] || y == ys[j + 1];
+            if(on_border)
+            {
+                const auto inserted =
+                    border_vertices.emplace(static_cast<int64_t>(y) * w + x, vertices.size());
+                block_index[k] = inserted.first->second;
+                if(!inserted.second)
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                block_index[k] = vertices.size();
+            }
+            vertices.push_back(Vertex(raster->col2x(x), raster->row2y(y), v.z));
+        }
+
+        for(const Face& f : block.faces)
+        {
+            faces.push_back({{block_index[f[0]], block_index[f[1]], block_index[f[2]]}});
+        }
+        block = BlockMesh();
+    }
+
+    auto mesh = std::make_unique<Mesh>();
+    mesh->from_decomposed(std::move(vertices), std::move(faces));
+    return mesh;
+}
+
+} //namespace
+
 std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterDouble> raster, double max_error)
 {
     TNTN_ASSERT(raster != nullptr);
-    terra::TerraMesh g;
+    terra::TerraMesh<double> g;
+    g.load_raster(std::move(raster));
+    g.greedy_insert(max_error);
+    return g.convert_to_mesh();
+}
+
+std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterFloat> raster, double max_error)
+{
+    TNTN_ASSERT(raster != nullptr);
+    terra::TerraMesh<float> g;
     g.load_raster(std::move(raster));
     g.greedy_insert(max_error);
     return g.convert_to_mesh();
 }
 
+std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterDouble> raster,
+                                         double max_error,
+                                         ThreadPool& thread_pool,
+                                         int block_size)
+{
+    return generate_tin_terra_blocks(std::move(raster), max_error, thread_pool, block_size);
+}
+
+std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<RasterFloat> raster,
+                                         double max_error,
+                                         ThreadPool& thread_pool,
+                                         int block_size)
+{
+    return generate_tin_terra_blocks(std::move(raster), max_error, thread_pool, block_size);
+}
+
 std::unique_ptr<Mesh> generate_tin_terra(std::unique_ptr<SurfacePoints> surface_points,
                                          double max_error)
 {
     auto raster = surface_points->to_raster();
     surface_points.reset();
 
-    terra::TerraMesh g;
+    terra::TerraMesh<double> g;
     g.load_raster(std::move(raster));
     g.greedy_insert(max_error);
     return g.convert_to_mesh();
@@ -30,7 +276,7 @@ std::unique_ptr<Mesh> generate_tin_terra(const SurfacePoints& surface_points, do
 {
     auto raster = surface_points.to_raster();
 
-    terra::TerraMesh g;
+    terra::TerraMesh<double> g;
     g.load_raster(std::move(raster));
     g.greedy_insert(max_error);
     return g.convert_to_mesh();
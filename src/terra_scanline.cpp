@@ -0,0 +1,274 @@
+#include "tntn/terra_scanline.h"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#define TNTN_SCANLINE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// The vector kernels compute the error of each point with the same IEEE operations as the
+// single point path. A block of points is only looked at point by point, in column order,
+// when one of its errors beats the best so far. Candidates are thus chosen exactly as a
+// plain loop with a strict greater-than would choose them.
+
+namespace tntn {
+namespace terra {
+
+namespace {
+
+// flags of the n <= 8 columns from x on in the low bits
+inline unsigned int used_bits(const uint64_t* used, const int x, const int n) noexcept
+{
+    const int shift = x % 64;
+    uint64_t bits = used[x / 64] >> shift;
+    if(shift + n > 64)
+    {
+        bits |= used[x / 64 + 1] << (64 - shift);
+    }
+    return static_cast<unsigned int>(bits) & ((1u << n) - 1);
+}
+
+#if defined(__AVX2__)
+inline __m256d load4(const double* p) noexcept
+{
+    return _mm256_loadu_pd(p);
+}
+
+inline __m256d load4(const float* p) noexcept
+{
+    return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+#endif
+
+#if defined(TNTN_SCANLINE_SSE2)
+inline __m128d load2(const double* p) noexcept
+{
+    return _mm_loadu_pd(p);
+}
+
+inline __m128d load2(const float* p) noexcept
+{
+    return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+#endif
+
+struct RowMax
+{
+    double error = -1;
+    int x = -1;
+
+    void consider(const double* errors, const int x0, const int count) noexcept
+    {
+        for(int i = 0; i < count; i++)
+        {
+            // nan marks points that are used or have no data
+            if(errors[i] > error)
+            {
+                error = errors[i];
+                x = x0 + i;
+            }
+        }
+    }
+};
+
+#if defined(TNTN_SCANLINE_SSE2)
+template<typename Sample>
+void scan_point(const Sample* row,
+                const uint64_t* used,
+                const int x,
+                const double a,
+                const double row_offset,
+                const double no_data_value,
+                RowMax& best)
+{
+    const double z = row[x];
+    if(used_bits(used, x, 1) || std::isnan(z) || z == no_data_value)
+    {
+        return;
+    }
+    const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    const __m128d plane = _mm_add_sd(
+        _mm_mul_sd(_mm_set_sd(a), _mm_set_sd(static_cast<double>(x))), _mm_set_sd(row_offset));
+    const double error = _mm_cvtsd_f64(_mm_and_pd(_mm_sub_sd(_mm_set_sd(z), plane), abs_mask));
+    best.consider(&error, x, 1);
+}
+#endif
+
+#if defined(__AVX2__)
+template<typename Sample>
+void scan_avx2(const Sample* row,
+               const uint64_t* used,
+               int& x,
+               const int endx,
+               const double a,
+               const double row_offset,
+               const double no_data_value,
+               RowMax& best)
+{
+    const __m256d va = _mm256_set1_pd(a);
+    const __m256d voffset = _mm256_set1_pd(row_offset);
+    const __m256d vno_data = _mm256_set1_pd(no_data_value);
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    const __m256d step = _mm256_set1_pd(4);
+
+    __m256d vx = _mm256_setr_pd(x, x + 1, x + 2, x + 3);
+    auto errors4 = [&](const __m256i flags, const __m256i lane_flags, const int cx) {
+        const __m256d is_used = _mm256_castsi256_pd(
+            _mm256_cmpeq_epi64(_mm256_and_si256(flags, lane_flags), lane_flags));
+
+        const __m256d z = load4(row + cx);
+        const __m256d plane = _mm256_add_pd(_mm256_mul_pd(va, vx), voffset);
+        const __m256d error = _mm256_and_pd(_mm256_sub_pd(z, plane), abs_mask);
+        vx = _mm256_add_pd(vx, step);
+
+        // all bits set is a nan, nan errors of nan points stay nan
+        const __m256d invalid = _mm256_or_pd(is_used, _mm256_cmp_pd(z, vno_data, _CMP_EQ_OQ));
+        return _mm256_or_pd(error, invalid);
+    };
+
+    for(; x + 7 <= endx; x += 8)
+    {
+        const __m256i flags = _mm256_set1_epi64x(used_bits(used, x, 8));
+        const __m256d e0 = errors4(flags, _mm256_setr_epi64x(1, 2, 4, 8), x);
+        const __m256d e1 = errors4(flags, _mm256_setr_epi64x(16, 32, 64, 128), x + 4);
+
+        // max_pd returns its second operand if the first one is nan
+        const __m256d vbest = _mm256_set1_pd(best.error);
+        const __m256d block_max = _mm256_max_pd(e1, _mm256_max_pd(e0, vbest));
+        if(_mm256_movemask_pd(_mm256_cmp_pd(block_max, vbest, _CMP_GT_OQ)))
+        {
+            alignas(32) double errors[8];
+            _mm256_store_pd(errors, e0);
+            _mm256_store_pd(errors + 4, e1);
+            best.consider(errors, x, 8);
+        }
+    }
+}
+#endif
+
+#if defined(TNTN_SCANLINE_SSE2)
+template<typename Sample>
+void scan_sse2(const Sample* row,
+               const uint64_t* used,
+               int& x,
+               const int endx,
+               const double a,
+               const double row_offset,
+               const double no_data_value,
+               RowMax& best)
+{
+    const __m128d va = _mm_set1_pd(a);
+    const __m128d voffset = _mm_set1_pd(row_offset);
+    const __m128d vno_data = _mm_set1_pd(no_data_value);
+    const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    const __m128d step = _mm_set1_pd(2);
+
+    __m128d vx = _mm_setr_pd(x, x + 1);
+    // the flag of each lane is repeated in both of its 32 bit halves
+    auto errors2 = [&](const __m128i flags, const __m128i lane_flags, const int cx) {
+        const __m128d is_used =
+            _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(flags, lane_flags), lane_flags));
+
+        const __m128d z = load2(row + cx);
+        const __m128d plane = _mm_add_pd(_mm_mul_pd(va, vx), voffset);
+        const __m128d error = _mm_and_pd(_mm_sub_pd(z, plane), abs_mask);
+        vx = _mm_add_pd(vx, step);
+
+        const __m128d invalid = _mm_or_pd(is_used, _mm_cmpeq_pd(z, vno_data));
+        return _mm_or_pd(error, invalid);
+    };
+
+    for(; x + 3 <= endx; x += 4)
+    {
+        const __m128i flags = _mm_set1_epi32(used_bits(used, x, 4));
+        const __m128d e0 = errors2(flags, _mm_setr_epi32(1, 1, 2, 2), x);
+        const __m128d e1 = errors2(flags, _mm_setr_epi32(4, 4, 8, 8), x + 2);
+
+        const __m128d vbest = _mm_set1_pd(best.error);
+        const __m128d block_max = _mm_max_pd(e1, _mm_max_pd(e0, vbest));
+        if(_mm_movemask_pd(_mm_cmpgt_pd(block_max, vbest)))
+        {
+            alignas(16) double errors[4];
+            _mm_store_pd(errors, e0);
+            _mm_store_pd(errors + 2, e1);
+            best.consider(errors, x, 4);
+        }
+    }
+}
+#endif
+
+template<typename Sample>
+int scan_row(const Sample* row,
+             const uint64_t* used,
+             const int startx,
+             const int endx,
+             const double a,
+             const double row_offset,
+             const double no_data_value,
+             double& max_error)
+{
+    RowMax best;
+    int x = startx;
+
+#if defined(__AVX2__)
+    scan_avx2(row, used, x, endx, a, row_offset, no_data_value, best);
+#endif
+#if defined(TNTN_SCANLINE_SSE2)
+    scan_sse2(row, used, x, endx, a, row_offset, no_data_value, best);
+    for(; x <= endx; x++)
+    {
+        scan_point(row, used, x, a, row_offset, no_data_value, best);
+    }
+#else
+    for(; x <= endx; x++)
+    {
+        const double z = row[x];
+        if(!used_bits(used, x, 1) && !std::isnan(z) && z != no_data_value)
+        {
+            const double error = std::abs(z - (a * x + row_offset));
+            best.consider(&error, x, 1);
+        }
+    }
+#endif
+
+    if(best.x < 0)
+    {
+        return -1;
+    }
+    max_error = best.error;
+    return best.x;
+}
+
+} //namespace
+
+int scan_row_max_error(const double* row,
+                       const uint64_t* used,
+                       int startx,
+                       int endx,
+                       double a,
+                       double row_offset,
+                       double no_data_value,
+                       double& max_error)
+{
+    return scan_row(row, used, startx, endx, a, row_offset, no_data_value, max_error);
+}
+
+int scan_row_max_error(const float* row,
+                       const uint64_t* used,
+                       int startx,
+                       int endx,
+                       double a,
+                       double row_offset,
+                       double no_data_value,
+                       double& max_error)
+{
+    return scan_row(row, used, startx, endx, a, row_offset, no_data_value, max_error);
+}
+
+} //namespace terra
+} //namespace tntn
@@ -0,0 +1,42 @@
+#include "tntn/vertex_normals.h"
+#include "tntn/MercatorToEcef.h"
+#include "tntn/tntn_assert.h"
+
+namespace tntn {
+
+void compute_vertex_normals(const SimpleRange<const Vertex*> vertices,
+                            const SimpleRange<const Face*> faces,
+                            std::vector<Normal>& normals)
+{
+    const size_t num_vertices = vertices.distance();
+    normals.assign(num_vertices, Normal(0.0));
+
+    // the cross product's length is twice the face's area
+    for(const Face* f = faces.begin; f != faces.end; f++)
+    {
+        const Face& face = *f;
+        TNTN_ASSERT(face[0] < num_vertices && face[1] < num_vertices && face[2] < num_vertices);
+        const Vertex& a = vertices.begin[face[0]];
+        const Normal n = glm::cross(vertices.begin[face[1]] - a, vertices.begin[face[2]] - a);
+        normals[face[0]] += n;
+        normals[face[1]] += n;
+        normals[face[2]] += n;
+    }
+}
+
+void compute_ecef_vertex_normals(const Mesh& mesh, std::vector<Normal>& normals)
+{
+    const auto vertices = mesh.vertices();
+    std::vector<Vertex> ecef(vertices.begin, vertices.end);
+    MercatorToEcef::transform(ecef.data(), ecef.size());
+
+    compute_vertex_normals({ecef.data(), ecef.data() + ecef.size()}, mesh.faces(), normals);
+
+    for(size_t i = 0; i < normals.size(); i++)
+    {
+        const double length = glm::length(normals[i]);
+        normals[i] = length > 0 ? normals[i] / length : glm::normalize(ecef[i]);
+    }
+}
+
+} //namespace tntn
@@ -6,7 +6,15 @@ namespace tntn {
 
 std::unique_ptr<Mesh> generate_tin_zemlya(std::unique_ptr<RasterDouble> raster, double max_error)
 {
-    zemlya::ZemlyaMesh g;
+    zemlya::ZemlyaMesh<double> g;
+    g.load_raster(std::move(raster));
+    g.greedy_insert(max_error);
+    return g.convert_to_mesh();
+}
+
+std::unique_ptr<Mesh> generate_tin_zemlya(std::unique_ptr<RasterFloat> raster, double max_error)
+{
+    zemlya::ZemlyaMesh<float> g;
     g.load_raster(std::move(raster));
     g.greedy_insert(max_error);
     return g.convert_to_mesh();
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include "tntn/BinaryIO.h"
+#include "tntn/File.h"
+
+namespace tntn {
+namespace unittests {
+
+namespace {
+
+// counts the write calls reaching the file
+class CountingFile : public MemoryFile
+{
+  public:
+    bool write(position_type to_offset, const unsigned char* data, size_t data_size) override
+    {
+        num_writes++;
+        return MemoryFile::write(to_offset, data, data_size);
+    }
+    using FileLike::write;
+
+    int num_writes = 0;
+};
+
+} //namespace
+
+static std::vector<unsigned char> write_sample(const std::shared_ptr<FileLike>& f,
+                                               const Endianness endianness,
+                                               const bool buffered)
+{
+    BinaryIO bio(f, endianness, buffered);
+    BinaryIOErrorTracker e;
+    bio.write_byte(0x01, e);
+    bio.write_uint16(0x0203, e);
+    bio.write_uint32(0x04050607, e);
+    bio.write_double(1.0, e);
+    bio.write_array_uint16({0x0809, 0x0a0b, 0x0c0d}, e);
+    bio.write_array_int32({-2, 0x0e0f1011}, e);
+    CHECK(bio.write_pos() == 1 + 2 + 4 + 8 + 6 + 8);
+    bio.flush(e);
+    CHECK(!e.has_error());
+
+    std::vector<unsigned char> out;
+    f->read(0, out, f->size());
+    return out;
+}
+
+TEST_CASE("BinaryIO writes little and big endian", "[tntn]")
+{
+    const std::vector<unsigned char> le = write_sample(std::make_shared<MemoryFile>(),
+                                                       Endianness::LITTLE,
+                                                       false);
+    const std::vector<unsigned char> be =
+        write_sample(std::make_shared<MemoryFile>(), Endianness::BIG, false);
+
+    const std::vector<unsigned char> expected_le = {
+        0x01, 0x03, 0x02, 0x07, 0x06, 0x05, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xf0, 0x3f, 0x09, 0x08, 0x0b, 0x0a, 0x0d, 0x0c, 0xfe, 0xff, 0xff, 0xff, 0x11,
+        0x10, 0x0f, 0x0e};
+    const std::vector<unsigned char> expected_be = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x3f, 0xf0, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0xff, 0xff, 0xff, 0xfe, 0x0e,
+        0x0f, 0x10, 0x11};
+
+    CHECK(le == expected_le);
+    CHECK(be == expected_be);
+}
+
+TEST_CASE("BinaryIO buffered writes produce the same bytes in one write", "[tntn]")
+{
+    for(const Endianness endianness : {Endianness::LITTLE, Endianness::BIG})
+    {
+        auto direct = std::make_shared<CountingFile>();
+        auto buffered = std::make_shared<CountingFile>();
+
+        CHECK(write_sample(direct, endianness, false) == write_sample(buffered, endianness, true));
+        CHECK(direct->num_writes == 6);
+        CHECK(buffered->num_writes == 1);
+    }
+}
+
+TEST_CASE("BinaryIO flushes buffered writes on destruction", "[tntn]")
+{
+    auto f = std::make_shared<MemoryFile>();
+    {
+        BinaryIO bio(f, Endianness::LITTLE, true);
+        BinaryIOErrorTracker e;
+        bio.write_uint32(42, e);
+        CHECK(f->size() == 0);
+    }
+    CHECK(f->size() == 4);
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include "tntn/BoundedQueue.h"
+
+#include <thread>
+#include <vector>
+
+namespace tntn {
+namespace unittests {
+
+TEST_CASE("BoundedQueue keeps FIFO order and drains after close", "[tntn]")
+{
+    BoundedQueue<int> q(4);
+    CHECK(q.push(1));
+    CHECK(q.push(2));
+    CHECK(q.push(3));
+    q.close();
+    CHECK(!q.push(4));
+
+    int v = 0;
+    CHECK(q.pop(v));
+    CHECK(v == 1);
+    CHECK(q.pop(v));
+    CHECK(v == 2);
+    CHECK(q.pop(v));
+    CHECK(v == 3);
+    CHECK(!q.pop(v));
+
+    const auto stats = q.stats();
+    CHECK(stats.capacity == 4);
+    CHECK(stats.items == 3);
+    CHECK(stats.max_depth == 3);
+    CHECK(stats.mean_depth == Approx(2.0));
+}
+
+TEST_CASE("BoundedQueue with concurrent producers and consumers", "[tntn]")
+{
+    const int num_producers = 3;
+    const int num_consumers = 2;
+    const int items_per_producer = 1000;
+
+    BoundedQueue<int> q(2);
+
+    std::vector<std::thread> producers;
+    for(int p = 0; p < num_producers; p++)
+    {
+        producers.emplace_back([&q, p]() {
+            for(int i = 0; i < items_per_producer; i++)
+            {
+                q.push(p * items_per_producer + i);
+            }
+        });
+    }
+
+    std::vector<std::vector<int>> consumed(num_consumers);
+    std::vector<std::thread> consumers;
+    for(int c = 0; c < num_consumers; c++)
+    {
+        consumers.emplace_back([&q, &consumed, c]() {
+            int v = 0;
+            while(q.pop(v))
+            {
+                consumed[c].push_back(v);
+            }
+        });
+    }
+
+    for(auto& t : producers)
+    {
+        t.join();
+    }
+    q.close();
+    for(auto& t : consumers)
+    {
+        t.join();
+    }
+
+    std::vector<int> seen(num_producers * items_per_producer, 0);
+    for(const auto& values : consumed)
+    {
+        for(const int v : values)
+        {
+            REQUIRE(v >= 0);
+            REQUIRE(v < static_cast<int>(seen.size()));
+            seen[v]++;
+        }
+    }
+    for(const int count : seen)
+    {
+        CHECK(count == 1);
+    }
+
+    const auto stats = q.stats();
+    CHECK(stats.items == seen.size());
+    CHECK(stats.max_depth <= 2);
+}
+
+} //namespace unittests
+} //namespace tntn
@@ -80,5 +80,57 @@ TEST_CASE("getline on MemoryFile", "[tntn]")
     CHECK(line == "baz");
 }
 
+TEST_CASE("MappedFile gives the bytes of a file in place", "[tntn]")
+{
+    auto tempfilename =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    File fout;
+    REQUIRE(fout.open(tempfilename.c_str(), File::OM_RWC));
+    BOOST_SCOPE_EXIT(&tempfilename) { boost::filesystem::remove(tempfilename); }
+    BOOST_SCOPE_EXIT_END
+    CHECK(fout.write(0, "foobar", 6));
+    CHECK(fout.close());
+
+    MappedFile f;
+    REQUIRE(f.open(tempfilename.string()));
+    CHECK(f.is_good());
+    CHECK(f.size() == 6);
+    REQUIRE(f.data() != nullptr);
+    CHECK(std::string(reinterpret_cast<const char*>(f.data()), 6) == "foobar");
+
+    std::string bar;
+    f.read(3, bar, 10);
+    CHECK(bar == "bar");
+    CHECK(!f.write(0, "x", 1));
+
+    CHECK(f.close());
+    CHECK(!f.is_good());
+    CHECK(f.data() == nullptr);
+}
+
+TEST_CASE("MappedFile on empty and missing files", "[tntn]")
+{
+    auto tempfilename =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    MappedFile f;
+    CHECK(!f.open(tempfilename.string()));
+    CHECK(!f.is_good());
+
+    File fout;
+    REQUIRE(fout.open(tempfilename.c_str(), File::OM_RWC));
+    BOOST_SCOPE_EXIT(&tempfilename) { boost::filesystem::remove(tempfilename); }
+    BOOST_SCOPE_EXIT_END
+    CHECK(fout.close());
+
+    REQUIRE(f.open(tempfilename.string()));
+    CHECK(f.is_good());
+    CHECK(f.size() == 0);
+    std::string empty;
+    f.read(0, empty, 10);
+    CHECK(empty.empty());
+}
+
 } //namespace unittests
 } //namespace tntn
@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include "tntn/MercatorToEcef.h"
+#include "tntn/gdal_init.h"
+
+#include <memory>
+#include <vector>
+
+#include <ogr_spatialref.h>
+
+namespace tntn {
+namespace unittests {
+
+struct EcefReference
+{
+    glm::dvec3 mercator;
+    glm::dvec3 ecef;
+};
+
+// computed with the textbook formulas lat = 2 * atan(exp(y / a)) - pi / 2, lon = x / a
+static const std::vector<EcefReference> ecef_references = {
+    {{0.0, 0.0, 0.0}, {6378137, 0, 0}},
+    {{1113194.9079327357, 6446275.841017158, 500.0},
+     {4045772.9164516684, 713378.92299000337, 4863172.0599279916}},
+    {{-13627361.035049, 4544761.9, 120.5},
+     {-2706776.5769563788, -4262456.2072485648, 3883983.8793287277}},
+    {{15000000.0, -19000000.0, -30.0},
+     {-456955.2685627265, 461004.02391348599, -6323717.7615832333}},
+    {{2000000.0, 20037508.342789244, 8000.0},
+     {525795.28600184154, 170499.4579202419, 6340866.1915393015}},
+};
+
+TEST_CASE("MercatorToEcef matches reference values", "[tntn]")
+{
+    for(const auto& ref : ecef_references)
+    {
+        const glm::dvec3 p = MercatorToEcef::transform(ref.mercator);
+        CHECK(p.x == Approx(ref.ecef.x).margin(1e-6));
+        CHECK(p.y == Approx(ref.ecef.y).margin(1e-6));
+        CHECK(p.z == Approx(ref.ecef.z).margin(1e-6));
+    }
+
+    std::vector<glm::dvec3> points;
+    for(const auto& ref : ecef_references)
+    {
+        points.push_back(ref.mercator);
+    }
+    MercatorToEcef::transform(points.data(), points.size());
+    for(size_t i = 0; i < points.size(); i++)
+    {
+        CHECK(points[i] == MercatorToEcef::transform(ecef_references[i].mercator));
+    }
+}
+
+TEST_CASE("MercatorToEcef matches GDAL", "[tntn]")
+{
+    initialize_gdal_once();
+
+    OGRSpatialReference mercator;
+    OGRSpatialReference ecef;
+    mercator.importFromEPSG(3857);
+    ecef.importFromEPSG(4978);
+
+    std::unique_ptr<OGRCoordinateTransformation> tr(
+        OGRCreateCoordinateTransformation(&mercator, &ecef));
+    REQUIRE(tr != nullptr);
+
+    const double extent = 20037508.342789244;
+    for(int i = 0; i <= 20; i++)
+    {
+        for(int j = 0; j <= 20; j++)
+        {
+            glm::dvec3 p(extent * (i - 10) / 10.5, extent * (j - 10) / 10.5, (i - j) * 300.0);
+
+            glm::dvec3 expected = p;
+            REQUIRE(tr->Transform(1, &expected.x, &expected.y, &expected.z));
+
+            const glm::dvec3 actual = MercatorToEcef::transform(p);
+            CHECK(actual.x == Approx(expected.x).margin(1e-3));
+            CHECK(actual.y == Approx(expected.y).margin(1e-3));
+            CHECK(actual.z == Approx(expected.z).margin(1e-3));
+        }
+    }
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -1,11 +1,18 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <random>
 
+#include <boost/filesystem.hpp>
+
 #include "tntn/QuantizedMeshIO.h"
+#include "tntn/MercatorToEcef.h"
 #include "tntn/MeshIO.h"
 #include "tntn/terra_meshing.h"
 #include "tntn/geometrix.h"
+#include "tntn/logging.h"
 
 using namespace tntn::detail;
 
@@ -148,5 +155,503 @@ TEST_CASE("load reference quantized mesh", "[tntn]")
 }
 #endif
 
+// grid of n x n vertices in the unit square as produced by TileMaker,
+// faces refer to the vertices in shuffled order
+static void make_tile_mesh(const int n, std::vector<Vertex>& vertices, std::vector<Face>& faces)
+{
+    std::vector<size_t> slot(n * n);
+    for(size_t i = 0; i < slot.size(); i++)
+    {
+        slot[i] = i;
+    }
+    std::mt19937 generator(42); //fixed seed
+    std::shuffle(slot.begin(), slot.end(), generator);
+
+    vertices.resize(n * n);
+    for(int y = 0; y < n; y++)
+    {
+        for(int x = 0; x < n; x++)
+        {
+            const double z = 0.5 + 0.5 * std::sin(x * 0.05) * std::cos(y * 0.07);
+            vertices[slot[y * n + x]] = {x / (n - 1.0), y / (n - 1.0), z};
+        }
+    }
+
+    faces.clear();
+    for(int y = 0; y + 1 < n; y++)
+    {
+        for(int x = 0; x + 1 < n; x++)
+        {
+            const size_t a = slot[y * n + x];
+            const size_t b = slot[y * n + x + 1];
+            const size_t c = slot[(y + 1) * n + x];
+            const size_t d = slot[(y + 1) * n + x + 1];
+            faces.push_back({{a, b, d}});
+            faces.push_back({{a, d, c}});
+        }
+    }
+}
+
+static std::string qm_bytes(const Mesh& mesh, const BBox3D& bbox)
+{
+    auto mf = std::make_shared<MemoryFile>();
+    REQUIRE(write_mesh_as_qm(mf, mesh, bbox, true));
+    std::string out;
+    mf->read(0, out, mf->size());
+    return out;
+}
+
+TEST_CASE("quantized mesh writer gives the same output for triangles and faces", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_tile_mesh(40, vertices, faces);
+
+    Mesh decomposed;
+    decomposed.from_decomposed(std::move(vertices), std::move(faces));
+
+    decomposed.generate_triangles();
+    Mesh triangles;
+    std::vector<Triangle> tris;
+    decomposed.grab_triangles(tris);
+    triangles.from_triangles(std::move(tris));
+    REQUIRE(!triangles.has_decomposed());
+
+    const BBox3D bbox(glm::dvec3(1000, 2000, 0), glm::dvec3(2000, 3000, 100));
+    const std::string from_faces = qm_bytes(decomposed, bbox);
+    const std::string from_triangles = qm_bytes(triangles, bbox);
+    CHECK(from_faces == from_triangles);
+
+    auto mf = std::make_shared<MemoryFile>();
+    mf->write(0, from_faces);
+    auto loaded_mesh = load_mesh_from_qm(mf);
+    REQUIRE(loaded_mesh != nullptr);
+    CHECK(loaded_mesh->vertices().distance() == 40 * 40);
+    CHECK(loaded_mesh->faces().distance() == 2 * 39 * 39);
+}
+
+// not run by default, use `tntn-tests [benchmark]`
+TEST_CASE("quantized mesh writer vertex ordering on 64k vertex tiles", "[.][benchmark]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_tile_mesh(255, vertices, faces);
+
+    Mesh decomposed;
+    decomposed.from_decomposed(std::move(vertices), std::move(faces));
+
+    decomposed.generate_triangles();
+    Mesh triangles;
+    std::vector<Triangle> tris;
+    decomposed.grab_triangles(tris);
+    triangles.from_triangles(std::move(tris));
+
+    const BBox3D bbox(glm::dvec3(1000, 2000, 0), glm::dvec3(2000, 3000, 100));
+    const int repetitions = 20;
+
+    using clock = std::chrono::steady_clock;
+    std::chrono::duration<double> hash_time(0);
+    std::chrono::duration<double> remap_time(0);
+    for(int i = 0; i < repetitions; i++)
+    {
+        auto t0 = clock::now();
+        const std::string from_triangles = qm_bytes(triangles, bbox);
+        auto t1 = clock::now();
+        const std::string from_faces = qm_bytes(decomposed, bbox);
+        auto t2 = clock::now();
+
+        hash_time += t1 - t0;
+        remap_time += t2 - t1;
+        CHECK(from_faces == from_triangles);
+    }
+
+    TNTN_LOG_INFO("{} tiles with {} vertices: hashed vertices {:.3f}s, remapped faces {:.3f}s",
+                  repetitions,
+                  decomposed.vertices().distance(),
+                  hash_time.count(),
+                  remap_time.count());
+}
+
+TEST_CASE("compute_bounding_sphere encloses all points", "[tntn]")
+{
+    glm::dvec3 center;
+    double radius = -1;
+
+    compute_bounding_sphere(nullptr, 0, center, radius);
+    CHECK(radius == 0);
+
+    const std::vector<glm::dvec3> pair = {{1, 2, 3}, {1, 2, 13}};
+    compute_bounding_sphere(pair.data(), pair.size(), center, radius);
+    CHECK(radius == Approx(5));
+    CHECK(center.z == Approx(8));
+
+    std::mt19937 generator(42); //fixed seed
+    std::uniform_real_distribution<double> dist(-1000, 1000);
+    std::vector<glm::dvec3> points(1000);
+    for(auto& p : points)
+    {
+        p = glm::dvec3(dist(generator), dist(generator) * 0.1, dist(generator) * 0.01);
+    }
+    compute_bounding_sphere(points.data(), points.size(), center, radius);
+
+    for(const auto& p : points)
+    {
+        CHECK(glm::distance(p, center) <= radius * (1 + 1e-12));
+    }
+    // at most the radius of the sphere around the origin of the symmetric distribution
+    CHECK(radius <= std::sqrt(1000.0 * 1000.0 * (1 + 0.01 + 0.0001)));
+    CHECK(radius >= 990);
+}
+
+// Cesium's EllipsoidalOccluder.isScaledSpacePointVisible negated
+static bool is_occluded(const glm::dvec3& scaled_point, const glm::dvec3& scaled_camera)
+{
+    const glm::dvec3 vt = scaled_point - scaled_camera;
+    const double vt_dot_vc = -glm::dot(vt, scaled_camera);
+    const double vh_magnitude2 = glm::dot(scaled_camera, scaled_camera) - 1.0;
+    return vt_dot_vc > vh_magnitude2 && vt_dot_vc * vt_dot_vc / glm::dot(vt, vt) > vh_magnitude2;
+}
+
+TEST_CASE("compute_horizon_occlusion_point hides the tile behind the horizon", "[tntn]")
+{
+    const glm::dvec3 inverse_radii(1 / 6378137.0, 1 / 6378137.0, 1 / 6356752.3142451793);
+
+    // a 20km tile with up to 3km high terrain in the alps
+    std::mt19937 generator(42); //fixed seed
+    std::uniform_real_distribution<double> offset(0, 20000);
+    std::uniform_real_distribution<double> height(0, 3000);
+    std::vector<glm::dvec3> points(500);
+    for(auto& p : points)
+    {
+        p = MercatorToEcef::transform(
+            glm::dvec3(1000000 + offset(generator), 5800000 + offset(generator), height(generator)));
+    }
+
+    glm::dvec3 center;
+    double radius;
+    compute_bounding_sphere(points.data(), points.size(), center, radius);
+
+    glm::dvec3 occlusion_point;
+    REQUIRE(compute_horizon_occlusion_point(
+        points.data(), points.size(), center, occlusion_point));
+    CHECK(glm::length(occlusion_point) > 1.0);
+
+    std::normal_distribution<double> normal;
+    int num_occluded = 0;
+    for(int i = 0; i < 2000; i++)
+    {
+        const glm::dvec3 direction =
+            glm::normalize(glm::dvec3(normal(generator), normal(generator), normal(generator)));
+        const double altitude = std::pow(10.0, 2 + i % 6);
+        const glm::dvec3 camera = direction * (6378137.0 + altitude) * inverse_radii;
+
+        if(is_occluded(occlusion_point, camera))
+        {
+            num_occluded++;
+            bool all_occluded = true;
+            for(const auto& p : points)
+            {
+                all_occluded = all_occluded && is_occluded(p * inverse_radii, camera);
+            }
+            CHECK(all_occluded);
+        }
+    }
+    CHECK(num_occluded > 500);
+
+    // points on opposite sides of the earth can not be hidden
+    const std::vector<glm::dvec3> opposite = {{6378137.0, 0, 0}, {-6378137.0, 0, 0}};
+    CHECK(!compute_horizon_occlusion_point(
+        opposite.data(), opposite.size(), glm::dvec3(0, 1, 0), occlusion_point));
+}
+
+TEST_CASE("quantized mesh header bounding sphere encloses the tile", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_tile_mesh(40, vertices, faces);
+
+    Mesh mesh;
+    mesh.from_decomposed(std::vector<Vertex>(vertices), std::move(faces));
+
+    const BBox3D bbox(glm::dvec3(1000000, 5800000, 200), glm::dvec3(1010000, 5810000, 2500));
+    const std::string bytes = qm_bytes(mesh, bbox);
+    REQUIRE(bytes.size() > 88);
+
+    double header[11];
+    memcpy(&header[0], bytes.data(), 24); // center
+    memcpy(&header[3], bytes.data() + 32, 56); // sphere and horizon occlusion point
+    const glm::dvec3 center(header[3], header[4], header[5]);
+    const double radius = header[6];
+
+    for(const Vertex& v : vertices)
+    {
+        const glm::dvec3 ecef = MercatorToEcef::transform(bbox.min + v * (bbox.max - bbox.min));
+        CHECK(glm::distance(ecef, center) <= radius + 1e-3);
+    }
+    // the tile is about 10km x 10km
+    CHECK(radius < 8000);
+}
+
+TEST_CASE("oct_encode/oct_decode round trip", "[tntn]")
+{
+    uint8_t x = 0;
+    uint8_t y = 0;
+    oct_encode(glm::dvec3(0, 0, 1), x, y);
+    CHECK(x == 128);
+    CHECK(y == 128);
+
+    std::mt19937 generator(42); //fixed seed
+    std::normal_distribution<double> dist;
+    for(int i = 0; i < 1000; i++)
+    {
+        const glm::dvec3 n =
+            glm::normalize(glm::dvec3(dist(generator), dist(generator), dist(generator)));
+        oct_encode(n, x, y);
+        const glm::dvec3 decoded = oct_decode(x, y);
+        CHECK(glm::length(decoded) == Approx(1.0));
+        // 8 bits per component give about one degree of precision
+        CHECK(glm::dot(n, decoded) > std::cos(2.0 * M_PI / 180.0));
+    }
+}
+
+TEST_CASE("quantized mesh writer/loader round trip with vertex normals", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_tile_mesh(20, vertices, faces);
+
+    std::vector<Normal> normals;
+    for(const Vertex& v : vertices)
+    {
+        normals.push_back(glm::normalize(Normal(v.x - 0.5, v.y - 0.5, 1.0)));
+    }
+
+    Mesh mesh;
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+    mesh.set_normals(std::vector<Normal>(normals));
+
+    const BBox3D bbox(glm::dvec3(1000000, 5800000, 200), glm::dvec3(1010000, 5810000, 2500));
+    auto mf = std::make_shared<MemoryFile>();
+    REQUIRE(write_mesh_as_qm(mf, mesh, bbox, true));
+
+    auto loaded_mesh = load_mesh_from_qm(mf);
+    REQUIRE(loaded_mesh != nullptr);
+    REQUIRE(loaded_mesh->has_normals());
+
+    // the writer stores vertices in order of first use by the faces
+    std::vector<size_t> first_use;
+    std::vector<bool> seen(normals.size(), false);
+    for(const Face* f = mesh.faces().begin; f != mesh.faces().end; f++)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            if(!seen[(*f)[k]])
+            {
+                seen[(*f)[k]] = true;
+                first_use.push_back((*f)[k]);
+            }
+        }
+    }
+
+    const auto loaded_normals = loaded_mesh->normals();
+    REQUIRE(loaded_normals.distance() == first_use.size());
+    for(size_t i = 0; i < first_use.size(); i++)
+    {
+        CHECK(glm::dot(loaded_normals.begin[i], normals[first_use[i]]) >
+              std::cos(2.0 * M_PI / 180.0));
+    }
+
+    // tiles without normals carry no extension
+    Mesh plain;
+    make_tile_mesh(20, vertices, faces);
+    plain.from_decomposed(std::move(vertices), std::move(faces));
+    auto plain_file = std::make_shared<MemoryFile>();
+    REQUIRE(write_mesh_as_qm(plain_file, plain, bbox, true));
+    CHECK(plain_file->size() + 5 + 2 * 20 * 20 == mf->size());
+    auto loaded_plain = load_mesh_from_qm(plain_file);
+    REQUIRE(loaded_plain != nullptr);
+    CHECK(!loaded_plain->has_normals());
+}
+
+namespace {
+
+// hides the in-memory bytes of a MemoryFile, so readers have to go through read()
+class ReadOnlyFile : public MemoryFile
+{
+  public:
+    const unsigned char* data() override { return nullptr; }
+};
+
+} //namespace
+
+static bool same_decomposed(const Mesh& a, const Mesh& b)
+{
+    const auto av = a.vertices();
+    const auto bv = b.vertices();
+    const auto af = a.faces();
+    const auto bf = b.faces();
+    return std::equal(av.begin, av.end, bv.begin, bv.end) &&
+        std::equal(af.begin, af.end, bf.begin, bf.end);
+}
+
+TEST_CASE("quantized mesh loader decodes in place and through reads alike", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_tile_mesh(30, vertices, faces);
+
+    Mesh mesh;
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+    const BBox3D bbox(glm::dvec3(1000000, 5800000, 200), glm::dvec3(1010000, 5810000, 2500));
+    const std::string bytes = qm_bytes(mesh, bbox);
+
+    auto in_memory = std::make_shared<MemoryFile>();
+    in_memory->write(0, bytes);
+    auto read_only = std::make_shared<ReadOnlyFile>();
+    read_only->write(0, bytes);
+    REQUIRE(in_memory->data() != nullptr);
+
+    auto a = load_mesh_from_qm(in_memory);
+    auto b = load_mesh_from_qm(read_only);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    CHECK(a->faces().distance() == mesh.faces().distance());
+    CHECK(a->vertices().distance() == mesh.vertices().distance());
+    CHECK(same_decomposed(*a, *b));
+
+    // every truncation of the tile is rejected
+    for(size_t size = 0; size < bytes.size(); size += 7)
+    {
+        auto truncated = std::make_shared<MemoryFile>();
+        truncated->write(0, bytes.substr(0, size));
+        CHECK(load_mesh_from_qm(truncated) == nullptr);
+    }
+}
+
+TEST_CASE("quantized mesh loader rejects out of range triangle indices", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_tile_mesh(3, vertices, faces);
+
+    Mesh mesh;
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+    std::string bytes = qm_bytes(mesh, BBox3D(glm::dvec3(0, 0, 0), glm::dvec3(1, 1, 1)));
+
+    // 9 vertices, the first index of the second triangle follows header, vertex data and count
+    const size_t second_triangle = 88 + 4 + 9 * 6 + 2 + 4 + 3 * 2;
+    bytes[second_triangle] = 100;
+    bytes[second_triangle + 1] = 0;
+
+    auto f = std::make_shared<MemoryFile>();
+    f->write(0, bytes);
+    CHECK(load_mesh_from_qm(f) == nullptr);
+}
+
+TEST_CASE("quantized mesh writer merges vertices that collapse on quantization", "[tntn]")
+{
+    // a2 lies on the same grid point as a, the sliver a, a2, m has no area after quantization
+    std::vector<Vertex> vertices = {
+        {0, 0, 0.5},       //a
+        {0, 1e-7, 0.5},    //a2
+        {1, 0, 0.5},       //b
+        {0, 1, 0.5},       //c
+        {1, 1, 0.5},       //d
+        {0.5, 0.5, 0.75},  //m
+    };
+    std::vector<Face> faces = {
+        {{0, 2, 5}},
+        {{2, 4, 5}},
+        {{4, 3, 5}},
+        {{3, 1, 5}},
+        {{0, 1, 5}},
+    };
+
+    Mesh mesh;
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+    const std::string bytes = qm_bytes(mesh, BBox3D(glm::dvec3(0, 0, 0), glm::dvec3(1, 1, 1)));
+
+    auto f = std::make_shared<MemoryFile>();
+    f->write(0, bytes);
+    auto loaded_mesh = load_mesh_from_qm(f);
+    REQUIRE(loaded_mesh != nullptr);
+    CHECK(loaded_mesh->vertices().distance() == 5);
+    CHECK(loaded_mesh->faces().distance() == 4);
+    loaded_mesh->faces().for_each([](const Face& face) {
+        CHECK(face[0] != face[1]);
+        CHECK(face[1] != face[2]);
+        CHECK(face[2] != face[0]);
+    });
+
+    // west, south, east and north edge lists follow header, vertices and triangles
+    size_t offset = 88 + 4 + 5 * 6 + 4 + 4 * 3 * 2;
+    for(int edge = 0; edge < 4; edge++)
+    {
+        uint32_t count = 0;
+        REQUIRE(offset + 4 <= bytes.size());
+        std::memcpy(&count, bytes.data() + offset, 4);
+        CHECK(count == 2);
+        offset += 4 + count * 2;
+    }
+}
+
+// not run by default, use
+// `TNTN_BENCHMARK_QM_DIR=<dir with .terrain tiles> tntn-tests [benchmark]`
+TEST_CASE("quantized mesh loading throughput", "[.][benchmark]")
+{
+    const char* dir = std::getenv("TNTN_BENCHMARK_QM_DIR");
+    if(dir == nullptr)
+    {
+        TNTN_LOG_WARN("set TNTN_BENCHMARK_QM_DIR to a directory of .terrain tiles");
+        return;
+    }
+
+    std::vector<std::string> filenames;
+    for(boost::filesystem::recursive_directory_iterator it(dir), end; it != end; ++it)
+    {
+        if(it->path().extension() == ".terrain")
+        {
+            filenames.push_back(it->path().string());
+        }
+    }
+    REQUIRE(!filenames.empty());
+
+    auto load_all = [&](const bool mapped, size_t& bytes) {
+        bytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for(const std::string& filename : filenames)
+        {
+            std::shared_ptr<FileLike> f;
+            if(mapped)
+            {
+                auto mf = std::make_shared<MappedFile>();
+                REQUIRE(mf->open(filename));
+                f = mf;
+            }
+            else
+            {
+                auto ff = std::make_shared<File>();
+                REQUIRE(ff->open(filename, File::OM_R));
+                f = ff;
+            }
+            bytes += f->size();
+            REQUIRE(load_mesh_from_qm(f) != nullptr);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    };
+
+    for(const bool mapped : {false, true})
+    {
+        size_t bytes = 0;
+        const double seconds = load_all(mapped, bytes);
+        TNTN_LOG_INFO("{}: {} tiles, {:.0f} tiles/s, {:.1f} MB/s",
+                      mapped ? "MappedFile" : "File",
+                      filenames.size(),
+                      filenames.size() / seconds,
+                      bytes / seconds / (1024 * 1024));
+    }
+}
+
 } // namespace unittests
 } // namespace tntn
@@ -77,6 +77,68 @@ TEST_CASE("raster_overviews_tests_2", "[tntn]")
     }
 }
 
+TEST_CASE("cascaded raster overviews match direct overviews", "[tntn]")
+{
+    auto make_raster = []() {
+        auto raster = std::make_unique<RasterDouble>();
+        raster->allocate(512, 512);
+        raster->set_cell_size(10);
+        for(int r = 0; r < 512; r++)
+        {
+            for(int c = 0; c < 512; c++)
+            {
+                raster->value(r, c) = 1000 + r + 0.5 * c;
+            }
+        }
+        return raster;
+    };
+
+    RasterOverviews direct(make_raster(), 0, 20, OverviewMode::direct);
+    RasterOverviews cascaded(make_raster(), 0, 20, OverviewMode::cascaded);
+
+    RasterOverview a;
+    RasterOverview b;
+    int counter = 0;
+    while(direct.next(a))
+    {
+        REQUIRE(cascaded.next(b));
+        CHECK(a.zoom_level == b.zoom_level);
+        CHECK(a.resolution == b.resolution);
+        REQUIRE(a.raster->get_width() == b.raster->get_width());
+        REQUIRE(a.raster->get_height() == b.raster->get_height());
+        CHECK(a.raster->value(0, 0) == Approx(b.raster->value(0, 0)));
+        CHECK(a.raster->value(a.raster->get_height() - 1, a.raster->get_width() - 1)
+              == Approx(b.raster->value(b.raster->get_height() - 1, b.raster->get_width() - 1)));
+        counter++;
+    }
+    CHECK(!cascaded.next(b));
+    CHECK(counter == 3);
+}
+
+TEST_CASE("raster overviews hand out the base level without copying", "[tntn]")
+{
+    for(const OverviewMode mode : {OverviewMode::direct, OverviewMode::cascaded})
+    {
+        auto raster = std::make_unique<RasterDouble>();
+        raster->allocate(512, 512);
+        raster->set_cell_size(10);
+        raster->set_all(42);
+        const double* base_data = raster->get_ptr();
+
+        RasterOverviews overviews(std::move(raster), 0, 20, mode);
+
+        RasterOverview overview;
+        REQUIRE(overviews.next(overview));
+        CHECK(overview.raster->get_ptr() == base_data);
+        CHECK(overview.raster->get_width() == 512);
+
+        RasterOverview coarser;
+        REQUIRE(overviews.next(coarser));
+        CHECK(coarser.raster->get_ptr() != base_data);
+        CHECK(coarser.raster->get_width() == 256);
+        CHECK(coarser.raster->value(0, 0) == 42);
+    }
+}
 
 } // namespace unittests
 } // namespace tntn
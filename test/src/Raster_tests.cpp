@@ -1,6 +1,7 @@
 #include "catch.hpp"
 
 #include "tntn/Raster.h"
+#include "tntn/BitRaster.h"
 #include "tntn/raster_tools.h"
 #include "tntn/SurfacePoints.h"
 #include "tntn/Mesh.h"
@@ -418,5 +419,55 @@ TEST_CASE("Raster::toVertices", "[tntn]")
     CHECK(num_found == 2);
 }
 
+TEST_CASE("Raster share references the same data", "[tntn]")
+{
+    RasterDouble raster(3, 2);
+    raster.set_pos_x(10);
+    raster.set_cell_size(2);
+    raster.set_all(1);
+
+    RasterDouble shared = raster.share();
+    CHECK(shared.get_ptr() == raster.get_ptr());
+    CHECK(shared.get_width() == 3);
+    CHECK(shared.get_height() == 2);
+    CHECK(shared.get_pos_x() == 10);
+    CHECK(shared.get_cell_size() == 2);
+
+    // data outlives the raster it was shared from
+    raster.clear();
+    CHECK(shared.value(1, 2) == 1);
+}
+
+TEST_CASE("BitRaster keeps one flag per pixel", "[tntn]")
+{
+    BitRaster flags;
+    flags.allocate(70, 3);
+    CHECK(flags.get_width() == 70);
+    CHECK(flags.get_height() == 3);
+
+    flags.set(1, 0);
+    flags.set(1, 63);
+    flags.set(1, 64);
+    flags.set(2, 69);
+    for(unsigned int r = 0; r < 3; r++)
+    {
+        for(unsigned int c = 0; c < 70; c++)
+        {
+            const bool expected =
+                (r == 1 && (c == 0 || c == 63 || c == 64)) || (r == 2 && c == 69);
+            CHECK(flags.value(r, c) == expected);
+        }
+    }
+
+    // rows start at their own word
+    CHECK(flags.get_ptr(2) - flags.get_ptr(1) == 2);
+    CHECK(flags.get_ptr(1)[1] == 1);
+
+    flags.set_all(false);
+    CHECK_FALSE(flags.value(1, 63));
+    flags.set_all(true);
+    CHECK(flags.value(0, 5));
+}
+
 } // namespace unittests
 } // namespace tntn
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+
+#include "tntn/ThreadPool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace tntn {
+namespace unittests {
+
+TEST_CASE("ThreadPool parallel_for visits every index exactly once", "[tntn]")
+{
+    for(int num_threads : {1, 2, 4})
+    {
+        ThreadPool pool(num_threads);
+        CHECK(pool.num_threads() == num_threads);
+
+        std::vector<std::atomic<int>> visits(1000);
+        for(auto& v : visits)
+        {
+            v = 0;
+        }
+
+        const bool ok = pool.parallel_for(visits.size(), [&visits](size_t i) {
+            visits[i]++;
+            return true;
+        });
+
+        CHECK(ok);
+        for(const auto& v : visits)
+        {
+            CHECK(v == 1);
+        }
+    }
+}
+
+TEST_CASE("ThreadPool parallel_for can be nested", "[tntn]")
+{
+    ThreadPool pool(3);
+    std::atomic<int> sum(0);
+
+    const bool ok = pool.parallel_for(8, [&pool, &sum](size_t) {
+        return pool.parallel_for(100, [&sum](size_t j) {
+            sum += static_cast<int>(j);
+            return true;
+        });
+    });
+
+    CHECK(ok);
+    CHECK(sum == 8 * (99 * 100 / 2));
+}
+
+TEST_CASE("ThreadPool parallel_for propagates failures", "[tntn]")
+{
+    ThreadPool pool(4);
+
+    CHECK_FALSE(pool.parallel_for(100, [](size_t i) { return i != 42; }));
+
+    CHECK_THROWS_AS(pool.parallel_for(100,
+                                      [](size_t i) -> bool {
+                                          if(i == 7)
+                                          {
+                                              throw std::runtime_error("failed");
+                                          }
+                                          return true;
+                                      }),
+                    std::runtime_error);
+
+    //pool is still usable afterwards
+    CHECK(pool.parallel_for(10, [](size_t) { return true; }));
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -0,0 +1,130 @@
+#include "catch.hpp"
+
+#include "tntn/TileArchive.h"
+#include "tntn/ThreadPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tntn {
+namespace unittests {
+
+static std::vector<unsigned char> tile_payload(int zoom, int x, int y)
+{
+    const std::string s = std::to_string(zoom) + "/" + std::to_string(x) + "/" +
+        std::to_string(y) + std::string(x % 7, '*');
+    return std::vector<unsigned char>(s.begin(), s.end());
+}
+
+static std::vector<unsigned char> file_contents(FileLike& f)
+{
+    std::vector<unsigned char> data;
+    f.read(0, data, f.size());
+    return data;
+}
+
+TEST_CASE("TileArchive round trip", "[tntn]")
+{
+    auto f = std::make_shared<MemoryFile>();
+    TileArchiveWriter writer;
+    REQUIRE(writer.open(f));
+
+    // added out of order
+    REQUIRE(writer.add_tile(3, 5, 2, tile_payload(3, 5, 2)));
+    REQUIRE(writer.add_tile(1, 0, 1, tile_payload(1, 0, 1)));
+    REQUIRE(writer.add_tile(3, 4, 7, tile_payload(3, 4, 7)));
+    REQUIRE(writer.add_tile(2, 1, 0, std::vector<unsigned char>()));
+    REQUIRE(writer.finish());
+    CHECK(writer.num_tiles() == 4);
+
+    CHECK_FALSE(writer.add_tile(4, 0, 0, tile_payload(4, 0, 0)));
+
+    const auto data = file_contents(*f);
+    TileArchiveReader reader;
+    REQUIRE(reader.open(data.data(), data.size()));
+    CHECK(reader.num_tiles() == 4);
+
+    const unsigned char* tile = nullptr;
+    size_t size = 0;
+
+    for(const auto& t : std::vector<std::vector<int>>{{3, 5, 2}, {1, 0, 1}, {3, 4, 7}})
+    {
+        REQUIRE(reader.get_tile(t[0], t[1], t[2], tile, size));
+        const auto expected = tile_payload(t[0], t[1], t[2]);
+        CHECK(std::vector<unsigned char>(tile, tile + size) == expected);
+        // zero copy, the tile points into the archive
+        CHECK(tile >= data.data());
+        CHECK(tile + size <= data.data() + data.size());
+    }
+
+    REQUIRE(reader.get_tile(2, 1, 0, tile, size));
+    CHECK(size == 0);
+
+    CHECK_FALSE(reader.get_tile(3, 5, 3, tile, size));
+    CHECK_FALSE(reader.get_tile(0, 0, 0, tile, size));
+    CHECK_FALSE(reader.get_tile(-1, 0, 0, tile, size));
+}
+
+TEST_CASE("TileArchive concurrent writes", "[tntn]")
+{
+    auto f = std::make_shared<MemoryFile>();
+    TileArchiveWriter writer;
+    REQUIRE(writer.open(f));
+
+    const int zoom = 6;
+    const int n = 64;
+    ThreadPool pool(4);
+    REQUIRE(pool.parallel_for(n * n, [&](size_t i) {
+        const int x = static_cast<int>(i) % n;
+        const int y = static_cast<int>(i) / n;
+        return writer.add_tile(zoom, x, y, tile_payload(zoom, x, y));
+    }));
+    REQUIRE(writer.finish());
+
+    const auto data = file_contents(*f);
+    TileArchiveReader reader;
+    REQUIRE(reader.open(data.data(), data.size()));
+    REQUIRE(reader.num_tiles() == n * n);
+
+    bool all_equal = true;
+    for(int x = 0; x < n; x++)
+    {
+        for(int y = 0; y < n; y++)
+        {
+            const unsigned char* tile = nullptr;
+            size_t size = 0;
+            all_equal = all_equal && reader.get_tile(zoom, x, y, tile, size) &&
+                std::vector<unsigned char>(tile, tile + size) == tile_payload(zoom, x, y);
+        }
+    }
+    CHECK(all_equal);
+}
+
+TEST_CASE("TileArchive rejects duplicates and invalid data", "[tntn]")
+{
+    auto f = std::make_shared<MemoryFile>();
+    TileArchiveWriter writer;
+    REQUIRE(writer.open(f));
+    REQUIRE(writer.add_tile(1, 1, 1, tile_payload(1, 1, 1)));
+    REQUIRE(writer.add_tile(1, 1, 1, tile_payload(1, 1, 1)));
+    CHECK_FALSE(writer.finish());
+
+    TileArchiveReader reader;
+    const std::string garbage = "definitely not a tile archive, just some text";
+    CHECK_FALSE(
+        reader.open(reinterpret_cast<const unsigned char*>(garbage.data()), garbage.size()));
+
+    // truncated archive, trailer missing
+    auto f2 = std::make_shared<MemoryFile>();
+    TileArchiveWriter writer2;
+    REQUIRE(writer2.open(f2));
+    REQUIRE(writer2.add_tile(0, 0, 0, tile_payload(0, 0, 0)));
+    REQUIRE(writer2.finish());
+    auto data = file_contents(*f2);
+    data.resize(data.size() - 1);
+    CHECK_FALSE(reader.open(data.data(), data.size()));
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -0,0 +1,204 @@
+#include "catch.hpp"
+
+#include "tntn/TileAvailability.h"
+#include "tntn/dem2tintiles_workflow.h"
+#include "tntn/RasterOverviews.h"
+#include "tntn/TileArchive.h"
+
+#include <random>
+#include <set>
+#include <tuple>
+
+namespace tntn {
+namespace unittests {
+
+TEST_CASE("TileAvailability merges tiles into rectangles", "[tntn]")
+{
+    TileAvailability a;
+    CHECK(a.empty());
+    CHECK(a.max_zoom() == -1);
+
+    // a 3x2 block added out of order, and a single tile apart from it
+    for(const auto& t : {std::make_pair(2, 5),
+                         std::make_pair(0, 5),
+                         std::make_pair(1, 6),
+                         std::make_pair(1, 5),
+                         std::make_pair(0, 6),
+                         std::make_pair(2, 6),
+                         std::make_pair(7, 6),
+                         std::make_pair(1, 5)})
+    {
+        a.add_tile(3, t.first, t.second);
+    }
+
+    CHECK(a.num_tiles() == 7);
+    CHECK(a.min_zoom() == 3);
+    CHECK(a.max_zoom() == 3);
+    CHECK(a.has_tile(3, 1, 6));
+    CHECK(!a.has_tile(3, 3, 6));
+    CHECK(!a.has_tile(2, 1, 6));
+
+    const auto ranges = a.ranges(3);
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].start_x == 0);
+    CHECK(ranges[0].start_y == 5);
+    CHECK(ranges[0].end_x == 2);
+    CHECK(ranges[0].end_y == 6);
+    CHECK(ranges[1].start_x == 7);
+    CHECK(ranges[1].start_y == 6);
+    CHECK(ranges[1].end_x == 7);
+    CHECK(ranges[1].end_y == 6);
+
+    CHECK(a.ranges(4).empty());
+}
+
+TEST_CASE("TileAvailability ranges cover exactly the added tiles", "[tntn]")
+{
+    std::mt19937 generator(42); //fixed seed
+    std::uniform_int_distribution<int> coordinate(0, 30);
+
+    TileAvailability a;
+    std::set<std::tuple<int, int>> tiles;
+    for(int i = 0; i < 600; i++)
+    {
+        const int tx = coordinate(generator);
+        const int ty = coordinate(generator);
+        a.add_tile(10, tx, ty);
+        tiles.emplace(tx, ty);
+    }
+    CHECK(a.num_tiles() == tiles.size());
+
+    size_t covered = 0;
+    for(const TileRange& r : a.ranges(10))
+    {
+        for(int ty = r.start_y; ty <= r.end_y; ty++)
+        {
+            for(int tx = r.start_x; tx <= r.end_x; tx++)
+            {
+                CHECK(tiles.count(std::make_tuple(tx, ty)) == 1);
+                covered++;
+            }
+        }
+    }
+    // the ranges are disjoint
+    CHECK(covered == tiles.size());
+}
+
+TEST_CASE("TileAvailability removes tiles", "[tntn]")
+{
+    TileAvailability a;
+    a.add_range(3, TileRange{0, 0, 4, 1});
+    a.add_tile(5, 2, 2);
+
+    // from the middle, the start and the end of a run
+    a.remove_tile(3, 2, 0);
+    a.remove_tile(3, 0, 1);
+    a.remove_tile(3, 4, 1);
+    CHECK(a.num_tiles() == 8);
+    CHECK(!a.has_tile(3, 2, 0));
+    CHECK(a.has_tile(3, 1, 0));
+    CHECK(a.has_tile(3, 3, 0));
+    CHECK(!a.has_tile(3, 0, 1));
+    CHECK(a.has_tile(3, 1, 1));
+    CHECK(!a.has_tile(3, 4, 1));
+
+    // tiles that are not there
+    a.remove_tile(3, 2, 0);
+    a.remove_tile(3, 7, 7);
+    a.remove_tile(4, 0, 0);
+    CHECK(a.num_tiles() == 8);
+
+    a.remove_tile(5, 2, 2);
+    CHECK(a.max_zoom() == 3);
+}
+
+TEST_CASE("TileAvailability layer.json round trip", "[tntn]")
+{
+    TileAvailability a;
+    a.add_tile(0, 0, 0);
+    a.add_range(2, TileRange{1, 1, 3, 2});
+    a.add_tile(2, 0, 0);
+
+    MemoryFile f;
+    REQUIRE(a.write_layer_json(f, "terrain", {"octvertexnormals"}));
+
+    std::string json;
+    f.read(0, json, f.size());
+    CHECK(json.find("\"tiles\": [\"{z}/{x}/{y}.terrain\"]") != std::string::npos);
+    CHECK(json.find("\"extensions\": [\"octvertexnormals\"]") != std::string::npos);
+    CHECK(json.find("\"maxzoom\": 2") != std::string::npos);
+    // zoom level 1 has no tiles but still gets a list
+    CHECK(json.find("\n    [],\n") != std::string::npos);
+
+    TileAvailability b;
+    REQUIRE(b.read_layer_json(f));
+    CHECK(b.num_tiles() == a.num_tiles());
+    for(int zoom = 0; zoom <= 2; zoom++)
+    {
+        const auto ra = a.ranges(zoom);
+        const auto rb = b.ranges(zoom);
+        REQUIRE(ra.size() == rb.size());
+        for(size_t i = 0; i < ra.size(); i++)
+        {
+            CHECK(std::tie(ra[i].start_x, ra[i].start_y, ra[i].end_x, ra[i].end_y) ==
+                  std::tie(rb[i].start_x, rb[i].start_y, rb[i].end_x, rb[i].end_y));
+        }
+    }
+
+    MemoryFile broken;
+    broken.write(0, std::string("{\"available\": [[{\"startX\": 1}]]}"));
+    TileAvailability c;
+    CHECK(!c.read_layer_json(broken));
+}
+
+TEST_CASE("create_tiles_pipelined records the tiles it writes", "[tntn]")
+{
+    auto raster = std::make_unique<RasterDouble>(200, 200);
+    raster->set_pos_x(1000000);
+    raster->set_pos_y(5000000);
+    raster->set_cell_size(50);
+    for(int r = 0; r < 200; r++)
+    {
+        double* row = raster->get_ptr(r);
+        for(int c = 0; c < 200; c++)
+        {
+            row[c] = 100 + 20 * std::sin(r * 0.1) * std::cos(c * 0.07);
+        }
+    }
+
+    RasterOverviews overviews(std::move(raster), 10, 12);
+    auto archive_file = std::make_shared<MemoryFile>();
+    TileArchiveWriter archive;
+    REQUIRE(archive.open(archive_file));
+
+    QuantizedMeshWriter writer;
+    TileAvailability availability;
+    REQUIRE(create_tiles_pipelined(
+        overviews, "", 1.0, "terra", writer, 2, 8, &archive, nullptr, {}, &availability));
+    REQUIRE(archive.finish());
+
+    CHECK(availability.max_zoom() == 12);
+    CHECK(availability.num_tiles() > 0);
+    CHECK(availability.num_tiles() == archive.num_tiles());
+
+    TileArchiveReader reader;
+    REQUIRE(reader.open(archive_file->data(), archive_file->size()));
+    for(int zoom = 10; zoom <= 12; zoom++)
+    {
+        for(const TileRange& r : availability.ranges(zoom))
+        {
+            for(int ty = r.start_y; ty <= r.end_y; ty++)
+            {
+                for(int tx = r.start_x; tx <= r.end_x; tx++)
+                {
+                    const unsigned char* data = nullptr;
+                    size_t size = 0;
+                    CHECK(reader.get_tile(zoom, tx, ty, data, size));
+                }
+            }
+        }
+    }
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -0,0 +1,262 @@
+#include "catch.hpp"
+
+#include "tntn/TileMaker.h"
+#include "tntn/MercatorProjection.h"
+#include "tntn/Raster.h"
+#include "tntn/simple_meshing.h"
+#include "tntn/logging.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tntn {
+namespace unittests {
+
+namespace {
+
+std::unique_ptr<Mesh> make_dense_mesh(const int size,
+                                      const double cellsize,
+                                      const glm::dvec2 pos = {-1000, 500})
+{
+    RasterDouble raster;
+    raster.allocate(size, size);
+    raster.set_pos_x(pos.x);
+    raster.set_pos_y(pos.y);
+    raster.set_cell_size(cellsize);
+
+    for(int y = 0; y < size; y++)
+    {
+        auto row_ptr = raster.get_ptr(y);
+        for(int x = 0; x < size; x++)
+        {
+            row_ptr[x] = std::sin(x * 0.1) * std::cos(y * 0.1);
+        }
+    }
+
+    return generate_tin_dense_quadwalk(raster, 1);
+}
+
+std::vector<Triangle> find_triangles_linear(const Mesh& mesh, const BBox2D& bounds)
+{
+    std::vector<Triangle> out;
+    const auto triangles_range = mesh.triangles();
+    for(const Triangle* tp = triangles_range.begin; tp != triangles_range.end; tp++)
+    {
+        if(BBox2D(*tp).intersects(bounds))
+        {
+            out.push_back(*tp);
+        }
+    }
+    return out;
+}
+
+bool same_triangles(const std::vector<Triangle>& a, const std::vector<Triangle>& b)
+{
+    if(a.size() != b.size())
+    {
+        return false;
+    }
+    for(size_t i = 0; i < a.size(); i++)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            if(a[i][k] != b[i][k])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} //namespace
+
+TEST_CASE("TileMaker find_triangles matches linear scan", "[tntn]")
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> coord(-100, 100);
+    std::uniform_real_distribution<double> extent(0, 50);
+
+    std::vector<Triangle> triangles;
+    for(int i = 0; i < 2000; i++)
+    {
+        // mix of small and large triangles, some spanning many grid cells
+        const double size = i % 10 == 0 ? extent(rng) : extent(rng) / 20.0;
+        const glm::dvec3 a(coord(rng), coord(rng), i);
+        Triangle t;
+        t[0] = a;
+        t[1] = a + glm::dvec3(size, 0, 0);
+        t[2] = a + glm::dvec3(0, size, 0);
+        triangles.push_back(t);
+    }
+
+    auto mesh = std::make_unique<Mesh>();
+    mesh->from_triangles(std::move(triangles));
+    const Mesh& reference = *mesh;
+
+    TileMaker tile_maker;
+    tile_maker.loadMesh(std::move(mesh));
+
+    for(int i = 0; i < 500; i++)
+    {
+        const glm::dvec2 a(coord(rng) * 1.5, coord(rng) * 1.5);
+        const glm::dvec2 b = a + glm::dvec2(extent(rng), extent(rng));
+        const BBox2D bounds(a, b);
+
+        std::vector<Triangle> found;
+        tile_maker.find_triangles(bounds, found);
+        CHECK(same_triangles(found, find_triangles_linear(reference, bounds)));
+    }
+}
+
+TEST_CASE("TileMaker find_triangles on empty and flat meshes", "[tntn]")
+{
+    SECTION("empty mesh")
+    {
+        TileMaker tile_maker;
+        tile_maker.loadMesh(std::make_unique<Mesh>());
+
+        std::vector<Triangle> found;
+        tile_maker.find_triangles(BBox2D(glm::dvec2(-1, -1), glm::dvec2(1, 1)), found);
+        CHECK(found.empty());
+    }
+
+    SECTION("mesh with zero extent along y")
+    {
+        Triangle t;
+        t[0] = {0, 0, 0};
+        t[1] = {1, 0, 0};
+        t[2] = {2, 0, 0};
+        std::vector<Triangle> triangles = {t};
+
+        auto mesh = std::make_unique<Mesh>();
+        mesh->from_triangles(std::move(triangles));
+        TileMaker tile_maker;
+        tile_maker.loadMesh(std::move(mesh));
+
+        std::vector<Triangle> found;
+        tile_maker.find_triangles(BBox2D(glm::dvec2(0.5, -1), glm::dvec2(0.7, 1)), found);
+        CHECK(found.size() == 1);
+
+        found.clear();
+        tile_maker.find_triangles(BBox2D(glm::dvec2(3, -1), glm::dvec2(4, 1)), found);
+        CHECK(found.empty());
+    }
+}
+
+TEST_CASE("TileMaker vertex normals are continuous across tile borders", "[tntn]")
+{
+    const int zoom = 12;
+    const int tx = 2000;
+    const int ty = 2500;
+
+    MercatorProjection projection;
+    const BoundingBox west_tile = projection.TileBounds(tx, ty, zoom);
+    const BoundingBox east_tile = projection.TileBounds(tx + 1, ty, zoom);
+
+    // the grid lines do not coincide with the tile border, so triangles get clipped there
+    const int size = 47;
+    const double cellsize = (east_tile.max.x - west_tile.min.x) / (size - 3.5);
+    auto mesh =
+        make_dense_mesh(size, cellsize, {west_tile.min.x - cellsize, west_tile.min.y - cellsize});
+
+    TileMaker tile_maker;
+    tile_maker.loadMesh(std::move(mesh), true);
+
+    BBox3D west_bbox;
+    BBox3D east_bbox;
+    auto west = tile_maker.makeTile(tx, ty, zoom, west_bbox);
+    auto east = tile_maker.makeTile(tx + 1, ty, zoom, east_bbox);
+    REQUIRE(west != nullptr);
+    REQUIRE(east != nullptr);
+    REQUIRE(west->has_normals());
+    REQUIRE(east->has_normals());
+
+    const auto west_vertices = west->vertices();
+    const auto east_vertices = east->vertices();
+    int shared = 0;
+    for(size_t i = 0; i < west_vertices.distance(); i++)
+    {
+        const Vertex& w = west_vertices.begin[i];
+        if(w.x != 1.0)
+        {
+            continue;
+        }
+        for(size_t j = 0; j < east_vertices.distance(); j++)
+        {
+            const Vertex& e = east_vertices.begin[j];
+            if(e.x == 0.0 && std::abs(e.y - w.y) < 1e-9)
+            {
+                const Normal& wn = west->normals().begin[i];
+                const Normal& en = east->normals().begin[j];
+                CHECK(glm::length(wn) == Approx(1.0));
+                CHECK(glm::distance(wn, en) < 1e-9);
+                shared++;
+            }
+        }
+    }
+    CHECK(shared > size / 2);
+}
+
+// not run by default, use `tntn-tests [benchmark]`
+TEST_CASE("TileMaker triangle selection scaling with tile count", "[.][benchmark]")
+{
+    const int size = 512;
+    const double cellsize = 10.0;
+    auto mesh = make_dense_mesh(size, cellsize);
+    mesh->generate_triangles();
+
+    BBox3D bbox3d;
+    mesh->get_bbox(bbox3d);
+    const BBox2D bbox = bbox3d.to2D();
+    const Mesh& reference = *mesh;
+
+    TileMaker tile_maker;
+    tile_maker.loadMesh(std::move(mesh));
+
+    using clock = std::chrono::steady_clock;
+    for(int tiles_per_axis = 2; tiles_per_axis <= 64; tiles_per_axis *= 2)
+    {
+        const double tile_w = (bbox.max.x - bbox.min.x) / tiles_per_axis;
+        const double tile_h = (bbox.max.y - bbox.min.y) / tiles_per_axis;
+
+        size_t linear_count = 0;
+        size_t indexed_count = 0;
+        std::chrono::duration<double> linear_time(0);
+        std::chrono::duration<double> indexed_time(0);
+
+        for(int ty = 0; ty < tiles_per_axis; ty++)
+        {
+            for(int tx = 0; tx < tiles_per_axis; tx++)
+            {
+                const glm::dvec2 tile_min(bbox.min.x + tx * tile_w, bbox.min.y + ty * tile_h);
+                BBox2D tile_bounds(tile_min, tile_min + glm::dvec2(tile_w, tile_h));
+                tile_bounds.grow(tile_w / 4.0);
+
+                auto t0 = clock::now();
+                linear_count += find_triangles_linear(reference, tile_bounds).size();
+                auto t1 = clock::now();
+                std::vector<Triangle> found;
+                tile_maker.find_triangles(tile_bounds, found);
+                indexed_count += found.size();
+                auto t2 = clock::now();
+
+                linear_time += t1 - t0;
+                indexed_time += t2 - t1;
+            }
+        }
+
+        CHECK(linear_count == indexed_count);
+        TNTN_LOG_INFO("{} tiles, {} triangles: linear scan {:.3f}s, grid index {:.3f}s",
+                      tiles_per_axis * tiles_per_axis,
+                      reference.poly_count(),
+                      linear_time.count(),
+                      indexed_time.count());
+    }
+}
+
+} //namespace unittests
+} //namespace tntn
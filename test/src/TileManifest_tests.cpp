@@ -0,0 +1,78 @@
+#include "catch.hpp"
+
+#include "tntn/TileManifest.h"
+
+#include <memory>
+#include <string>
+
+namespace tntn {
+namespace unittests {
+
+TEST_CASE("TileManifest records and resumes finished partitions", "[tntn]")
+{
+    const std::string fingerprint = "size=1 mtime=2 hash=3 method=terra";
+    auto f = std::make_shared<MemoryFile>();
+
+    {
+        TileManifest manifest;
+        REQUIRE(manifest.start(f, fingerprint));
+        REQUIRE(manifest.mark_done(12, {10, 20}, {13, 23}));
+        REQUIRE(manifest.mark_done(11, {5, 10}, {6, 11}));
+        REQUIRE(manifest.mark_done(11, {5, 10}, {6, 11}));
+        CHECK(manifest.num_done() == 2);
+        CHECK(manifest.is_done(12, {10, 20}, {13, 23}));
+        CHECK_FALSE(manifest.is_done(12, {10, 20}, {13, 24}));
+    }
+
+    TileManifest resumed;
+    REQUIRE(resumed.load(*f, fingerprint));
+    CHECK(resumed.num_done() == 2);
+    CHECK(resumed.is_done(12, {10, 20}, {13, 23}));
+    CHECK(resumed.is_done(11, {5, 10}, {6, 11}));
+    CHECK_FALSE(resumed.is_done(10, {5, 10}, {6, 11}));
+
+    // the rewritten manifest contains the loaded partitions and the new ones
+    auto f2 = std::make_shared<MemoryFile>();
+    REQUIRE(resumed.start(f2, fingerprint));
+    REQUIRE(resumed.mark_done(10, {0, 0}, {3, 3}));
+
+    TileManifest resumed_again;
+    REQUIRE(resumed_again.load(*f2, fingerprint));
+    CHECK(resumed_again.num_done() == 3);
+    CHECK(resumed_again.is_done(10, {0, 0}, {3, 3}));
+}
+
+TEST_CASE("TileManifest rejects different fingerprints", "[tntn]")
+{
+    auto f = std::make_shared<MemoryFile>();
+    TileManifest manifest;
+    REQUIRE(manifest.start(f, "size=1 method=terra"));
+    REQUIRE(manifest.mark_done(3, {0, 0}, {1, 1}));
+
+    TileManifest other;
+    CHECK_FALSE(other.load(*f, "size=1 method=zemlya"));
+}
+
+TEST_CASE("TileManifest ignores an incomplete last line", "[tntn]")
+{
+    MemoryFile f;
+    const std::string contents =
+        "tntn-manifest 1 fp\n"
+        "done 5 1 2 3 4\n"
+        "done 5 4 4 5";
+    f.write(0, contents);
+
+    TileManifest manifest;
+    REQUIRE(manifest.load(f, "fp"));
+    CHECK(manifest.num_done() == 1);
+    CHECK(manifest.is_done(5, {1, 2}, {3, 4}));
+    CHECK_FALSE(manifest.is_done(5, {4, 4}, {5, 5}));
+
+    MemoryFile broken;
+    broken.write(0, std::string("tntn-manifest 1 fp\nsomething else\n"));
+    TileManifest broken_manifest;
+    CHECK_FALSE(broken_manifest.load(broken, "fp"));
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -0,0 +1,421 @@
+#include "catch.hpp"
+
+#include "tntn/WindowedRaster.h"
+#include "tntn/raster_tools.h"
+#include "tntn/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace tntn {
+namespace unittests {
+
+static RasterDouble make_test_raster(int width, int height)
+{
+    RasterDouble raster(width, height);
+    raster.set_pos_x(1000.5);
+    raster.set_pos_y(-200.25);
+    raster.set_cell_size(2.5);
+    raster.set_no_data_value(-9999);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(1, 100);
+    for(int r = 0; r < height; r++)
+    {
+        for(int c = 0; c < width; c++)
+        {
+            raster.value(r, c) = (r * 7 + c) % 11 == 0 ? -9999 : dist(rng);
+        }
+    }
+    return raster;
+}
+
+static void check_same_raster(const RasterDouble& a, const RasterDouble& b)
+{
+    REQUIRE(a.get_width() == b.get_width());
+    REQUIRE(a.get_height() == b.get_height());
+    CHECK(a.get_pos_x() == Approx(b.get_pos_x()));
+    CHECK(a.get_pos_y() == Approx(b.get_pos_y()));
+    CHECK(a.get_cell_size() == b.get_cell_size());
+    CHECK(a.get_no_data_value() == b.get_no_data_value());
+
+    bool all_equal = true;
+    for(unsigned int r = 0; r < a.get_height(); r++)
+    {
+        for(unsigned int c = 0; c < a.get_width(); c++)
+        {
+            all_equal = all_equal && a.value(r, c) == b.value(r, c);
+        }
+    }
+    CHECK(all_equal);
+}
+
+struct Window
+{
+    int x, y, w, h;
+};
+
+static const std::vector<Window> test_windows = {
+    {0, 0, 37, 29}, {5, 3, 10, 8}, {30, 20, 20, 20}, {-4, -3, 12, 9}, {12, 7, 1, 1}};
+
+// in memory raster stored in blocks, mirrored like a GDAL dataset with flipped geotransform
+class TestBlockRaster : public BlockCachedWindowedRaster
+{
+  public:
+    TestBlockRaster(const RasterDouble& raster,
+                    int block_width,
+                    int block_height,
+                    bool flip_x,
+                    bool flip_y,
+                    size_t cache_budget) :
+        m_raster(raster),
+        m_flip_x(flip_x),
+        m_flip_y(flip_y)
+    {
+        set_geometry(raster.get_width(),
+                     raster.get_height(),
+                     raster.get_pos_x(),
+                     raster.get_pos_y(),
+                     raster.get_cell_size(),
+                     raster.get_no_data_value());
+        set_block_layout(block_width, block_height, flip_x, flip_y);
+        set_cache_budget(cache_budget);
+    }
+
+    std::atomic<int> block_reads{0};
+
+  protected:
+    bool read_block(int x, int y, int w, int h, double* dst) override
+    {
+        block_reads++;
+        const int width = m_raster.get_width();
+        const int height = m_raster.get_height();
+        for(int r = 0; r < h; r++)
+        {
+            for(int c = 0; c < w; c++)
+            {
+                const int row = m_flip_y ? height - 1 - (y + r) : y + r;
+                const int col = m_flip_x ? width - 1 - (x + c) : x + c;
+                dst[r * w + c] = m_raster.value(row, col);
+            }
+        }
+        return true;
+    }
+
+  private:
+    const RasterDouble& m_raster;
+    bool m_flip_x;
+    bool m_flip_y;
+};
+
+// block raster whose reads take a while, remembers how many ran at the same time
+class SlowBlockRaster : public TestBlockRaster
+{
+  public:
+    SlowBlockRaster(const RasterDouble& raster, int block_width, int block_height) :
+        TestBlockRaster(raster, block_width, block_height, false, false, 1 << 20)
+    {
+    }
+
+    std::atomic<int> max_concurrent_reads{0};
+
+  protected:
+    bool read_block(int x, int y, int w, int h, double* dst) override
+    {
+        const int concurrent = ++m_running_reads;
+        int max_reads = max_concurrent_reads.load();
+        while(concurrent > max_reads &&
+              !max_concurrent_reads.compare_exchange_weak(max_reads, concurrent))
+        {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const bool ok = TestBlockRaster::read_block(x, y, w, h, dst);
+        m_running_reads--;
+        return ok;
+    }
+
+  private:
+    std::atomic<int> m_running_reads{0};
+};
+
+// block raster of a single precision source, its samples must be exact floats
+class FloatBlockRaster : public TestBlockRaster
+{
+  public:
+    FloatBlockRaster(const RasterDouble& raster,
+                     int block_width,
+                     int block_height,
+                     bool flip_x,
+                     bool flip_y,
+                     size_t cache_budget) :
+        TestBlockRaster(raster, block_width, block_height, flip_x, flip_y, cache_budget)
+    {
+        set_single_precision(true);
+    }
+
+    std::atomic<int> double_block_reads{0};
+
+  protected:
+    bool read_block(int x, int y, int w, int h, double* dst) override
+    {
+        double_block_reads++;
+        return TestBlockRaster::read_block(x, y, w, h, dst);
+    }
+
+    bool read_block_float(int x, int y, int w, int h, float* dst) override
+    {
+        std::vector<double> pixels(static_cast<size_t>(w) * h);
+        const bool ok = TestBlockRaster::read_block(x, y, w, h, pixels.data());
+        std::copy(pixels.begin(), pixels.end(), dst);
+        return ok;
+    }
+};
+
+TEST_CASE("MemoryWindowedRaster crop matches Raster::crop", "[tntn]")
+{
+    const RasterDouble raster = make_test_raster(37, 29);
+    MemoryWindowedRaster windowed(raster);
+
+    CHECK(windowed.get_bounding_box().min.x == raster.get_bounding_box().min.x);
+    CHECK(windowed.get_bounding_box().max.y == raster.get_bounding_box().max.y);
+    CHECK(windowed.x2col(1030.0) == raster.x2col(1030.0));
+    CHECK(windowed.y2row(-180.0) == raster.y2row(-180.0));
+
+    for(const auto& win : test_windows)
+    {
+        RasterDouble expected;
+        raster.crop(win.x, win.y, win.w, win.h, expected);
+        RasterDouble actual;
+        REQUIRE(windowed.crop(win.x, win.y, win.w, win.h, actual));
+        check_same_raster(actual, expected);
+    }
+}
+
+TEST_CASE("MemoryWindowedRasterFloat crops single precision rasters", "[tntn]")
+{
+    const RasterFloat raster = make_test_raster(37, 29).convert<float>();
+    MemoryWindowedRasterFloat windowed(raster);
+    CHECK(windowed.is_single_precision());
+    CHECK_FALSE(MemoryWindowedRaster(make_test_raster(4, 4)).is_single_precision());
+
+    for(const auto& win : test_windows)
+    {
+        RasterFloat expected;
+        raster.crop(win.x, win.y, win.w, win.h, expected);
+        RasterFloat actual_float;
+        REQUIRE(windowed.crop(win.x, win.y, win.w, win.h, actual_float));
+        check_same_raster(actual_float.convert<double>(), expected.convert<double>());
+
+        // widening the samples loses nothing
+        RasterDouble actual_double;
+        REQUIRE(windowed.crop(win.x, win.y, win.w, win.h, actual_double));
+        check_same_raster(actual_double, expected.convert<double>());
+    }
+}
+
+TEST_CASE("BlockCachedWindowedRaster crop matches Raster::crop", "[tntn]")
+{
+    const RasterDouble raster = make_test_raster(37, 29);
+
+    for(int flip = 0; flip < 4; flip++)
+    {
+        TestBlockRaster windowed(raster, 8, 5, flip & 1, flip & 2, 1 << 20);
+
+        for(const auto& win : test_windows)
+        {
+            RasterDouble expected;
+            raster.crop(win.x, win.y, win.w, win.h, expected);
+            RasterDouble actual;
+            REQUIRE(windowed.crop(win.x, win.y, win.w, win.h, actual));
+            check_same_raster(actual, expected);
+        }
+    }
+}
+
+TEST_CASE("BlockCachedWindowedRaster reuses and evicts blocks", "[tntn]")
+{
+    const RasterDouble raster = make_test_raster(40, 20);
+    const size_t block_bytes = 10 * 10 * sizeof(double);
+
+    // room for two of the eight blocks
+    TestBlockRaster windowed(raster, 10, 10, false, false, 2 * block_bytes);
+    RasterDouble out;
+
+    REQUIRE(windowed.crop(0, 0, 20, 10, out));
+    CHECK(windowed.block_reads.load() == 2);
+    CHECK(windowed.cache_misses() == 2);
+
+    // both blocks are cached
+    REQUIRE(windowed.crop(5, 2, 10, 5, out));
+    CHECK(windowed.block_reads.load() == 2);
+    CHECK(windowed.cache_hits() == 2);
+
+    // reads block (2,0) and evicts the least recently used (0,0)
+    REQUIRE(windowed.crop(25, 0, 5, 5, out));
+    CHECK(windowed.block_reads.load() == 3);
+
+    REQUIRE(windowed.crop(12, 0, 5, 5, out));
+    CHECK(windowed.block_reads.load() == 3);
+
+    REQUIRE(windowed.crop(0, 0, 5, 5, out));
+    CHECK(windowed.block_reads.load() == 4);
+
+    RasterDouble expected;
+    raster.crop(0, 0, 5, 5, expected);
+    check_same_raster(out, expected);
+}
+
+TEST_CASE("BlockCachedWindowedRaster keeps single precision blocks as floats", "[tntn]")
+{
+    RasterDouble raster = make_test_raster(40, 20);
+    for(unsigned int r = 0; r < raster.get_height(); r++)
+    {
+        for(unsigned int c = 0; c < raster.get_width(); c++)
+        {
+            raster.value(r, c) = static_cast<float>(raster.value(r, c));
+        }
+    }
+
+    // room for all eight blocks as floats, only for four of them as doubles
+    const size_t block_bytes = 10 * 10 * sizeof(float);
+    FloatBlockRaster windowed(raster, 10, 10, true, false, 8 * block_bytes);
+
+    RasterFloat out_float;
+    REQUIRE(windowed.crop(0, 0, 40, 20, out_float));
+    CHECK(windowed.block_reads.load() == 8);
+
+    RasterDouble out;
+    REQUIRE(windowed.crop(-3, 2, 30, 30, out));
+    CHECK(windowed.block_reads.load() == 8);
+    CHECK(windowed.double_block_reads.load() == 0);
+
+    RasterDouble expected;
+    raster.crop(-3, 2, 30, 30, expected);
+    check_same_raster(out, expected);
+
+    bool all_equal = true;
+    for(unsigned int r = 0; r < raster.get_height(); r++)
+    {
+        for(unsigned int c = 0; c < raster.get_width(); c++)
+        {
+            all_equal = all_equal && out_float.value(r, c) == raster.value(r, c);
+        }
+    }
+    CHECK(all_equal);
+}
+
+TEST_CASE("BlockCachedWindowedRaster reads different blocks concurrently", "[tntn]")
+{
+    const RasterDouble raster = make_test_raster(40, 20);
+    SlowBlockRaster windowed(raster, 10, 10);
+
+    // two crops of each of the four blocks of the first row
+    ThreadPool thread_pool(4);
+    REQUIRE(thread_pool.parallel_for(8, [&](size_t i) {
+        RasterDouble out;
+        return windowed.crop(static_cast<int>(i % 4) * 10, 0, 10, 10, out);
+    }));
+
+    // a block being read is waited for instead of read again
+    CHECK(windowed.block_reads.load() == 4);
+    CHECK(windowed.max_concurrent_reads.load() > 1);
+}
+
+TEST_CASE("DownsampledWindowedRaster matches integer_downsample_mean", "[tntn]")
+{
+    const RasterDouble raster = make_test_raster(37, 29);
+    auto source = std::make_shared<TestBlockRaster>(raster, 8, 8, false, true, 1 << 20);
+
+    for(int window_size : {2, 4})
+    {
+        const RasterDouble downsampled =
+            raster_tools::integer_downsample_mean(raster, window_size);
+        DownsampledWindowedRaster windowed(source, window_size);
+
+        REQUIRE(windowed.get_width() == downsampled.get_width());
+        REQUIRE(windowed.get_height() == downsampled.get_height());
+        CHECK(windowed.get_cell_size() == downsampled.get_cell_size());
+
+        const int w = downsampled.get_width();
+        const int h = downsampled.get_height();
+        for(const auto& win : std::vector<Window>{{0, 0, w, h}, {1, 2, 3, 2}, {-1, -1, w, h}})
+        {
+            RasterDouble expected;
+            downsampled.crop(win.x, win.y, win.w, win.h, expected);
+            RasterDouble actual;
+            REQUIRE(windowed.crop(win.x, win.y, win.w, win.h, actual));
+            check_same_raster(actual, expected);
+        }
+    }
+}
+
+// in memory raster that remembers the largest window read from it
+class RecordingWindowedRaster : public MemoryWindowedRaster
+{
+  public:
+    using MemoryWindowedRaster::MemoryWindowedRaster;
+
+    size_t max_read_pixels = 0;
+
+  protected:
+    bool read(int x, int y, int w, int h, double* dst) override
+    {
+        max_read_pixels = std::max(max_read_pixels, static_cast<size_t>(w) * h);
+        return MemoryWindowedRaster::read(x, y, w, h, dst);
+    }
+};
+
+TEST_CASE("DownsampledWindowedRaster reads large windows in strips", "[tntn]")
+{
+    const RasterDouble raster = make_test_raster(2048, 2048);
+    auto source = std::make_shared<RecordingWindowedRaster>(raster);
+
+    const int window_size = 1024;
+    const RasterDouble downsampled = raster_tools::integer_downsample_mean(raster, window_size);
+    DownsampledWindowedRaster windowed(source, window_size);
+
+    RasterDouble actual;
+    REQUIRE(windowed.crop(0, 0, 2, 2, actual));
+    check_same_raster(actual, downsampled);
+
+    // a strip holds at most 1M pixels instead of all source rows of an output row
+    CHECK(source->max_read_pixels <= (1 << 20));
+}
+
+TEST_CASE("find_changed_region", "[tntn]")
+{
+    const RasterDouble raster = make_test_raster(37, 300);
+    RasterDouble changed = raster.clone();
+    changed.value(260, 4) += 1;
+    changed.value(270, 9) = changed.get_no_data_value();
+    changed.value(280, 6) += 1;
+
+    MemoryWindowedRaster a(raster);
+    MemoryWindowedRaster b(changed);
+
+    BBox2D region;
+    REQUIRE(find_changed_region(a, b, region));
+
+    // columns 4..9, rows 260..280 counted from the top
+    const double cs = raster.get_cell_size();
+    CHECK(region.min.x == Approx(raster.get_pos_x() + 4 * cs));
+    CHECK(region.max.x == Approx(raster.get_pos_x() + 10 * cs));
+    CHECK(region.min.y == Approx(raster.get_pos_y() + (300 - 281) * cs));
+    CHECK(region.max.y == Approx(raster.get_pos_y() + (300 - 260) * cs));
+
+    MemoryWindowedRaster a2(raster);
+    REQUIRE(find_changed_region(a, a2, region));
+    CHECK(region.min.x > region.max.x);
+
+    const RasterDouble smaller = make_test_raster(36, 300);
+    MemoryWindowedRaster c(smaller);
+    CHECK_FALSE(find_changed_region(a, c, region));
+}
+
+} // namespace unittests
+} // namespace tntn
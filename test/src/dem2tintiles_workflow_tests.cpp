@@ -0,0 +1,273 @@
+#include "catch.hpp"
+
+#include "tntn/dem2tintiles_workflow.h"
+#include "tntn/MeshWriter.h"
+#include "tntn/RasterOverviews.h"
+#include "tntn/TileArchive.h"
+#include "tntn/TileAvailability.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace tntn {
+namespace unittests {
+
+TEST_CASE("dirty_region_filter selects partitions overlapping the region", "[tntn]")
+{
+    RasterDouble raster(3000, 2000);
+    raster.set_pos_x(1000000);
+    raster.set_pos_y(5000000);
+    raster.set_cell_size(10);
+    MemoryWindowedRaster dem(raster);
+
+    const int zoom = 14;
+    const auto partitions = create_partitions_for_zoom_level(dem, zoom);
+    REQUIRE(partitions.size() > 4);
+
+    // a small change in the middle of the raster
+    const BBox2D region(glm::dvec2(1015000, 5010000), glm::dvec2(1015050, 5010030));
+    const auto filter = dirty_region_filter(region);
+
+    int selected = 0;
+    for(const auto& part : partitions)
+    {
+        const bool overlaps = part.bbox.max.x >= region.min.x - 20 &&
+            part.bbox.min.x <= region.max.x + 20 && part.bbox.max.y >= region.min.y - 20 &&
+            part.bbox.min.y <= region.max.y + 20;
+        CHECK(filter(part, zoom, dem.get_cell_size()) == overlaps);
+        selected += overlaps ? 1 : 0;
+    }
+    CHECK(selected > 0);
+    CHECK(selected < partitions.size());
+
+    BBox2D nothing;
+    const auto empty_filter = dirty_region_filter(nothing);
+    for(const auto& part : partitions)
+    {
+        CHECK_FALSE(empty_filter(part, zoom, dem.get_cell_size()));
+    }
+}
+
+static std::unique_ptr<RasterDouble> make_hills(const int size)
+{
+    auto raster = std::make_unique<RasterDouble>(size, size);
+    raster->set_pos_x(1000000);
+    raster->set_pos_y(5000000);
+    raster->set_cell_size(30);
+    for(int r = 0; r < size; r++)
+    {
+        double* row = raster->get_ptr(r);
+        for(int c = 0; c < size; c++)
+        {
+            row[c] = 100 + 40 * std::sin(r * 0.05) * std::cos(c * 0.03) +
+                5 * std::sin(r * c * 1e-3);
+        }
+    }
+    return raster;
+}
+
+static const int hills_size = 600;
+static const int hills_zoom = 12;
+
+static void create_hills_tiles(const int num_threads,
+                               const int terra_block_size,
+                               ThreadPool* thread_pool,
+                               std::shared_ptr<MemoryFile>& archive_file,
+                               TileAvailability& availability)
+{
+    RasterOverviews overviews(make_hills(hills_size), hills_zoom, hills_zoom);
+    archive_file = std::make_shared<MemoryFile>();
+    TileArchiveWriter archive;
+    REQUIRE(archive.open(archive_file));
+
+    QuantizedMeshWriter writer;
+    REQUIRE(create_tiles_pipelined(overviews,
+                                   "",
+                                   2.0,
+                                   "terra",
+                                   writer,
+                                   num_threads,
+                                   8,
+                                   &archive,
+                                   nullptr,
+                                   {},
+                                   &availability,
+                                   terra_block_size,
+                                   thread_pool));
+    REQUIRE(archive.finish());
+}
+
+static void check_same_tiles(const int terra_block_size)
+{
+    std::shared_ptr<MemoryFile> single_file;
+    std::shared_ptr<MemoryFile> multi_file;
+    TileAvailability single_availability;
+    TileAvailability multi_availability;
+    // the pool's workers help the two meshing threads with their blocks
+    ThreadPool thread_pool(3);
+    create_hills_tiles(1, terra_block_size, nullptr, single_file, single_availability);
+    create_hills_tiles(2, terra_block_size, &thread_pool, multi_file, multi_availability);
+
+    REQUIRE(single_availability.num_tiles() > 0);
+    REQUIRE(single_availability.num_tiles() == multi_availability.num_tiles());
+
+    TileArchiveReader single;
+    TileArchiveReader multi;
+    REQUIRE(single.open(single_file->data(), single_file->size()));
+    REQUIRE(multi.open(multi_file->data(), multi_file->size()));
+    for(const TileRange& r : single_availability.ranges(hills_zoom))
+    {
+        for(int ty = r.start_y; ty <= r.end_y; ty++)
+        {
+            for(int tx = r.start_x; tx <= r.end_x; tx++)
+            {
+                const unsigned char* single_data = nullptr;
+                const unsigned char* multi_data = nullptr;
+                size_t single_size = 0;
+                size_t multi_size = 0;
+                REQUIRE(single.get_tile(hills_zoom, tx, ty, single_data, single_size));
+                REQUIRE(multi.get_tile(hills_zoom, tx, ty, multi_data, multi_size));
+                REQUIRE(single_size == multi_size);
+                CHECK(std::memcmp(single_data, multi_data, single_size) == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("create_tiles_pipelined writes the same tiles for any number of threads", "[tntn]")
+{
+    SECTION("plain terra")
+    {
+        check_same_tiles(0);
+    }
+
+    SECTION("terra in blocks")
+    {
+        // the partitions must be large enough for terra to mesh them in blocks
+        RasterOverviews overviews(make_hills(hills_size), hills_zoom, hills_zoom);
+        RasterOverview overview;
+        REQUIRE(overviews.next(overview));
+        const auto partitions = create_partitions_for_zoom_level(*overview.raster, hills_zoom);
+        REQUIRE(!partitions.empty());
+        const double cell_size = overview.raster->get_cell_size();
+        CHECK(overview.raster->get_width() > 2 * 256);
+        CHECK((partitions[0].bbox.max.x - partitions[0].bbox.min.x) / cell_size > 2 * 256);
+
+        check_same_tiles(256);
+    }
+}
+
+TEST_CASE("an update removes the tiles of a region set to no data", "[tntn]")
+{
+    namespace fs = boost::filesystem;
+
+    const int zoom = 12;
+    auto raster = std::make_unique<RasterDouble>(3000, 300);
+    raster->set_pos_x(1000000);
+    raster->set_pos_y(5000000);
+    raster->set_cell_size(30);
+    raster->set_no_data_value(-9999);
+    for(unsigned int r = 0; r < raster->get_height(); r++)
+    {
+        for(unsigned int c = 0; c < raster->get_width(); c++)
+        {
+            raster->value(r, c) = 100 + 20 * std::sin(r * 0.05) * std::cos(c * 0.03);
+        }
+    }
+
+    const fs::path output_dir = fs::temp_directory_path() / fs::unique_path();
+    QuantizedMeshWriter writer;
+    TileAvailability availability;
+    {
+        RasterOverviews overviews(std::make_unique<RasterDouble>(raster->clone()), zoom, zoom);
+        REQUIRE(create_tiles_pipelined(overviews,
+                                       output_dir.string(),
+                                       2.0,
+                                       "terra",
+                                       writer,
+                                       2,
+                                       8,
+                                       nullptr,
+                                       nullptr,
+                                       {},
+                                       &availability));
+    }
+
+    // the first partition's window becomes no data
+    Partition removed;
+    {
+        RasterOverviews overviews(std::make_unique<RasterDouble>(raster->clone()), zoom, zoom);
+        RasterOverview overview;
+        REQUIRE(overviews.next(overview));
+        const auto partitions = create_partitions_for_zoom_level(*overview.raster, zoom);
+        REQUIRE(partitions.size() > 1);
+        removed = partitions[0];
+    }
+    BBox2D region(removed.bbox.min, removed.bbox.max);
+    region.grow(100);
+    for(unsigned int r = 0; r < raster->get_height(); r++)
+    {
+        for(unsigned int c = 0; c < raster->get_width(); c++)
+        {
+            if(region.contains(glm::dvec2(raster->col2x(c), raster->row2y(r))))
+            {
+                raster->value(r, c) = -9999;
+            }
+        }
+    }
+
+    auto tile_path = [&](int tx, int ty) {
+        return output_dir / std::to_string(zoom) / std::to_string(tx) /
+            (std::to_string(ty) + ".terrain");
+    };
+    int removed_tiles = 0;
+    for(int tx = removed.tmin.x; tx <= removed.tmax.x; tx++)
+    {
+        for(int ty = removed.tmin.y; ty <= removed.tmax.y; ty++)
+        {
+            removed_tiles += availability.has_tile(zoom, tx, ty) ? 1 : 0;
+        }
+    }
+    REQUIRE(removed_tiles > 0);
+    const size_t num_tiles = availability.num_tiles();
+    REQUIRE(num_tiles > removed_tiles);
+
+    {
+        RasterOverviews overviews(std::move(raster), zoom, zoom);
+        REQUIRE(create_tiles_pipelined(overviews,
+                                       output_dir.string(),
+                                       2.0,
+                                       "terra",
+                                       writer,
+                                       2,
+                                       8,
+                                       nullptr,
+                                       nullptr,
+                                       dirty_region_filter(region),
+                                       &availability));
+    }
+
+    for(int tx = removed.tmin.x; tx <= removed.tmax.x; tx++)
+    {
+        for(int ty = removed.tmin.y; ty <= removed.tmax.y; ty++)
+        {
+            CHECK(!availability.has_tile(zoom, tx, ty));
+            CHECK(!fs::exists(tile_path(tx, ty)));
+        }
+    }
+    // the tiles of the other partitions are still there
+    CHECK(availability.num_tiles() == num_tiles - removed_tiles);
+    for(const TileRange& r : availability.ranges(zoom))
+    {
+        CHECK(fs::exists(tile_path(r.start_x, r.start_y)));
+        CHECK(fs::exists(tile_path(r.end_x, r.end_y)));
+    }
+
+    fs::remove_all(output_dir);
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include <random>
+
+#include "tntn/gzip.h"
+#include "tntn/MeshWriter.h"
+#include "tntn/File.h"
+
+namespace tntn {
+namespace unittests {
+
+TEST_CASE("gzip round trip", "[tntn]")
+{
+    std::mt19937 generator(42); //fixed seed
+    std::uniform_int_distribution<int> small(0, 15);
+
+    // compressible but not trivial
+    std::vector<unsigned char> data(100000);
+    for(auto& c : data)
+    {
+        c = static_cast<unsigned char>(small(generator));
+    }
+
+    std::vector<unsigned char> compressed;
+    REQUIRE(gzip_compress(data.data(), data.size(), compressed));
+    CHECK(is_gzip(compressed.data(), compressed.size()));
+    CHECK(compressed.size() < data.size());
+
+    std::vector<unsigned char> decompressed;
+    REQUIRE(gzip_decompress(compressed.data(), compressed.size(), decompressed));
+    CHECK(decompressed == data);
+}
+
+TEST_CASE("gzip round trip of empty buffer", "[tntn]")
+{
+    std::vector<unsigned char> compressed;
+    REQUIRE(gzip_compress(nullptr, 0, compressed));
+    CHECK(is_gzip(compressed.data(), compressed.size()));
+
+    std::vector<unsigned char> decompressed;
+    REQUIRE(gzip_decompress(compressed.data(), compressed.size(), decompressed));
+    CHECK(decompressed.empty());
+}
+
+TEST_CASE("gzip_decompress fails on truncated or invalid input", "[tntn]")
+{
+    const std::string text(1000, 'x');
+    std::vector<unsigned char> compressed;
+    REQUIRE(gzip_compress(reinterpret_cast<const unsigned char*>(text.data()),
+                          text.size(),
+                          compressed));
+
+    std::vector<unsigned char> out;
+    CHECK(!gzip_decompress(compressed.data(), compressed.size() / 2, out));
+
+    const unsigned char garbage[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    CHECK(!is_gzip(garbage, sizeof(garbage)));
+    CHECK(!gzip_decompress(garbage, sizeof(garbage), out));
+}
+
+TEST_CASE("QuantizedMeshWriter gzip output decompresses to the plain tile", "[tntn]")
+{
+    Mesh mesh;
+    std::vector<Vertex> vertices = {{0, 0, 0}, {1, 0, 0.5}, {0, 1, 0.25}, {1, 1, 1}};
+    std::vector<Face> faces = {{{0, 1, 3}}, {{0, 3, 2}}};
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+
+    const BBox3D bbox(glm::dvec3(0, 0, 0), glm::dvec3(1, 1, 1));
+
+    auto plain = std::make_shared<MemoryFile>();
+    REQUIRE(QuantizedMeshWriter().write_mesh(plain, mesh, bbox));
+    auto gzipped = std::make_shared<MemoryFile>();
+    REQUIRE(QuantizedMeshWriter(false, 9).write_mesh(gzipped, mesh, bbox));
+
+    std::vector<unsigned char> plain_bytes;
+    plain->read(0, plain_bytes, plain->size());
+    std::vector<unsigned char> gzipped_bytes;
+    gzipped->read(0, gzipped_bytes, gzipped->size());
+
+    REQUIRE(is_gzip(gzipped_bytes.data(), gzipped_bytes.size()));
+    std::vector<unsigned char> decompressed;
+    REQUIRE(gzip_decompress(gzipped_bytes.data(), gzipped_bytes.size(), decompressed));
+    CHECK(decompressed == plain_bytes);
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -0,0 +1,238 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+
+#include "tntn/mesh_optimization.h"
+#include "tntn/MeshWriter.h"
+#include "tntn/File.h"
+#include "tntn/logging.h"
+
+namespace tntn {
+namespace unittests {
+
+// a regular grid of n*n vertices with vertices and faces in random order
+static void make_shuffled_grid(const int n, std::vector<Vertex>& vertices, std::vector<Face>& faces)
+{
+    std::mt19937 generator(42); //fixed seed
+
+    std::vector<size_t> slot(n * n);
+    for(size_t i = 0; i < slot.size(); i++)
+    {
+        slot[i] = i;
+    }
+    std::shuffle(slot.begin(), slot.end(), generator);
+
+    vertices.resize(n * n);
+    for(int y = 0; y < n; y++)
+    {
+        for(int x = 0; x < n; x++)
+        {
+            const double z = 0.5 + 0.5 * std::sin(x * 0.05) * std::cos(y * 0.07);
+            vertices[slot[y * n + x]] = {x / (n - 1.0), y / (n - 1.0), z};
+        }
+    }
+
+    faces.clear();
+    for(int y = 0; y + 1 < n; y++)
+    {
+        for(int x = 0; x + 1 < n; x++)
+        {
+            const size_t a = slot[y * n + x];
+            const size_t b = slot[y * n + x + 1];
+            const size_t c = slot[(y + 1) * n + x];
+            const size_t d = slot[(y + 1) * n + x + 1];
+            faces.push_back({{a, b, d}});
+            faces.push_back({{a, d, c}});
+        }
+    }
+    std::shuffle(faces.begin(), faces.end(), generator);
+}
+
+// rotates each face to start with its smallest index, keeping the winding
+static std::vector<std::array<VertexIndex, 3>> canonical_faces(const std::vector<Face>& faces)
+{
+    std::vector<std::array<VertexIndex, 3>> out;
+    out.reserve(faces.size());
+    for(const Face& f : faces)
+    {
+        int first = 0;
+        for(int k = 1; k < 3; k++)
+        {
+            if(f[k] < f[first])
+            {
+                first = k;
+            }
+        }
+        out.push_back({{f[first], f[(first + 1) % 3], f[(first + 2) % 3]}});
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+TEST_CASE("average_cache_miss_ratio on simple cases", "[tntn]")
+{
+    CHECK(average_cache_miss_ratio({}, 0) == 0);
+
+    // two faces sharing an edge load 4 vertices
+    const std::vector<Face> quad = {{{0, 1, 2}}, {{2, 1, 3}}};
+    CHECK(average_cache_miss_ratio(quad, 4) == Approx(2.0));
+
+    // with a cache of 3 entries the shared vertices are evicted in between
+    const std::vector<Face> fan = {{{0, 1, 2}}, {{0, 2, 3}}, {{0, 3, 4}}};
+    CHECK(average_cache_miss_ratio(fan, 5, 16) == Approx(5.0 / 3.0));
+    CHECK(average_cache_miss_ratio(fan, 5, 3) == Approx(6.0 / 3.0));
+}
+
+TEST_CASE("optimize_vertex_cache lowers ACMR and keeps faces", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_shuffled_grid(60, vertices, faces);
+
+    const auto faces_before = canonical_faces(faces);
+    const double acmr_before = average_cache_miss_ratio(faces, vertices.size());
+
+    optimize_vertex_cache(faces, vertices.size());
+    const double acmr_after = average_cache_miss_ratio(faces, vertices.size());
+
+    CHECK(acmr_before > 2.5);
+    CHECK(acmr_after < 0.9);
+    CHECK(canonical_faces(faces) == faces_before);
+}
+
+TEST_CASE("reorder_vertices_by_first_use numbers vertices in face order", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_shuffled_grid(20, vertices, faces);
+
+    Mesh original;
+    original.from_decomposed(std::vector<Vertex>(vertices), std::vector<Face>(faces));
+
+    reorder_vertices_by_first_use(vertices, faces);
+
+    VertexIndex next = 0;
+    for(const Face& f : faces)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            REQUIRE(f[k] <= next);
+            if(f[k] == next)
+            {
+                next++;
+            }
+        }
+    }
+    CHECK(next == vertices.size());
+
+    Mesh reordered;
+    reordered.from_decomposed(std::move(vertices), std::move(faces));
+    CHECK(reordered.semantic_equal(original));
+}
+
+TEST_CASE("optimize_mesh_for_vertex_cache keeps triangle meshes equal", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_shuffled_grid(30, vertices, faces);
+
+    Mesh original;
+    original.from_decomposed(std::move(vertices), std::move(faces));
+    original.generate_triangles();
+
+    std::vector<Triangle> triangles;
+    original.grab_triangles(triangles);
+    original.from_triangles(std::vector<Triangle>(triangles));
+
+    Mesh optimized;
+    optimized.from_triangles(std::move(triangles));
+    optimize_mesh_for_vertex_cache(optimized);
+
+    CHECK(optimized.has_decomposed());
+    CHECK(!optimized.has_triangles());
+    CHECK(optimized.semantic_equal(original));
+}
+
+TEST_CASE("optimize_mesh_for_vertex_cache keeps vertex normals with their vertices", "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_shuffled_grid(20, vertices, faces);
+
+    // the normal encodes the position of its vertex
+    std::vector<Normal> normals(vertices.begin(), vertices.end());
+
+    Mesh mesh;
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+    mesh.set_normals(std::move(normals));
+    optimize_mesh_for_vertex_cache(mesh);
+
+    REQUIRE(mesh.has_normals());
+    const auto optimized_vertices = mesh.vertices();
+    for(size_t i = 0; i < optimized_vertices.distance(); i++)
+    {
+        CHECK(mesh.normals().begin[i] == optimized_vertices.begin[i]);
+    }
+}
+
+TEST_CASE("QuantizedMeshWriter with triangle order optimization does not grow tiles",
+          "[tntn]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_shuffled_grid(50, vertices, faces);
+
+    const BBox3D bbox(glm::dvec3(0, 0, 0), glm::dvec3(1, 1, 1));
+
+    Mesh plain;
+    plain.from_decomposed(std::vector<Vertex>(vertices), std::vector<Face>(faces));
+    Mesh optimized;
+    optimized.from_decomposed(std::move(vertices), std::move(faces));
+
+    auto plain_file = std::make_shared<MemoryFile>();
+    REQUIRE(QuantizedMeshWriter().write_mesh(plain_file, plain, bbox));
+    auto optimized_file = std::make_shared<MemoryFile>();
+    REQUIRE(QuantizedMeshWriter(true).write_mesh(optimized_file, optimized, bbox));
+
+    CHECK(optimized_file->size() <= plain_file->size());
+}
+
+TEST_CASE("optimize_mesh_for_vertex_cache benchmark", "[.][benchmark]")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    make_shuffled_grid(255, vertices, faces);
+
+    const double acmr_before = average_cache_miss_ratio(faces, vertices.size());
+    const BBox3D bbox(glm::dvec3(0, 0, 0), glm::dvec3(1, 1, 1));
+
+    Mesh plain;
+    plain.from_decomposed(std::vector<Vertex>(vertices), std::vector<Face>(faces));
+    auto plain_file = std::make_shared<MemoryFile>();
+    REQUIRE(QuantizedMeshWriter().write_mesh(plain_file, plain, bbox));
+
+    const auto start = std::chrono::steady_clock::now();
+    optimize_vertex_cache(faces, vertices.size());
+    reorder_vertices_by_first_use(vertices, faces);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double acmr_after = average_cache_miss_ratio(faces, vertices.size());
+
+    Mesh optimized;
+    optimized.from_decomposed(std::move(vertices), std::move(faces));
+    auto optimized_file = std::make_shared<MemoryFile>();
+    REQUIRE(QuantizedMeshWriter().write_mesh(optimized_file, optimized, bbox));
+
+    TNTN_LOG_INFO("ACMR {:.3f} -> {:.3f}, tile size {} -> {} bytes, optimized in {:.3f}s",
+                  acmr_before,
+                  acmr_after,
+                  plain_file->size(),
+                  optimized_file->size(),
+                  elapsed.count());
+}
+
+} // namespace unittests
+} // namespace tntn
@@ -2,6 +2,9 @@
 
 #include "tntn/raster_tools.h"
 #include "tntn/Raster.h"
+#include "tntn/ThreadPool.h"
+
+#include <cmath>
 
 namespace tntn {
 namespace unittests {
@@ -28,5 +31,61 @@ TEST_CASE("sample_nearest_valid_avg works", "[tntn]")
     CHECK(avg_sample == (3 + 6 + 12 + 24) / 4.0);
 }
 
+TEST_CASE("downsample_mean_2x2 cascade matches integer_downsample_mean", "[tntn]")
+{
+    const int w = 203;
+    const int h = 150;
+
+    RasterDouble raster;
+    raster.allocate(w, h);
+    raster.set_no_data_value(-99999);
+    raster.set_cell_size(2.5);
+
+    for(int r = 0; r < h; r++)
+    {
+        for(int c = 0; c < w; c++)
+        {
+            // strictly positive heights with scattered holes and one empty block
+            const bool hole = (r * 7 + c * 13) % 11 == 0 || (r < 16 && c < 16);
+            raster.value(r, c) = hole ? raster.get_no_data_value()
+                                      : 100 + 50 * std::sin(r * 0.1) * std::cos(c * 0.07);
+        }
+    }
+
+    ThreadPool thread_pool(3);
+    for(ThreadPool* pool : {(ThreadPool*)nullptr, &thread_pool})
+    {
+        Raster<uint32_t> weights;
+        RasterDouble level = raster.clone();
+
+        for(int window = 2; window <= 16; window *= 2)
+        {
+            level = raster_tools::downsample_mean_2x2(level, weights, pool);
+            const RasterDouble expected = raster_tools::integer_downsample_mean(raster, window);
+
+            REQUIRE(level.get_width() == expected.get_width());
+            REQUIRE(level.get_height() == expected.get_height());
+            REQUIRE(weights.get_width() == level.get_width());
+            CHECK(level.get_cell_size() == expected.get_cell_size());
+
+            for(unsigned int r = 0; r < level.get_height(); r++)
+            {
+                for(unsigned int c = 0; c < level.get_width(); c++)
+                {
+                    if(expected.value(r, c) == expected.get_no_data_value())
+                    {
+                        CHECK(level.value(r, c) == level.get_no_data_value());
+                        CHECK(weights.value(r, c) == 0);
+                    }
+                    else
+                    {
+                        CHECK(level.value(r, c) == Approx(expected.value(r, c)));
+                    }
+                }
+            }
+        }
+    }
+}
+
 } // namespace unittests
 } // namespace tntn
@@ -5,9 +5,12 @@
 #include <random>
 
 #include "tntn/TerraMesh.h"
+#include "tntn/TerraUtils.h"
+#include "tntn/ZemlyaMesh.h"
 #include "tntn/geometrix.h"
 #include "tntn/SurfacePoints.h"
 #include "tntn/terra_meshing.h"
+#include "tntn/zemlya_meshing.h"
 #include "tntn/MeshIO.h"
 
 namespace tntn {
@@ -23,6 +26,276 @@ TEST_CASE("terra ccw works", "[tntn]")
     CHECK(!terra::ccw(a, c, b));
 }
 
+TEST_CASE("terra CandidateList keeps one candidate per triangle", "[tntn]")
+{
+    auto pool = ObjPool<terra::DelaunayTriangle>::create();
+    std::vector<terra::dt_ptr> triangles;
+    for(int i = 0; i < 100; i++)
+    {
+        triangles.push_back(pool->spawn());
+    }
+
+    std::mt19937 generator(42); //fixed seed
+    std::uniform_real_distribution<double> importance(0, 100);
+
+    terra::CandidateList candidates;
+    std::vector<double> expected(triangles.size(), -1);
+    for(int round = 0; round < 1000; round++)
+    {
+        const size_t i = generator() % triangles.size();
+        if(generator() % 4 == 0)
+        {
+            candidates.remove(triangles[i]);
+            expected[i] = -1;
+        }
+        else
+        {
+            terra::Candidate c;
+            c.x = i;
+            c.importance = importance(generator);
+            c.triangle = triangles[i];
+            candidates.update(c);
+            expected[i] = c.importance;
+        }
+    }
+
+    const size_t live = std::count_if(
+        expected.begin(), expected.end(), [](const double e) { return e >= 0; });
+    CHECK(candidates.size() == live);
+
+    double previous = DBL_MAX;
+    while(!candidates.empty())
+    {
+        const terra::Candidate c = candidates.grab_greatest();
+        REQUIRE(c.importance <= previous);
+        CHECK(c.importance == expected[c.x]);
+        CHECK(c.triangle == triangles[c.x]);
+        expected[c.x] = -1;
+        previous = c.importance;
+    }
+    CHECK(std::count(expected.begin(), expected.end(), -1) == expected.size());
+}
+
+// largest difference between the raster points and the triangles covering them
+static double max_mesh_error(const Mesh& mesh, const RasterDouble& reference, int& covered_count)
+{
+    const int width = reference.get_width();
+    double worst = 0;
+    std::vector<char> covered(width * reference.get_height(), 0);
+    mesh.faces().for_each([&](const Face& f) {
+        glm::dvec3 p[3];
+        for(int i = 0; i < 3; i++)
+        {
+            const Vertex& v = mesh.vertices().begin[f[i]];
+            p[i] = glm::dvec3(reference.x2col(v.x), reference.y2row(v.y), v.z);
+        }
+        const double area = (p[1].x - p[0].x) * (p[2].y - p[0].y) -
+            (p[2].x - p[0].x) * (p[1].y - p[0].y);
+        const int min_x = std::min({p[0].x, p[1].x, p[2].x});
+        const int max_x = std::max({p[0].x, p[1].x, p[2].x});
+        const int min_y = std::min({p[0].y, p[1].y, p[2].y});
+        const int max_y = std::max({p[0].y, p[1].y, p[2].y});
+        for(int y = min_y; y <= max_y; y++)
+        {
+            for(int x = min_x; x <= max_x; x++)
+            {
+                const double a =
+                    ((p[1].x - x) * (p[2].y - y) - (p[2].x - x) * (p[1].y - y)) / area;
+                const double b =
+                    ((p[2].x - x) * (p[0].y - y) - (p[0].x - x) * (p[2].y - y)) / area;
+                const double c = 1 - a - b;
+                if(a < -1e-9 || b < -1e-9 || c < -1e-9)
+                {
+                    continue;
+                }
+                const double z = a * p[0].z + b * p[1].z + c * p[2].z;
+                worst = std::max(worst, std::abs(z - reference.value(y, x)));
+                covered[y * width + x] = 1;
+            }
+        }
+    });
+
+    covered_count = std::count(covered.begin(), covered.end(), 1);
+    return worst;
+}
+
+TEST_CASE("terra meshing stays within the error bound", "[tntn]")
+{
+    const int size = 128;
+    const double max_error = 0.5;
+
+    auto raster = std::make_unique<RasterDouble>();
+    raster->allocate(size, size);
+    raster->set_cell_size(1);
+    std::mt19937 generator(42); //fixed seed
+    std::normal_distribution<double> noise(0, 0.2);
+    for(int y = 0; y < size; y++)
+    {
+        for(int x = 0; x < size; x++)
+        {
+            const double z = 20 * sin(x * 0.05) * cos(y * 0.07) + 5 * sin(x * 0.3 + y * 0.2);
+            raster->value(y, x) = z + noise(generator);
+        }
+    }
+    const RasterDouble reference = raster->clone();
+
+    auto mesh = generate_tin_terra(std::move(raster), max_error);
+    REQUIRE(mesh != nullptr);
+
+    int covered = 0;
+    const double worst = max_mesh_error(*mesh, reference, covered);
+    CHECK(covered == size * size);
+    CHECK(worst < max_error);
+}
+
+TEST_CASE("terra meshing in blocks stitches the blocks within the error bound", "[tntn]")
+{
+    const int width = 150;
+    const int height = 131;
+    const double max_error = 0.5;
+
+    RasterDouble reference;
+    reference.allocate(width, height);
+    reference.set_cell_size(2);
+    reference.set_pos_x(500);
+    reference.set_pos_y(-300);
+    std::mt19937 generator(42); //fixed seed
+    std::normal_distribution<double> noise(0, 0.2);
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const double z = 20 * sin(x * 0.05) * cos(y * 0.07) + 5 * sin(x * 0.3 + y * 0.2);
+            reference.value(y, x) = z + noise(generator);
+        }
+    }
+
+    ThreadPool single_thread(1);
+    ThreadPool three_threads(3);
+    auto mesh = generate_tin_terra(
+        std::make_unique<RasterDouble>(reference.clone()), max_error, three_threads, 40);
+    auto serial = generate_tin_terra(
+        std::make_unique<RasterDouble>(reference.clone()), max_error, single_thread, 40);
+    REQUIRE(mesh != nullptr);
+    REQUIRE(serial != nullptr);
+
+    CHECK(mesh->check_tin_properties());
+    int covered = 0;
+    const double worst = max_mesh_error(*mesh, reference, covered);
+    CHECK(covered == width * height);
+    CHECK(worst < max_error);
+
+    // the blocks are merged in the same order however many threads mesh them
+    REQUIRE(mesh->vertices().distance() == serial->vertices().distance());
+    CHECK(std::equal(mesh->vertices().begin, mesh->vertices().end, serial->vertices().begin));
+}
+
+TEST_CASE("terra meshing in blocks with no data on block corners", "[tntn]")
+{
+    const int size = 61;
+
+    auto raster = std::make_unique<RasterDouble>();
+    raster->allocate(size, size);
+    raster->set_cell_size(1);
+    raster->set_no_data_value(-9999);
+    for(int y = 0; y < size; y++)
+    {
+        for(int x = 0; x < size; x++)
+        {
+            raster->value(y, x) = (x * 7 + y * 3) % 11;
+        }
+    }
+    // corners of the blocks of 21 pixels, in the middle and on the outer border
+    raster->value(20, 20) = -9999;
+    raster->value(40, 0) = -9999;
+    raster->value(0, 0) = -9999;
+
+    ThreadPool thread_pool(2);
+    auto mesh = generate_tin_terra(std::move(raster), 1.0, thread_pool, 21);
+    REQUIRE(mesh != nullptr);
+    CHECK(mesh->check_tin_properties());
+}
+
+TEST_CASE("single precision meshing matches double precision on float samples", "[tntn]")
+{
+    const int size = 96;
+
+    RasterFloat samples;
+    samples.allocate(size, size);
+    samples.set_cell_size(1);
+    std::mt19937 generator(42); //fixed seed
+    std::normal_distribution<float> noise(0, 0.2f);
+    for(int y = 0; y < size; y++)
+    {
+        for(int x = 0; x < size; x++)
+        {
+            samples.value(y, x) = 20 * sinf(x * 0.05f) * cosf(y * 0.07f) + noise(generator);
+        }
+    }
+
+    const RasterDouble reference = samples.convert<double>();
+
+    // errors are computed in double from the same samples, so terra picks the same points
+    auto terra_double =
+        generate_tin_terra(std::make_unique<RasterDouble>(reference.clone()), 0.5);
+    auto terra_float = generate_tin_terra(std::make_unique<RasterFloat>(samples.clone()), 0.5);
+    REQUIRE(terra_double != nullptr);
+    REQUIRE(terra_float != nullptr);
+    const auto vertices_double = terra_double->vertices();
+    const auto vertices_float = terra_float->vertices();
+    REQUIRE(vertices_float.distance() == vertices_double.distance());
+    CHECK(terra_float->faces().distance() == terra_double->faces().distance());
+    bool all_equal = true;
+    for(size_t i = 0; i < vertices_double.distance(); i++)
+    {
+        all_equal = all_equal && vertices_float.begin[i] == vertices_double.begin[i];
+    }
+    CHECK(all_equal);
+
+    // zemlya rounds its averaged samples to single precision
+    auto zemlya_float = generate_tin_zemlya(std::make_unique<RasterFloat>(samples.clone()), 0.5);
+    REQUIRE(zemlya_float != nullptr);
+    int covered = 0;
+    const double worst = max_mesh_error(*zemlya_float, reference, covered);
+    CHECK(covered == size * size);
+    CHECK(worst < 0.5 + 1e-4);
+}
+
+TEST_CASE("zemlya pyramid raster stores the points of each step", "[tntn]")
+{
+    CHECK(zemlya::PyramidRaster::step_of(0) == 0);
+    CHECK(zemlya::PyramidRaster::step_of(1) == 1);
+    CHECK(zemlya::PyramidRaster::step_of(6) == 2);
+    CHECK(zemlya::PyramidRaster::step_of(12) == 3);
+
+    zemlya::PyramidRaster pyramid;
+    pyramid.reset(10, 7);
+    pyramid.allocate_step(2);
+    CHECK(pyramid.has_step(2));
+    CHECK_FALSE(pyramid.has_step(1));
+
+    // points of step 2 are at 2 and 6 in both directions
+    int count = 0;
+    pyramid.for_each_point(2, [&](int y, int x, double& z) {
+        CHECK(std::isnan(z));
+        CHECK((y == 2 || y == 6));
+        CHECK((x == 2 || x == 6));
+        z = y * 10 + x;
+        count++;
+    });
+    CHECK(count == 4);
+
+    CHECK(pyramid.value(6, 2) == 62);
+    CHECK(pyramid.at(2, 2, 6) == 26);
+    CHECK(std::isnan(pyramid.value(6, 3)));
+    CHECK(std::isnan(pyramid.value(1, 1)));
+    CHECK(std::isnan(pyramid.value(10, 2)));
+
+    pyramid.release_step(2);
+    CHECK_FALSE(pyramid.has_step(2));
+    CHECK(std::isnan(pyramid.value(6, 2)));
+}
+
 TEST_CASE("terra meshing on artificial terrain", "[tntn]")
 {
     auto terrain_fn = [](int x, int y) -> double { return sin(x) * sin(y); };
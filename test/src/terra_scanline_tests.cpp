@@ -0,0 +1,264 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "tntn/terra_scanline.h"
+
+namespace tntn {
+namespace unittests {
+
+static std::vector<uint64_t> pack_bits(const std::vector<char>& flags)
+{
+    std::vector<uint64_t> words((flags.size() + 63) / 64, 0);
+    for(size_t i = 0; i < flags.size(); i++)
+    {
+        if(flags[i])
+        {
+            words[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+    return words;
+}
+
+// point by point scan with the plane evaluated per column as a * x + row_offset,
+// like the kernels do. first maximum wins
+static int reference_scan(const std::vector<double>& row,
+                          const std::vector<char>& used,
+                          const int startx,
+                          const int endx,
+                          const double a,
+                          const double row_offset,
+                          const double no_data_value,
+                          double& max_error)
+{
+    int best_x = -1;
+    double best_error = -1;
+    for(int x = startx; x <= endx; x++)
+    {
+        const double z = row[x];
+        if(used[x] || std::isnan(z) || z == no_data_value)
+        {
+            continue;
+        }
+        const double error = std::abs(z - (a * x + row_offset));
+        if(error > best_error)
+        {
+            best_error = error;
+            best_x = x;
+        }
+    }
+    max_error = best_error;
+    return best_x;
+}
+
+TEST_CASE("scan_row_max_error picks the same point as a plain scan", "[tntn]")
+{
+    const int width = 200;
+    const double no_data_value = -9999;
+
+    std::mt19937 generator(42); //fixed seed
+    // small integers and dyadic slopes keep all errors exact, so there are plenty of ties
+    std::uniform_int_distribution<int> height(-20, 20);
+    std::uniform_int_distribution<int> slope(-8, 8);
+    std::uniform_int_distribution<int> column(0, width - 1);
+    std::uniform_int_distribution<int> kind(0, 9);
+
+    std::vector<double> row(width);
+    std::vector<char> used(width);
+    for(int round = 0; round < 2000; round++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const int k = kind(generator);
+            row[x] = k == 0 ? NAN : k == 1 ? no_data_value : height(generator);
+            used[x] = k == 2 ? 1 : 0;
+        }
+
+        int startx = column(generator);
+        int endx = column(generator);
+        if(startx > endx)
+        {
+            std::swap(startx, endx);
+        }
+        const double a = slope(generator) / 4.0;
+        const double row_offset = height(generator) / 2.0;
+
+        double expected_error = 0;
+        const int expected_x = reference_scan(
+            row, used, startx, endx, a, row_offset, no_data_value, expected_error);
+
+        const std::vector<uint64_t> used_bits = pack_bits(used);
+        double error = 0;
+        const int x = terra::scan_row_max_error(
+            row.data(), used_bits.data(), startx, endx, a, row_offset, no_data_value, error);
+
+        REQUIRE(x == expected_x);
+        if(x >= 0)
+        {
+            CHECK(error == expected_error);
+        }
+    }
+}
+
+// the scan of Terra before the kernels: the plane is evaluated at startx like Plane::eval
+// does and then advanced by a per column, so its rounding errors add up along the row
+static int running_sum_scan(const std::vector<double>& row,
+                            const std::vector<char>& used,
+                            const int startx,
+                            const int endx,
+                            const double a,
+                            const double b,
+                            const double c,
+                            const int y,
+                            const double no_data_value)
+{
+    int best_x = -1;
+    double best_error = -1;
+    double z0 = a * startx + b * y + c;
+    for(int x = startx; x <= endx; x++)
+    {
+        const double z = row[x];
+        if(!used[x] && !std::isnan(z) && z != no_data_value)
+        {
+            const double error = std::abs(z - z0);
+            if(error > best_error)
+            {
+                best_error = error;
+                best_x = x;
+            }
+        }
+        z0 += a;
+    }
+    return best_x;
+}
+
+TEST_CASE("scan_row_max_error only differs from the old running sum on near ties", "[tntn]")
+{
+    const int width = 1000;
+    const double no_data_value = -9999;
+
+    std::mt19937 generator(42); //fixed seed
+    // heights in steps of 0.1 like many DEMs, planes with arbitrary slopes
+    std::uniform_int_distribution<int> height(-1000, 1000);
+    std::uniform_real_distribution<double> slope(-1, 1);
+    std::uniform_real_distribution<double> offset(-100, 100);
+    std::uniform_int_distribution<int> column(0, width - 1);
+    std::uniform_int_distribution<int> kind(0, 9);
+
+    std::vector<double> row(width);
+    std::vector<char> used(width);
+    int mismatches = 0;
+    const int rounds = 2000;
+    for(int round = 0; round < rounds; round++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const int k = kind(generator);
+            row[x] = k == 0 ? no_data_value : height(generator) / 10.0;
+            used[x] = k == 1 ? 1 : 0;
+        }
+
+        int startx = column(generator);
+        int endx = column(generator);
+        if(startx > endx)
+        {
+            std::swap(startx, endx);
+        }
+        const double a = slope(generator);
+        const double b = slope(generator);
+        const double c = offset(generator);
+        const int y = column(generator);
+
+        const int old_x =
+            running_sum_scan(row, used, startx, endx, a, b, c, y, no_data_value);
+        const std::vector<uint64_t> used_bits = pack_bits(used);
+        double error = 0;
+        const int x = terra::scan_row_max_error(
+            row.data(), used_bits.data(), startx, endx, a, b * y + c, no_data_value, error);
+
+        REQUIRE((x < 0) == (old_x < 0));
+        if(x == old_x)
+        {
+            continue;
+        }
+
+        // a different point is only picked if both errors are equal up to rounding
+        mismatches++;
+        auto exact_error = [&](int px) {
+            return std::abs(static_cast<long double>(row[px]) -
+                            (static_cast<long double>(a) * px + static_cast<long double>(b) * y +
+                             static_cast<long double>(c)));
+        };
+        CHECK(std::abs(exact_error(x) - exact_error(old_x)) < 1e-9);
+    }
+
+    // ties of heights in steps of 0.1 against arbitrary planes are rare
+    CHECK(mismatches < rounds / 100);
+}
+
+TEST_CASE("scan_row_max_error on float rows matches double rows", "[tntn]")
+{
+    const int width = 150;
+    const double no_data_value = -9999;
+
+    std::mt19937 generator(42); //fixed seed
+    std::uniform_real_distribution<float> height(-100, 100);
+    std::uniform_int_distribution<int> kind(0, 9);
+
+    std::vector<float> row_float(width);
+    std::vector<double> row_double(width);
+    std::vector<char> used(width);
+    for(int round = 0; round < 200; round++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const int k = kind(generator);
+            row_float[x] = k == 0 ? NAN : k == 1 ? no_data_value : height(generator);
+            row_double[x] = row_float[x];
+            used[x] = k == 2 ? 1 : 0;
+        }
+        const std::vector<uint64_t> used_bits = pack_bits(used);
+        const double a = 0.37 * (round % 7) - 1;
+        const double row_offset = 0.5 * (round % 5);
+
+        double error_double = 0;
+        double error_float = 0;
+        const int x_double = terra::scan_row_max_error(row_double.data(),
+                                                       used_bits.data(),
+                                                       round % 20,
+                                                       width - 1 - round % 13,
+                                                       a,
+                                                       row_offset,
+                                                       no_data_value,
+                                                       error_double);
+        const int x_float = terra::scan_row_max_error(row_float.data(),
+                                                      used_bits.data(),
+                                                      round % 20,
+                                                      width - 1 - round % 13,
+                                                      a,
+                                                      row_offset,
+                                                      no_data_value,
+                                                      error_float);
+
+        REQUIRE(x_float == x_double);
+        CHECK(error_float == error_double);
+    }
+}
+
+TEST_CASE("scan_row_max_error on spans without valid points", "[tntn]")
+{
+    const std::vector<double> row = {1, NAN, -9999, 4, 5, 6, 7, 8, 9, 10};
+    const std::vector<uint64_t> used = pack_bits({1, 0, 0, 1, 1, 1, 1, 1, 1, 0});
+
+    double error = 42;
+    CHECK(terra::scan_row_max_error(row.data(), used.data(), 0, 8, 0, 0, -9999, error) == -1);
+    CHECK(error == 42);
+    CHECK(terra::scan_row_max_error(row.data(), used.data(), 0, 9, 1, 0, -9999, error) == 9);
+    CHECK(error == 1);
+}
+
+} // namespace unittests
+} // namespace tntn
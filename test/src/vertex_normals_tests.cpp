@@ -0,0 +1,75 @@
+#include "catch.hpp"
+
+#include <cmath>
+
+#include "tntn/vertex_normals.h"
+#include "tntn/MercatorToEcef.h"
+
+namespace tntn {
+namespace unittests {
+
+// n x n grid on the plane z = slope * x, plus one vertex no face uses
+static void make_plane(const int n, const double slope, Mesh& mesh)
+{
+    std::vector<Vertex> vertices;
+    for(int y = 0; y < n; y++)
+    {
+        for(int x = 0; x < n; x++)
+        {
+            vertices.push_back({x * 10.0, y * 10.0, x * 10.0 * slope});
+        }
+    }
+    vertices.push_back({-100, -100, 0});
+
+    std::vector<Face> faces;
+    for(int y = 0; y + 1 < n; y++)
+    {
+        for(int x = 0; x + 1 < n; x++)
+        {
+            const size_t a = y * n + x;
+            faces.push_back({{a, a + 1, a + n + 1}});
+            faces.push_back({{a, a + n + 1, a + n}});
+        }
+    }
+    mesh.from_decomposed(std::move(vertices), std::move(faces));
+}
+
+TEST_CASE("compute_vertex_normals on a plane", "[tntn]")
+{
+    Mesh mesh;
+    make_plane(5, 0.5, mesh);
+
+    std::vector<Normal> normals;
+    compute_vertex_normals(mesh.vertices(), mesh.faces(), normals);
+    REQUIRE(normals.size() == mesh.vertices().distance());
+
+    const Normal expected = glm::normalize(Normal(-0.5, 0, 1));
+    for(size_t i = 0; i + 1 < normals.size(); i++)
+    {
+        const Normal n = glm::normalize(normals[i]);
+        CHECK(n.x == Approx(expected.x));
+        CHECK(n.y == Approx(expected.y).margin(1e-12));
+        CHECK(n.z == Approx(expected.z));
+    }
+    CHECK(normals.back() == Normal(0, 0, 0));
+}
+
+TEST_CASE("compute_ecef_vertex_normals of flat terrain point away from the earth", "[tntn]")
+{
+    Mesh mesh;
+    make_plane(5, 0.0, mesh);
+
+    std::vector<Normal> normals;
+    compute_ecef_vertex_normals(mesh, normals);
+    REQUIRE(normals.size() == mesh.vertices().distance());
+
+    // near lon = lat = 0 the ellipsoid normal is the x axis
+    for(const Normal& n : normals)
+    {
+        CHECK(glm::length(n) == Approx(1.0));
+        CHECK(n.x == Approx(1.0).margin(1e-4));
+    }
+}
+
+} // namespace unittests
+} // namespace tntn